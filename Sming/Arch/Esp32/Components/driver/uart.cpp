@@ -185,15 +185,15 @@ void IRAM_ATTR uart_isr(smg_uart_instance_t* inst)
 			// Read as much data as possible from the RX FIFO into buffer
 			if(uart->rx_buffer != nullptr) {
 				size_t avail = uart_ll_get_rxfifo_len(dev);
-				size_t space = uart->rx_buffer->getFreeSpace();
+				auto span = uart->rx_buffer->writeSpan();
+				size_t space = span.length();
 				read = (avail <= space) ? avail : space;
 				space -= read;
-				uint8_t buf[UART_RX_FIFO_SIZE];
-				uart_ll_read_rxfifo(dev, buf, read);
-				uint8_t* ptr = buf;
-				while(read-- != 0) {
-					uart->rx_buffer->writeChar(*ptr++);
-				}
+				// Transfer directly into buffer
+				size_t count = std::min(read, span.first.length);
+				uart_ll_read_rxfifo(dev, reinterpret_cast<uint8_t*>(span.first.data), count);
+				uart_ll_read_rxfifo(dev, reinterpret_cast<uint8_t*>(span.second.data), read - count);
+				uart->rx_buffer->commitWrite(read);
 
 				// Don't call back until buffer is (almost) full
 				if(space > uart->rx_headroom) {
@@ -217,13 +217,12 @@ void IRAM_ATTR uart_isr(smg_uart_instance_t* inst)
 			// Dump as much data as we can from buffer into the TX FIFO
 			if(uart->tx_buffer != nullptr) {
 				size_t space = uart_txfifo_free(dev);
-				size_t avail = uart->tx_buffer->available();
-				size_t count = std::min(avail, space);
-				uint8_t buf[count];
-				for(unsigned i = 0; i < count; ++i) {
-					buf[i] = uart->tx_buffer->readChar();
-				}
-				uart_ll_write_txfifo(dev, buf, count);
+				auto span = uart->tx_buffer->readSpan();
+				size_t count = std::min(span.first.length, space);
+				uart_ll_write_txfifo(dev, reinterpret_cast<const uint8_t*>(span.first.data), count);
+				size_t count2 = std::min(span.second.length, space - count);
+				uart_ll_write_txfifo(dev, reinterpret_cast<const uint8_t*>(span.second.data), count2);
+				uart->tx_buffer->skipRead(count + count2);
 			}
 
 			// If TX FIFO remains empty then we must disable TX FIFO EMPTY interrupt to stop it recurring.
@@ -301,8 +300,7 @@ size_t smg_uart_read(smg_uart_t* uart, void* buffer, size_t size)
 
 	// First read data from RX buffer if in use
 	if(uart->rx_buffer != nullptr) {
-		while(read < size && !uart->rx_buffer->isEmpty())
-			buf[read++] = uart->rx_buffer->readChar();
+		read += uart->rx_buffer->read(buf, size);
 	}
 
 	// Top up from hardware FIFO
@@ -418,9 +416,7 @@ size_t smg_uart_write(smg_uart_t* uart, const void* buffer, size_t size)
 
 		// Write any remaining data into transmit buffer
 		if(uart->tx_buffer != nullptr) {
-			while(written < size && uart->tx_buffer->writeChar(buf[written])) {
-				++written;
-			}
+			written += uart->tx_buffer->write(&buf[written], size - written);
 		}
 
 		notify(uart, UART_NOTIFY_AFTER_WRITE);
@@ -24,13 +24,16 @@ typedef void os_timer_func_t(void* timer_arg);
 
 /**
  * @brief This is the structure used by the Espressif timer API
- * @note This is used as an element in a linked list
- * The Espressif implementation orders the list according to next expiry time.
+ * @note The Espressif implementation uses this as an element in a linked list,
+ * ordered according to next expiry time.
+ * The Host implementation uses a hierarchical timing wheel instead, so arm and disarm
+ * take constant time. The structure layout is unchanged.
  * os_timer_setfn and os_timer_disarm set timer_next to -1
- * When expired, timer_next is 0
+ * As with the Espressif implementation, os_timer_setfn may be called on an uninitialised structure
+ * but must not be called on an armed timer: disarm it first.
  */
 struct os_timer_t {
-	/// If disarmed, set to -1, otherwise points to the next queued timer (or NULL if last in the list)
+	/// If disarmed, set to -1, otherwise refers to internal queue information
 	struct os_timer_t* timer_next;
 	/// Set to the next Timer2 count value when the timer will expire
 	uint32_t timer_expire;
@@ -66,6 +69,12 @@ void os_timer_done(os_timer_t* ptimer);
  */
 int host_service_timers();
 
+/**
+ * @brief Get time until next timer is due, with greater precision than `host_service_timers()`
+ * @retval int Microseconds until next timer due, 0 if already due, -1 if none
+ */
+int host_timer_due_us();
+
 #ifdef __cplusplus
 }
 #endif
@@ -3,33 +3,277 @@
 #include <driver/hw_timer.h>
 #include <muldiv.h>
 #include <cassert>
+#include <memory>
+#include <vector>
+
+/*
+ * Armed timers are held in a hierarchical timing wheel, giving constant-time arm and disarm
+ * regardless of how many timers are active.
+ *
+ * There are `levelCount` levels of `slotCount` slots. A timer is placed in the lowest level
+ * whose block contains both its expiry time and the current wheel time, so each slot
+ * at level N covers 64^N ticks. Level 0 slots hold timers due on that exact tick.
+ * When the wheel time enters a new block at level N, the corresponding slot is emptied
+ * and its timers re-inserted at lower levels (cascading).
+ *
+ * Per-level occupancy masks locate the next event without visiting empty slots,
+ * so idle periods are skipped in a single step.
+ *
+ * Each armed timer is linked via a `Node`, taken from an internal pool.
+ * While armed, `os_timer_t::timer_next` refers to this node so it can be removed directly.
+ */
 
 namespace
 {
-os_timer_t* timer_list;
-CMutex mutex;
+constexpr unsigned slotBits = 6;
+constexpr unsigned slotCount = 1U << slotBits;
+constexpr unsigned slotMask = slotCount - 1;
+constexpr unsigned levelCount = (32 + slotBits - 1) / slotBits;
+constexpr unsigned nodeChunkSize = 256;
+
+os_timer_t* const disarmed = reinterpret_cast<os_timer_t*>(-1);
 
-// Called with mutex locked
-void timer_insert(uint32_t expire, os_timer_t* ptimer)
+struct Node {
+	os_timer_t* timer;
+	Node* prev;
+	Node* next;
+	uint8_t level;
+	uint8_t slot;
+};
+
+class TimerWheel
 {
-	os_timer_t* t_prev = nullptr;
-	auto t = timer_list;
-	while(t != nullptr) {
-		if(int(t->timer_expire - expire) > 0) {
-			break;
+public:
+	bool isEmpty() const
+	{
+		return count == 0;
+	}
+
+	void insert(os_timer_t* ptimer, uint32_t expire);
+	void remove(os_timer_t* ptimer);
+
+	/*
+	 * Process cascades up to the given time, returning the next expired timer, if any.
+	 * The returned timer is unlinked and marked as disarmed.
+	 */
+	os_timer_t* pop(uint32_t now);
+
+	/*
+	 * Number of ticks until the wheel next needs servicing.
+	 * This may be a cascade rather than a timer expiry.
+	 */
+	uint32_t ticksToNextEvent(uint32_t now) const;
+
+	/*
+	 * Return true if ptimer is in the slot due for servicing next
+	 */
+	bool isFirst(const os_timer_t* ptimer) const;
+
+private:
+	static Node* getNode(const os_timer_t* ptimer)
+	{
+		return reinterpret_cast<Node*>(ptimer->timer_next);
+	}
+
+	static uint32_t slotTime(unsigned level, uint32_t time)
+	{
+		return time >> (level * slotBits);
+	}
+
+	Node* allocateNode();
+	void link(Node* node, uint32_t expire);
+	void unlink(Node* node);
+	uint32_t nextEventTime(unsigned& level, unsigned& slot) const;
+	void setTime(uint32_t time);
+
+	Node* slots[levelCount][slotCount]{};
+	uint64_t occupied[levelCount]{};
+	uint32_t wheelTime{0}; ///< Next tick to be processed
+	unsigned count{0};
+	Node* freeNodes{nullptr};
+	std::vector<std::unique_ptr<Node[]>> nodeChunks;
+};
+
+Node* TimerWheel::allocateNode()
+{
+	if(freeNodes == nullptr) {
+		auto chunk = new Node[nodeChunkSize];
+		nodeChunks.emplace_back(chunk);
+		for(unsigned i = 0; i < nodeChunkSize; ++i) {
+			chunk[i].next = freeNodes;
+			freeNodes = &chunk[i];
 		}
-		t_prev = t;
-		t = t->timer_next;
 	}
-	if(t_prev == nullptr) {
-		timer_list = ptimer;
-	} else {
-		t_prev->timer_next = ptimer;
+	auto node = freeNodes;
+	freeNodes = node->next;
+	return node;
+}
+
+void TimerWheel::link(Node* node, uint32_t expire)
+{
+	// Overdue timers go into the current slot
+	if(int(expire - wheelTime) < 0) {
+		expire = wheelTime;
 	}
-	ptimer->timer_next = t;
+
+	unsigned level = 0;
+	while(level < levelCount - 1 && slotTime(level + 1, expire) != slotTime(level + 1, wheelTime)) {
+		++level;
+	}
+	unsigned slot = slotTime(level, expire) & slotMask;
+
+	auto& head = slots[level][slot];
+	node->level = level;
+	node->slot = slot;
+	node->prev = nullptr;
+	node->next = head;
+	if(head != nullptr) {
+		head->prev = node;
+	}
+	head = node;
+	occupied[level] |= uint64_t(1) << slot;
+}
+
+void TimerWheel::unlink(Node* node)
+{
+	if(node->next != nullptr) {
+		node->next->prev = node->prev;
+	}
+	if(node->prev != nullptr) {
+		node->prev->next = node->next;
+		return;
+	}
+	auto& head = slots[node->level][node->slot];
+	head = node->next;
+	if(head == nullptr) {
+		occupied[node->level] &= ~(uint64_t(1) << node->slot);
+	}
+}
+
+void TimerWheel::insert(os_timer_t* ptimer, uint32_t expire)
+{
+	if(count == 0) {
+		wheelTime = hw_timer2_read();
+	}
+	auto node = allocateNode();
+	node->timer = ptimer;
+	ptimer->timer_next = reinterpret_cast<os_timer_t*>(node);
 	ptimer->timer_expire = expire;
+	link(node, expire);
+	++count;
+}
+
+void TimerWheel::remove(os_timer_t* ptimer)
+{
+	auto node = getNode(ptimer);
+	assert(node->timer == ptimer);
+	unlink(node);
+	node->next = freeNodes;
+	freeNodes = node;
+	ptimer->timer_next = disarmed;
+	--count;
+}
+
+/*
+ * Occupied slots always lie ahead of the wheel time, and events at a lower level
+ * always occur before those at a higher level, so only the first non-empty level need be checked.
+ */
+uint32_t TimerWheel::nextEventTime(unsigned& level, unsigned& slot) const
+{
+	for(level = 0; level < levelCount - 1; ++level) {
+		auto mask = occupied[level];
+		if(mask == 0) {
+			continue;
+		}
+		slot = __builtin_ctzll(mask);
+		unsigned shift = level * slotBits;
+		uint32_t blockMask = (uint32_t(1) << (shift + slotBits)) - 1;
+		return (wheelTime & ~blockMask) | (slot << shift);
+	}
+
+	// Top level wraps with the tick counter
+	unsigned shift = level * slotBits;
+	unsigned current = wheelTime >> shift;
+	unsigned topSlots = 1U << (32 - shift);
+	for(unsigned i = 1; i < topSlots; ++i) {
+		slot = (current + i) & (topSlots - 1);
+		if(occupied[level] & (uint64_t(1) << slot)) {
+			break;
+		}
+	}
+	return slot << shift;
+}
+
+void TimerWheel::setTime(uint32_t time)
+{
+	wheelTime = time;
+
+	// Cascade from the highest level down, so timers always move to a slot not yet processed
+	for(unsigned level = levelCount - 1; level > 0; --level) {
+		if(time & ((uint32_t(1) << (level * slotBits)) - 1)) {
+			continue;
+		}
+		unsigned slot = slotTime(level, time) & slotMask;
+		auto node = slots[level][slot];
+		if(node == nullptr) {
+			continue;
+		}
+		slots[level][slot] = nullptr;
+		occupied[level] &= ~(uint64_t(1) << slot);
+		while(node != nullptr) {
+			auto next = node->next;
+			link(node, node->timer->timer_expire);
+			node = next;
+		}
+	}
+}
+
+os_timer_t* TimerWheel::pop(uint32_t now)
+{
+	while(count != 0) {
+		unsigned level, slot;
+		auto time = nextEventTime(level, slot);
+		if(int(time - now) > 0) {
+			break;
+		}
+		setTime(time);
+		if(level != 0) {
+			continue;
+		}
+
+		// Timers in a level 0 slot are all due
+		auto ptimer = slots[0][slot]->timer;
+		remove(ptimer);
+		if(slots[0][slot] == nullptr) {
+			setTime(time + 1);
+		}
+		return ptimer;
+	}
+
+	if(count == 0 || int(now + 1 - wheelTime) > 0) {
+		setTime(now + 1);
+	}
+	return nullptr;
+}
+
+uint32_t TimerWheel::ticksToNextEvent(uint32_t now) const
+{
+	unsigned level, slot;
+	int ticks = nextEventTime(level, slot) - now;
+	return (ticks > 0) ? ticks : 0;
 }
 
+bool TimerWheel::isFirst(const os_timer_t* ptimer) const
+{
+	auto node = getNode(ptimer);
+	unsigned level, slot;
+	nextEventTime(level, slot);
+	return node->level == level && node->slot == slot;
+}
+
+TimerWheel wheel;
+CMutex mutex;
+
 } // namespace
 
 void os_timer_arm_ticks(os_timer_t* ptimer, uint32_t ticks, bool repeat_flag)
@@ -40,11 +284,12 @@ void os_timer_arm_ticks(os_timer_t* ptimer, uint32_t ticks, bool repeat_flag)
 	os_timer_disarm(ptimer);
 	ptimer->timer_period = repeat_flag ? ticks : 0;
 	mutex.lock();
-	timer_insert(hw_timer2_read() + ticks, ptimer);
+	wheel.insert(ptimer, hw_timer2_read() + ticks);
+	bool isFirst = wheel.isFirst(ptimer);
 	mutex.unlock();
 
 	// Kick main thread (which services timers) if we're due next
-	if(timer_list == ptimer) {
+	if(isFirst) {
 		host_thread_kick();
 	}
 }
@@ -67,36 +312,23 @@ void os_timer_disarm(struct os_timer_t* ptimer)
 {
 	assert(ptimer != nullptr);
 
-	if(int(ptimer->timer_next) == -1) {
+	// A zero-initialised timer has never been armed
+	if(ptimer->timer_next == disarmed || ptimer->timer_next == nullptr) {
 		return;
 	}
 
 	mutex.lock();
-	if(timer_list != nullptr) {
-		// Remove timer from list
-		if(ptimer == timer_list) {
-			timer_list = ptimer->timer_next;
-		} else {
-			auto t = timer_list;
-			while(t->timer_next != nullptr) {
-				if(t->timer_next == ptimer) {
-					t->timer_next = ptimer->timer_next;
-					break;
-				}
-				t = t->timer_next;
-			}
-		}
-		ptimer->timer_next = reinterpret_cast<os_timer_t*>(-1);
-	}
+	wheel.remove(ptimer);
 	mutex.unlock();
 }
 
 void os_timer_setfn(struct os_timer_t* ptimer, os_timer_func_t* pfunction, void* parg)
 {
+	// Timer must already be disarmed, so content is not inspected
 	if(ptimer != nullptr) {
 		ptimer->timer_func = pfunction;
 		ptimer->timer_arg = parg;
-		ptimer->timer_next = reinterpret_cast<os_timer_t*>(-1);
+		ptimer->timer_next = disarmed;
 	}
 }
 
@@ -105,31 +337,46 @@ void os_timer_done(struct os_timer_t* ptimer)
 	os_timer_disarm(ptimer);
 }
 
+int host_timer_due_us()
+{
+	mutex.lock();
+	int ticks = wheel.isEmpty() ? -1 : int(wheel.ticksToNextEvent(hw_timer2_read()));
+	mutex.unlock();
+
+	if(ticks <= 0) {
+		return ticks;
+	}
+
+	using R = std::ratio<1000000, HW_TIMER2_CLK>;
+	return muldiv<R::num, R::den>(unsigned(ticks));
+}
+
 int host_service_timers()
 {
-	if(timer_list == nullptr) {
+	if(wheel.isEmpty()) {
 		return -1;
 	}
 
 	auto ticks_now = hw_timer2_read();
-	auto t = timer_list;
-	int ticks = t->timer_expire - ticks_now;
-	if(ticks > 0) {
-		// Return milliseconds until timer due
-		using R = std::ratio<1000, HW_TIMER2_CLK>;
-		return muldiv<R::num, R::den>(unsigned(ticks));
-	}
-
 	mutex.lock();
-	// Pop timer from queue
-	timer_list = t->timer_next;
-	t->timer_next = reinterpret_cast<os_timer_t*>(-1);
+	auto t = wheel.pop(ticks_now);
 	// Repeating timer?
-	if(t->timer_period != 0) {
-		timer_insert(t->timer_expire + t->timer_period, t);
+	if(t != nullptr && t->timer_period != 0) {
+		wheel.insert(t, t->timer_expire + t->timer_period);
 	}
+	unsigned ticks = (t == nullptr && !wheel.isEmpty()) ? wheel.ticksToNextEvent(ticks_now) : 0;
+	bool empty = wheel.isEmpty();
 	mutex.unlock();
 
+	if(t == nullptr) {
+		if(empty) {
+			return -1;
+		}
+		// Return milliseconds until timer due
+		using R = std::ratio<1000, HW_TIMER2_CLK>;
+		return muldiv<R::num, R::den>(ticks);
+	}
+
 	if(t->timer_func != nullptr) {
 		t->timer_func(t->timer_arg);
 	}
@@ -127,8 +127,7 @@ size_t smg_uart_read(smg_uart_t* uart, void* buffer, size_t size)
 
 	// First read data from RX buffer if in use
 	if(uart->rx_buffer != nullptr) {
-		while(read < size && !uart->rx_buffer->isEmpty())
-			buf[read++] = uart->rx_buffer->readChar();
+		read += uart->rx_buffer->read(buf, size);
 	}
 
 	return read;
@@ -172,9 +171,7 @@ size_t smg_uart_write(smg_uart_t* uart, const void* buffer, size_t size)
 
 	while(written < size) {
 		if(uart->tx_buffer != nullptr) {
-			while(written < size && uart->tx_buffer->writeChar(buf[written])) {
-				++written;
-			}
+			written += uart->tx_buffer->write(&buf[written], size - written);
 		}
 
 		notify(uart, UART_NOTIFY_AFTER_WRITE);
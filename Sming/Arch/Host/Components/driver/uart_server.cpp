@@ -23,7 +23,9 @@
 #include <BitManipulations.h>
 #include <hostlib/keyb.h>
 #include <SerialLib.h>
+#include <hostlib/reactor.h>
 #include <cassert>
+#include <cerrno>
 
 namespace UartServer
 {
@@ -174,7 +176,7 @@ void startup(const Config& config)
 		} else {
 			server.reset(new CUartDevice(i, devname, config.baud[i]));
 		}
-		server->execute();
+		server->start();
 	}
 
 	// Redirect port 0 to console if not otherwise enabled
@@ -251,83 +253,254 @@ int CUart::serviceRead()
 	}
 
 	interrupt_begin();
+	int read = receive(avail);
+	interrupt_end();
 
-	int space = uart->rx_buffer->getFreeSpace();
+	return read;
+}
+
+int CUart::receive(int avail)
+{
+	auto rxbuf = uart->rx_buffer;
+	auto span = rxbuf->writeSpan();
+	int space = span.length();
 	if(space < avail) {
 		uart->status |= UART_RXFIFO_OVF_INT_ST;
 	}
-	int read = std::min(space, avail);
-	if(read != 0) {
-		char buffer[read];
-		read = readBytes(buffer, read);
-		if(read > 0) {
-			for(int i = 0; i < read; ++i) {
-				uart->rx_buffer->writeChar(buffer[i]);
-			}
-			space -= read;
-			if(space == 0) {
-				uart->status |= UART_RXFIFO_FULL_INT_ST;
-			} else {
-				uart->status |= UART_RXFIFO_TOUT_INT_ST;
-			}
-		}
+	avail = std::min(space, avail);
+	if(avail == 0) {
+		return 0;
 	}
 
-	interrupt_end();
+	// Read directly into buffer, second region is only used if data wraps around
+	int count = std::min(int(span.first.length), avail);
+	int read = readBytes(span.first.data, count);
+	if(read == count && read < avail) {
+		int n = readBytes(span.second.data, avail - read);
+		if(n > 0) {
+			read += n;
+		}
+	}
+	if(read > 0) {
+		rxbuf->commitWrite(read);
+		space -= read;
+		if(space == 0) {
+			uart->status |= UART_RXFIFO_FULL_INT_ST;
+		} else {
+			uart->status |= UART_RXFIFO_TOUT_INT_ST;
+		}
+	}
 
 	return read;
 }
 
 int CUart::serviceWrite()
 {
-	if(!smg_uart_tx_enabled(uart)) {
+	if(!smg_uart_tx_enabled(uart) || uart->tx_buffer->isEmpty()) {
 		return 0;
 	}
 
-	int result = 0;
-	void* data;
-	auto txbuf = uart->tx_buffer;
-	size_t avail = txbuf->getReadData(data);
-	if(avail == 0) {
-		return 0;
+	interrupt_begin();
+
+	int result = transmit();
+	if(result >= 0 && !uart->tx_buffer->isEmpty()) {
+		txsem.post();
 	}
 
-	interrupt_begin();
+	interrupt_end();
 
-	do {
+	return result;
+}
+
+int CUart::transmit()
+{
+	int result = 0;
+	void* data;
+	auto txbuf = uart->tx_buffer;
+	size_t avail;
+	while((avail = txbuf->getReadData(data)) != 0) {
 		int sent = writeBytes(data, avail);
 		if(sent < 0) {
 			host_debug_w("Uart send returned %d", sent);
-			result = sent;
+			return sent;
+		}
+		if(sent == 0) {
 			break;
 		}
 		txbuf->skipRead(sent);
 		result += sent;
-	} while((avail = txbuf->getReadData(data)) != 0);
+	}
 
 	if(txbuf->isEmpty()) {
 		uart->status |= UART_TXFIFO_EMPTY_INT_ST;
-	} else {
-		txsem.post();
 	}
 
-	interrupt_end();
-
 	return result;
 }
 
+void CUart::raiseInterrupt()
+{
+	if(uart == nullptr) {
+		return;
+	}
+
+	auto status = uart->status;
+	uart->status = 0;
+	if(status != 0 && uart->callback != nullptr) {
+		uart->callback(uart, status);
+	}
+}
+
 /* CUartPort */
 
 CUartPort::CUartPort(unsigned uart_nr) : CUart(uart_nr)
 {
 }
 
+bool CUartPort::start()
+{
+	auto port = portBase + uart_nr;
+	CSockAddr addr(nullptr, port);
+	if(!listen(addr, 1)) {
+		host_debug_e("Listen %s failed", addr.text().c_str());
+		return false;
+	}
+
+	host_debug_i("UART%u server listening on port %u", uart_nr, port);
+
+	// Service from main loop where possible, otherwise use a thread
+	reactor = host_reactor_add(m_fd, HOST_EVENT_READ, onListenEvent, this);
+	return reactor || execute();
+}
+
 void CUartPort::terminate()
 {
+	if(reactor) {
+		closeConnection();
+		host_reactor_remove(m_fd);
+		close();
+		host_debug_i("UART%u server destroyed", uart_nr);
+		return;
+	}
+
 	close();
 	CUart::terminate();
 }
 
+void CUartPort::onNotify(smg_uart_t* uart, smg_uart_notify_code_t code)
+{
+	if(!reactor) {
+		CUart::onNotify(uart, code);
+		return;
+	}
+
+	switch(code) {
+	case UART_NOTIFY_AFTER_OPEN:
+		this->uart = uart;
+		break;
+
+	case UART_NOTIFY_BEFORE_CLOSE:
+		this->uart = nullptr;
+		break;
+
+	case UART_NOTIFY_AFTER_WRITE:
+		if(this->uart == nullptr || socket == nullptr) {
+			// Not connected, discard data
+			uart->tx_buffer->clear();
+			break;
+		}
+		if(uart->tx_buffer->getFreeSpace() != 0) {
+			// Send when socket is ready, so several writes may be combined
+			host_reactor_modify(socket->fd(), HOST_EVENT_READ | HOST_EVENT_WRITE);
+			break;
+		}
+		// Buffer is full so caller may be waiting for space: we're on the main thread so must send now
+		// fall-through
+
+	case UART_NOTIFY_WAIT_TX:
+		while(socket != nullptr && !uart->tx_buffer->isEmpty()) {
+			if(transmit() < 0) {
+				closeConnection();
+				break;
+			}
+			if(!uart->tx_buffer->isEmpty()) {
+				socket->wait(IDLE_SLEEP_MS, SOCKET_WAIT_WRITE);
+			}
+		}
+		break;
+
+	case UART_NOTIFY_BEFORE_READ:
+		break;
+	}
+}
+
+void CUartPort::onListenEvent(void* param, unsigned)
+{
+	auto port = static_cast<CUartPort*>(param);
+	port->socket = port->try_connect();
+	if(port->socket == nullptr) {
+		return;
+	}
+
+	host_debug_i("Uart #%u socket open", port->uart_nr);
+
+	// Only one connection at a time, so stop listening until it's closed
+	host_reactor_modify(port->m_fd, 0);
+	unsigned events = HOST_EVENT_READ;
+	if(port->uart != nullptr && !port->uart->tx_buffer->isEmpty()) {
+		events |= HOST_EVENT_WRITE;
+	}
+	host_reactor_add(port->socket->fd(), events, onSocketEvent, port);
+}
+
+void CUartPort::onSocketEvent(void* param, unsigned events)
+{
+	auto port = static_cast<CUartPort*>(param);
+	auto uart = port->uart;
+
+	if(events & HOST_EVENT_WRITE) {
+		if(uart == nullptr || !smg_uart_tx_enabled(uart)) {
+			host_reactor_modify(port->socket->fd(), HOST_EVENT_READ);
+		} else if(port->transmit() < 0) {
+			port->closeConnection();
+			return;
+		} else if(uart->tx_buffer->isEmpty()) {
+			host_reactor_modify(port->socket->fd(), HOST_EVENT_READ);
+		}
+	}
+
+	if(events & (HOST_EVENT_READ | HOST_EVENT_ERROR)) {
+		int avail = port->available();
+		if(avail <= 0) {
+			// Readable with no data indicates connection closed
+			port->closeConnection();
+			return;
+		}
+		if(uart != nullptr && smg_uart_rx_enabled(uart)) {
+			port->receive(avail);
+		} else {
+			// Not open, discard data
+			char buffer[256];
+			port->readBytes(buffer, std::min(avail, int(sizeof(buffer))));
+		}
+	}
+
+	port->raiseInterrupt();
+}
+
+void CUartPort::closeConnection()
+{
+	if(socket == nullptr) {
+		return;
+	}
+
+	host_reactor_remove(socket->fd());
+	socket->close();
+	socket = nullptr;
+	host_reactor_modify(m_fd, HOST_EVENT_READ);
+	host_debug_i("Uart #%u socket closed", uart_nr);
+}
+
 int CUartPort::available()
 {
 	return socket ? socket->available() : 0;
@@ -340,20 +513,19 @@ int CUartPort::readBytes(void* buffer, size_t size)
 
 int CUartPort::writeBytes(const void* data, size_t size)
 {
-	return socket ? socket->send(data, size) : 0;
+	if(socket == nullptr) {
+		return 0;
+	}
+
+	int res = socket->send(data, size);
+	if(res < 0 && reactor && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+		return 0;
+	}
+	return res;
 }
 
 void* CUartPort::thread_routine()
 {
-	auto port = portBase + uart_nr;
-	CSockAddr addr(nullptr, port);
-	if(!listen(addr, 1)) {
-		host_debug_e("Listen %s failed", addr.text().c_str());
-		return nullptr;
-	}
-
-	host_debug_i("UART%u server listening on port %u", uart_nr, port);
-
 	while(active()) {
 		socket = try_connect();
 		if(socket == nullptr) {
@@ -376,13 +548,7 @@ void* CUartPort::thread_routine()
 
 			if(uart != nullptr) {
 				interrupt_begin();
-
-				auto status = uart->status;
-				uart->status = 0;
-				if(status != 0 && uart->callback != nullptr) {
-					uart->callback(uart, status);
-				}
-
+				raiseInterrupt();
 				interrupt_end();
 			}
 		}
@@ -476,13 +642,7 @@ void* CUartDevice::thread_routine()
 
 		if(uart != nullptr) {
 			interrupt_begin();
-
-			auto status = uart->status;
-			uart->status = 0;
-			if(status != 0 && uart->callback != nullptr) {
-				uart->callback(uart, status);
-			}
-
+			raiseInterrupt();
 			interrupt_end();
 		}
 	}
@@ -51,7 +51,7 @@ void shutdown();
 /*
  * Base class for a UART
  *
- * Each server allocates a thread to handle one device.
+ * Each server allocates a thread to handle one device, unless serviced by the main loop reactor.
  * If no client (i.e. application `uart`) is connected any output is discarded.
  *
  */
@@ -60,6 +60,14 @@ class CUart : public CThread
 public:
 	CUart(unsigned uart_nr);
 
+	/**
+	 * @brief Start servicing the port
+	 */
+	virtual bool start()
+	{
+		return execute();
+	}
+
 	virtual void terminate();
 
 	virtual void onNotify(smg_uart_t* uart, smg_uart_notify_code_t code);
@@ -73,6 +81,14 @@ protected:
 	int serviceRead();
 	int serviceWrite();
 
+	/*
+	 * These do the actual work and do not simulate interrupts,
+	 * so may be called directly from the main thread
+	 */
+	int receive(int avail);
+	int transmit();
+	void raiseInterrupt();
+
 	CSemaphore txsem;			///< Signals when there's data to be sent out
 	unsigned uart_nr;			///< Which port we represent
 	smg_uart_t* uart = nullptr; ///< On set if port is open by application
@@ -80,13 +96,17 @@ protected:
 
 /*
  * UART implementation using TCP socket for communication, so we can use telnet as a terminal application.
+ *
+ * Where supported, sockets are serviced by the main loop reactor instead of a separate thread.
  */
 class CUartPort : public CUart, public CServerSocket
 {
 public:
 	CUartPort(unsigned uart_nr);
 
+	bool start() override;
 	void terminate() override;
+	void onNotify(smg_uart_t* uart, smg_uart_notify_code_t code) override;
 
 protected:
 	int available() override;
@@ -95,6 +115,13 @@ protected:
 	void* thread_routine() override;
 
 	CSocket* socket{nullptr}; ///< Connected client
+
+private:
+	static void onListenEvent(void* param, unsigned events);
+	static void onSocketEvent(void* param, unsigned events);
+	void closeConnection();
+
+	bool reactor{false}; ///< true if serviced by main loop
 };
 
 /*
@@ -23,6 +23,17 @@ enum {
 
 typedef void (*os_task_t)(os_event_t* e);
 
+/**
+ * @brief Task queue statistics
+ */
+struct host_task_queue_stats {
+	uint32_t capacity;   ///< Maximum number of queued events
+	uint32_t count;		 ///< Events currently queued
+	uint32_t high_water; ///< Maximum events queued at any one time
+	uint32_t posted;	 ///< Events successfully posted
+	uint32_t dropped;	///< Posts rejected because queue was full
+};
+
 bool system_os_task(os_task_t task, uint8_t prio, os_event_t* queue, uint8_t qlen);
 bool system_os_post(uint8_t prio, os_signal_t sig, os_param_t par);
 
@@ -36,6 +47,14 @@ typedef void (*host_task_callback_t)(uint32_t param);
 
 bool host_queue_callback(host_task_callback_t callback, uint32_t param);
 
+/**
+ * @brief Get statistics for a task queue
+ * @param prio Priority, or USER_TASK_PRIO_MAX for the internal host queue
+ * @param stats
+ * @retval bool false if queue not initialised
+ */
+bool host_get_task_queue_stats(uint8_t prio, struct host_task_queue_stats* stats);
+
 #ifdef __cplusplus
 }
 #endif
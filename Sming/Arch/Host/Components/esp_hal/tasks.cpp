@@ -2,55 +2,135 @@
 #include <hostlib/hostmsg.h>
 #include <stringutil.h>
 #include <hostlib/threads.h>
+#include <atomic>
+#include <algorithm>
+
+/**
+ * @brief Minimum capacity for application task queues
+ *
+ * Host applications typically handle much more traffic than an embedded device,
+ * so queues are made larger than requested.
+ */
+#ifndef HOST_TASK_QUEUE_MIN_LENGTH
+#define HOST_TASK_QUEUE_MIN_LENGTH 256
+#endif
+
+/**
+ * @brief Capacity for internal host queue
+ */
+#ifndef HOST_TASK_QUEUE_LENGTH
+#define HOST_TASK_QUEUE_LENGTH 1024
+#endif
 
 namespace
 {
+/*
+ * Bounded lock-free multi-producer, single-consumer queue.
+ *
+ * Events may be posted from the main thread or from interrupt-emulation threads (hw_timer, UART, etc.)
+ * which can suspend the main thread at any point, so a lock cannot be used safely.
+ *
+ * Each slot carries a sequence number. A producer claims a slot by advancing `tail`,
+ * then publishes it by updating the sequence. The consumer only reads published slots.
+ */
 class TaskQueue
 {
 public:
-	TaskQueue(os_task_t callback, os_event_t* events, uint8_t length)
+	TaskQueue(os_task_t callback, unsigned length) : callback(callback)
 	{
-		this->callback = callback;
-		this->events = events;
-		this->length = length;
-		read = count = 0;
+		capacity = 1;
+		while(capacity < length) {
+			capacity <<= 1;
+		}
+		mask = capacity - 1;
+		slots = new Slot[capacity];
+		for(unsigned i = 0; i < capacity; ++i) {
+			slots[i].seq.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	~TaskQueue()
+	{
+		delete[] slots;
 	}
 
 	bool post(os_signal_t sig, os_param_t par)
 	{
-		mutex.lock();
-		bool full = (count == length);
-		if(!full) {
-			events[(read + count) % length] = os_event_t{sig, par};
-			++count;
+		uint32_t pos = tail.load(std::memory_order_relaxed);
+		Slot* slot;
+		for(;;) {
+			slot = &slots[pos & mask];
+			uint32_t seq = slot->seq.load(std::memory_order_acquire);
+			int32_t diff = int32_t(seq - pos);
+			if(diff == 0) {
+				if(tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					break;
+				}
+			} else if(diff < 0) {
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			} else {
+				pos = tail.load(std::memory_order_relaxed);
+			}
+		}
+
+		slot->event = os_event_t{sig, par};
+		slot->seq.store(pos + 1, std::memory_order_release);
+
+		posted.fetch_add(1, std::memory_order_relaxed);
+		uint32_t depth = pos + 1 - head.load(std::memory_order_relaxed);
+		uint32_t hw = highWater.load(std::memory_order_relaxed);
+		while(depth > hw && !highWater.compare_exchange_weak(hw, depth, std::memory_order_relaxed)) {
 		}
-		mutex.unlock();
-		return !full;
+
+		return true;
 	}
 
 	void process()
 	{
 		// Don't service any newly queued events
-		for(unsigned n = count; n != 0; --n) {
-			mutex.lock();
-			auto evt = events[read];
-			read = (read + 1) % length;
-			--count;
-			mutex.unlock();
+		uint32_t end = tail.load(std::memory_order_acquire);
+		uint32_t pos = head.load(std::memory_order_relaxed);
+		while(pos != end) {
+			auto& slot = slots[pos & mask];
+			if(slot.seq.load(std::memory_order_acquire) != pos + 1) {
+				// Producer has claimed slot but not yet written it, will be kicked when done
+				break;
+			}
+			auto evt = slot.event;
+			slot.seq.store(pos + capacity, std::memory_order_release);
+			++pos;
+			head.store(pos, std::memory_order_relaxed);
 			callback(&evt);
 		}
 	}
 
+	void getStats(host_task_queue_stats& stats) const
+	{
+		stats.capacity = capacity;
+		stats.count = tail.load(std::memory_order_relaxed) - head.load(std::memory_order_relaxed);
+		stats.high_water = highWater.load(std::memory_order_relaxed);
+		stats.posted = posted.load(std::memory_order_relaxed);
+		stats.dropped = dropped.load(std::memory_order_relaxed);
+	}
+
 private:
-	static CMutex mutex;
+	struct Slot {
+		std::atomic<uint32_t> seq;
+		os_event_t event;
+	};
+
 	os_task_t callback;
-	os_event_t* events;
-	uint8_t read;
-	uint8_t count;
-	uint8_t length;
+	Slot* slots;
+	uint32_t capacity;
+	uint32_t mask;
+	std::atomic<uint32_t> tail{0}; ///< Next slot to be claimed by a producer
+	std::atomic<uint32_t> head{0}; ///< Next slot to be read by consumer
+	std::atomic<uint32_t> highWater{0};
+	std::atomic<uint32_t> posted{0};
+	std::atomic<uint32_t> dropped{0};
 };
 
-CMutex TaskQueue::mutex;
 TaskQueue* task_queues[USER_TASK_PRIO_MAX + 1];
 
 const uint8_t HOST_TASK_PRIO = USER_TASK_PRIO_MAX;
@@ -59,6 +139,8 @@ const uint8_t HOST_TASK_PRIO = USER_TASK_PRIO_MAX;
 
 bool system_os_task(os_task_t callback, uint8_t prio, os_event_t* events, uint8_t qlen)
 {
+	(void)events; // Queue manages its own storage
+
 	if(prio >= USER_TASK_PRIO_MAX) {
 		host_debug_e("Invalid priority %u", prio);
 		return false;
@@ -69,7 +151,7 @@ bool system_os_task(os_task_t callback, uint8_t prio, os_event_t* events, uint8_
 		return false;
 	}
 
-	queue = new TaskQueue(callback, events, qlen);
+	queue = new TaskQueue(callback, std::max(unsigned(qlen), unsigned(HOST_TASK_QUEUE_MIN_LENGTH)));
 	return queue != nullptr;
 }
 
@@ -79,13 +161,13 @@ bool system_os_post(uint8_t prio, os_signal_t sig, os_param_t par)
 		host_debug_e("Invalid priority %u", prio);
 		return false;
 	}
-	auto& queue = task_queues[prio];
+	auto queue = task_queues[prio];
 	if(queue == nullptr) {
 		host_debug_e("Task queue %u not initialised", prio);
 		return false;
 	}
 
-	if(!task_queues[prio]->post(sig, par)) {
+	if(!queue->post(sig, par)) {
 		return false;
 	}
 
@@ -95,8 +177,6 @@ bool system_os_post(uint8_t prio, os_signal_t sig, os_param_t par)
 
 void host_init_tasks()
 {
-	static os_event_t events[32];
-
 	auto hostTaskCallback = [](os_event_t* event) {
 		auto callback = host_task_callback_t(event->sig);
 		if(callback != nullptr) {
@@ -104,7 +184,7 @@ void host_init_tasks()
 		}
 	};
 
-	task_queues[HOST_TASK_PRIO] = new TaskQueue(hostTaskCallback, events, ARRAY_SIZE(events));
+	task_queues[HOST_TASK_PRIO] = new TaskQueue(hostTaskCallback, HOST_TASK_QUEUE_LENGTH);
 }
 
 void host_service_tasks()
@@ -119,5 +199,24 @@ void host_service_tasks()
 
 bool host_queue_callback(host_task_callback_t callback, uint32_t param)
 {
-	return task_queues[HOST_TASK_PRIO]->post(os_signal_t(callback), param);
+	if(!task_queues[HOST_TASK_PRIO]->post(os_signal_t(callback), param)) {
+		return false;
+	}
+
+	host_thread_kick();
+	return true;
+}
+
+bool host_get_task_queue_stats(uint8_t prio, struct host_task_queue_stats* stats)
+{
+	if(prio > HOST_TASK_PRIO || stats == nullptr) {
+		return false;
+	}
+	auto queue = task_queues[prio];
+	if(queue == nullptr) {
+		return false;
+	}
+
+	queue->getStats(*stats);
+	return true;
 }
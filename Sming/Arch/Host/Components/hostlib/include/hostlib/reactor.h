@@ -0,0 +1,94 @@
+/****
+ * reactor.h - Event-driven wait for the Host main loop
+ *
+ * Copyright 2019 mikee47 <mike@sillyhouse.net>
+ *
+ * This file is part of the Sming Framework Project
+ *
+ * This library is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, version 3 or later.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with SHEM.
+ * If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * On Linux the main loop waits using epoll, so a single system call covers task queue kicks,
+ * the next timer deadline and any registered file descriptors (sockets, network interface, etc.)
+ *
+ * Callbacks are invoked from the main thread, between calls to `host_main_loop()`.
+ *
+ * On Windows these functions are not supported and return failure, so callers
+ * must fall back to polling or a separate thread.
+ */
+
+#define HOST_EVENT_READ 0x01  ///< Data available, or connection pending on a listening socket
+#define HOST_EVENT_WRITE 0x02 ///< Space available for writing
+#define HOST_EVENT_ERROR 0x04 ///< Error or hangup, always reported
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Callback invoked when a registered file descriptor is ready
+ * @param param As passed to `host_reactor_add()`
+ * @param events Combination of HOST_EVENT_xxx flags
+ */
+typedef void (*host_reactor_callback_t)(void* param, unsigned events);
+
+/**
+ * @brief Initialise the reactor. Called once at startup.
+ * @retval bool false if not supported
+ */
+bool host_reactor_init(void);
+
+void host_reactor_shutdown(void);
+
+/**
+ * @brief Watch a file descriptor
+ * @param fd
+ * @param events HOST_EVENT_READ and/or HOST_EVENT_WRITE
+ * @param callback
+ * @param param
+ * @retval bool true on success
+ */
+bool host_reactor_add(int fd, unsigned events, host_reactor_callback_t callback, void* param);
+
+/**
+ * @brief Change events for a file descriptor already being watched
+ */
+bool host_reactor_modify(int fd, unsigned events);
+
+/**
+ * @brief Stop watching a file descriptor
+ * @note Safe to call from within a callback
+ */
+void host_reactor_remove(int fd);
+
+/**
+ * @brief Wait for events and dispatch callbacks
+ * @param timeout_us Maximum time to wait in microseconds, 0 to poll, negative to wait indefinitely
+ * @retval int Number of callbacks invoked, negative on error
+ */
+int host_reactor_wait(int64_t timeout_us);
+
+/**
+ * @brief Interrupt a wait in progress, or cause the next one to return immediately
+ * @note May be called from any thread
+ */
+void host_reactor_kick(void);
+
+#ifdef __cplusplus
+}
+#endif
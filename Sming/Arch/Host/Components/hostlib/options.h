@@ -53,6 +53,10 @@
 	   nullptr)                                                                                                        \
 	XX(flashsize, required_argument, "Change default flash size if file doesn't exist", "SIZE",                        \
 	   "Size of flash in bytes (e.g. 512K, 524288, 0x80000)", nullptr)                                                 \
+	XX(flashsync, no_argument, "Flush flash backing file on every write or erase", nullptr, nullptr,                   \
+	   "Slower, but content survives an abnormal exit\0")                                                              \
+	XX(flashnor, no_argument, "Enforce NOR flash write semantics", nullptr, nullptr,                                   \
+	   "Writes can only clear bits, so sectors must be erased before re-writing\0")                                    \
 	XX(initonly, no_argument, "Initialise only, do not start Sming", nullptr, nullptr, nullptr)                        \
 	XX(loopcount, required_argument, "Run Sming loop a fixed number of times then exit", nullptr, nullptr,             \
 	   "Useful for running samples in CI\0")                                                                           \
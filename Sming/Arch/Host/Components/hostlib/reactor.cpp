@@ -0,0 +1,292 @@
+/**
+ * reactor.cpp
+ *
+ * Copyright 2019 mikee47 <mike@sillyhouse.net>
+ *
+ * This file is part of the Sming Framework Project
+ *
+ * This library is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, version 3 or later.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with SHEM.
+ * If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#include "include/hostlib/reactor.h"
+#include "include/hostlib/hostlib.h"
+#include "include/hostlib/hostmsg.h"
+
+#ifdef __WIN32
+
+bool host_reactor_init()
+{
+	return false;
+}
+
+void host_reactor_shutdown()
+{
+}
+
+bool host_reactor_add(int, unsigned, host_reactor_callback_t, void*)
+{
+	return false;
+}
+
+bool host_reactor_modify(int, unsigned)
+{
+	return false;
+}
+
+void host_reactor_remove(int)
+{
+}
+
+int host_reactor_wait(int64_t)
+{
+	return -1;
+}
+
+void host_reactor_kick()
+{
+}
+
+#else
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+struct Watch {
+	int fd;
+	host_reactor_callback_t callback;
+	void* param;
+};
+
+int epollFd{-1};
+int kickFd{-1};
+int timerFd{-1};
+bool timerArmed;
+std::vector<Watch*> watches;
+std::vector<Watch*> removed; ///< Released after dispatch completes
+
+// Markers for internal descriptors
+Watch kickWatch{};
+Watch timerWatch{};
+
+uint32_t getEpollEvents(unsigned events)
+{
+	uint32_t ev{0};
+	if(events & HOST_EVENT_READ) {
+		ev |= EPOLLIN;
+	}
+	if(events & HOST_EVENT_WRITE) {
+		ev |= EPOLLOUT;
+	}
+	return ev;
+}
+
+unsigned getHostEvents(uint32_t ev)
+{
+	unsigned events{0};
+	if(ev & EPOLLIN) {
+		events |= HOST_EVENT_READ;
+	}
+	if(ev & EPOLLOUT) {
+		events |= HOST_EVENT_WRITE;
+	}
+	if(ev & (EPOLLERR | EPOLLHUP)) {
+		events |= HOST_EVENT_ERROR;
+	}
+	return events;
+}
+
+Watch* findWatch(int fd)
+{
+	for(auto w : watches) {
+		if(w->fd == fd) {
+			return w;
+		}
+	}
+	return nullptr;
+}
+
+bool watch(int fd, uint32_t events, Watch* w)
+{
+	struct epoll_event ev {
+	};
+	ev.events = events;
+	ev.data.ptr = w;
+	return epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+void drain(int fd)
+{
+	uint64_t value;
+	while(read(fd, &value, sizeof(value)) == sizeof(value)) {
+	}
+}
+
+/*
+ * timerfd provides microsecond resolution, epoll_wait() only milliseconds
+ */
+void setTimer(int64_t timeout_us)
+{
+	if(timeout_us <= 0 && !timerArmed) {
+		return;
+	}
+	struct itimerspec its {
+	};
+	if(timeout_us > 0) {
+		its.it_value.tv_sec = timeout_us / 1000000;
+		its.it_value.tv_nsec = (timeout_us % 1000000) * 1000;
+	}
+	timerfd_settime(timerFd, 0, &its, nullptr);
+	timerArmed = (timeout_us > 0);
+}
+
+} // namespace
+
+bool host_reactor_init()
+{
+	if(epollFd >= 0) {
+		return true;
+	}
+
+	epollFd = epoll_create1(EPOLL_CLOEXEC);
+	kickFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if(epollFd < 0 || kickFd < 0 || timerFd < 0 || !watch(kickFd, EPOLLIN, &kickWatch) ||
+	   !watch(timerFd, EPOLLIN, &timerWatch)) {
+		host_debug_e("Reactor initialisation failed: %s", strerror(errno));
+		host_reactor_shutdown();
+		return false;
+	}
+
+	return true;
+}
+
+void host_reactor_shutdown()
+{
+	for(auto fd : {timerFd, kickFd, epollFd}) {
+		if(fd >= 0) {
+			close(fd);
+		}
+	}
+	epollFd = kickFd = timerFd = -1;
+	timerArmed = false;
+
+	for(auto w : watches) {
+		delete w;
+	}
+	watches.clear();
+	for(auto w : removed) {
+		delete w;
+	}
+	removed.clear();
+}
+
+bool host_reactor_add(int fd, unsigned events, host_reactor_callback_t callback, void* param)
+{
+	if(epollFd < 0 || fd < 0 || callback == nullptr || findWatch(fd) != nullptr) {
+		return false;
+	}
+
+	auto w = new Watch{fd, callback, param};
+	if(!watch(fd, getEpollEvents(events), w)) {
+		host_debug_e("Reactor add fd %d failed: %s", fd, strerror(errno));
+		delete w;
+		return false;
+	}
+
+	watches.push_back(w);
+	return true;
+}
+
+bool host_reactor_modify(int fd, unsigned events)
+{
+	auto w = findWatch(fd);
+	if(w == nullptr) {
+		return false;
+	}
+
+	struct epoll_event ev {
+	};
+	ev.events = getEpollEvents(events);
+	ev.data.ptr = w;
+	return epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+void host_reactor_remove(int fd)
+{
+	for(auto it = watches.begin(); it != watches.end(); ++it) {
+		auto w = *it;
+		if(w->fd != fd) {
+			continue;
+		}
+		epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+		// Events for this descriptor may still be pending dispatch
+		w->callback = nullptr;
+		removed.push_back(w);
+		watches.erase(it);
+		return;
+	}
+}
+
+int host_reactor_wait(int64_t timeout_us)
+{
+	if(epollFd < 0) {
+		return -1;
+	}
+
+	setTimer(timeout_us);
+	int timeout_ms = (timeout_us == 0) ? 0 : -1;
+
+	struct epoll_event events[32];
+	int count = epoll_wait(epollFd, events, ARRAY_SIZE(events), timeout_ms);
+	if(count < 0) {
+		return (errno == EINTR) ? 0 : -1;
+	}
+
+	int dispatched{0};
+	for(int i = 0; i < count; ++i) {
+		auto w = static_cast<Watch*>(events[i].data.ptr);
+		if(w == &kickWatch) {
+			drain(kickFd);
+		} else if(w == &timerWatch) {
+			drain(timerFd);
+			timerArmed = false;
+		} else if(w->callback != nullptr) {
+			w->callback(w->param, getHostEvents(events[i].events));
+			++dispatched;
+		}
+	}
+
+	for(auto w : removed) {
+		delete w;
+	}
+	removed.clear();
+
+	return dispatched;
+}
+
+void host_reactor_kick()
+{
+	if(kickFd >= 0) {
+		uint64_t value{1};
+		auto res = write(kickFd, &value, sizeof(value));
+		(void)res;
+	}
+}
+
+#endif
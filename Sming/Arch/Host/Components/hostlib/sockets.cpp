@@ -240,7 +240,8 @@ int CSocket::send(const void* data, size_t n, int flags)
 	while(n != 0) {
 		int ret = ::send(m_fd, static_cast<const char*>(data) + sent, n, flags);
 		if(ret < 0) {
-			return ret;
+			// Report partial write, e.g. non-blocking socket is full
+			return (sent != 0) ? sent : ret;
 		}
 		sent += ret;
 		if(size_t(ret) > n) {
@@ -36,9 +36,15 @@
 #include "include/hostlib/emu.h"
 #include "include/hostlib/hostlib.h"
 #include "include/hostlib/CommandLine.h"
+#include "include/hostlib/reactor.h"
 #include <Storage.h>
 #include <Platform/System.h>
 
+#if ENABLE_STORAGE_WEAR_STATS
+#include <Storage/SpiFlash.h>
+#include <Data/Stream/HostFileStream.h>
+#endif
+
 #ifndef DISABLE_NETWORK
 #include <host_lwip.h>
 #endif
@@ -48,15 +54,47 @@ namespace
 static int exitCode;
 static bool done;
 
+#if ENABLE_STORAGE_WEAR_STATS
+String wearFileName;
+
+/*
+ * Flash wear statistics are kept in a file alongside the flash backing file
+ */
+void loadWearStats(const char* flashFileName)
+{
+	wearFileName = flashFileName;
+	wearFileName += F(".wear");
+	HostFileStream stream;
+	if(stream.open(wearFileName) && !Storage::spiFlash->loadWearStats(stream)) {
+		host_debug_w("Ignoring invalid wear statistics in \"%s\"", wearFileName.c_str());
+	}
+}
+
+void saveWearStats()
+{
+	if(!wearFileName || Storage::spiFlash == nullptr) {
+		return;
+	}
+	HostFileStream stream(wearFileName, IFS::File::CreateNewAlways | IFS::File::WriteOnly);
+	if(!stream.isValid() || !Storage::spiFlash->saveWearStats(stream)) {
+		host_debug_e("Failed to write \"%s\"", wearFileName.c_str());
+	}
+}
+#endif
+
 void cleanup()
 {
 	hw_timer_cleanup();
+#if ENABLE_STORAGE_WEAR_STATS
+	saveWearStats();
+#endif
 	host_flashmem_cleanup();
 	UartServer::shutdown();
 	sockets_finalise();
 #ifndef DISABLE_NETWORK
 	host_lwip_shutdown();
 #endif
+	host_reactor_shutdown();
 	host_debug_i("Goodbye!");
 }
 
@@ -219,6 +257,14 @@ int main(int argc, char* argv[])
 			config.flash.createSize = parse_flash_size(arg);
 			break;
 
+		case opt_flashsync:
+			config.flash.syncWrites = true;
+			break;
+
+		case opt_flashnor:
+			config.flash.enforceNor = true;
+			break;
+
 		case opt_initonly:
 			config.initonly = true;
 			break;
@@ -261,6 +307,9 @@ int main(int argc, char* argv[])
 		host_debug_i("Initialise-only requested");
 	} else {
 		Storage::initialize();
+#if ENABLE_STORAGE_WEAR_STATS
+		loadWearStats(config.flash.filename);
+#endif
 
 		CThread::startup(config.cpulimit);
 
@@ -18,6 +18,8 @@
  ****/
 
 #include "threads.h"
+#include "include/hostlib/reactor.h"
+#include <driver/os_timer.h>
 #include <cstring>
 #include <cstdarg>
 #include <signal.h>
@@ -43,6 +45,7 @@ HANDLE host_thread_semaphore;
 #else
 
 CSemaphore host_thread_semaphore;
+bool reactorActive;
 volatile bool mainThreadSignalled;
 timer_t signalTimer;
 int pauseSignal;
@@ -171,6 +174,7 @@ void CThread::startup(unsigned cpulimit)
 	signal(resumeSignal, signal_handler);
 	signal(SIGALRM, signal_handler);
 	timer_create(CLOCK_MONOTONIC, nullptr, &signalTimer);
+	reactorActive = host_reactor_init();
 #endif
 }
 
@@ -235,6 +239,14 @@ void CThread::interrupt_end()
 
 void host_thread_wait(int ms)
 {
+#ifndef __WIN32
+	if(reactorActive) {
+		// Millisecond resolution is too coarse, so wait for the exact timer deadline
+		host_reactor_wait((ms < 0) ? -1 : host_timer_due_us());
+		return;
+	}
+#endif
+
 	constexpr int SCHED_WAIT{2};
 	if(ms >= 0 && ms <= SCHED_WAIT) {
 		return;
@@ -255,6 +267,10 @@ void host_thread_kick()
 #ifdef __WIN32
 	ReleaseSemaphore(host_thread_semaphore, 1, nullptr);
 #else
-	host_thread_semaphore.post();
+	if(reactorActive) {
+		host_reactor_kick();
+	} else {
+		host_thread_semaphore.post();
+	}
 #endif
 }
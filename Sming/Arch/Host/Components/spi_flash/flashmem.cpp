@@ -20,9 +20,18 @@
 #include <hostlib/hostlib.h>
 #include "flashmem.h"
 #include <string.h>
+#include <errno.h>
 #include <esp_spi_flash.h>
 #include <IFS/File.h>
 #include <hostlib/hostmsg.h>
+#include <algorithm>
+#include <memory>
+
+#ifndef __WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace
 {
@@ -30,6 +39,16 @@ IFS::File flashFile(&IFS::Host::getFileSystem());
 size_t flashFileSize{0x400000U};
 char flashFileName[256];
 const char defaultFlashFileName[]{"flash.bin"};
+bool syncWrites;
+bool enforceNor;
+FlashmemConfig activeConfig;
+
+#ifndef __WIN32
+// Backing file is mapped into memory where possible so reads don't require system calls
+int flashFd{-1};
+uint8_t* flashMap{nullptr};
+size_t pageSize;
+#endif
 
 // Top bit of flash address is set to indicate it's actually program memory
 constexpr uint32_t FLASHMEM_REAL_BIT{0x80000000U};
@@ -45,6 +64,49 @@ constexpr uint32_t FLASHMEM_REAL_MASK{~FLASHMEM_REAL_BIT};
 		return false;                                                                                                  \
 	}
 
+/*
+ * Map backing file into memory, falling back to file I/O if this isn't possible
+ */
+static void mapFlashFile()
+{
+#ifndef __WIN32
+	flashFd = open(flashFileName, O_RDWR);
+	if(flashFd < 0) {
+		host_debug_w("Error opening \"%s\" for mapping: %s", flashFileName, strerror(errno));
+		return;
+	}
+	void* map = mmap(nullptr, flashFileSize, PROT_READ | PROT_WRITE, MAP_SHARED, flashFd, 0);
+	if(map == MAP_FAILED) {
+		host_debug_w("Error mapping \"%s\": %s", flashFileName, strerror(errno));
+		close(flashFd);
+		flashFd = -1;
+		return;
+	}
+	flashMap = static_cast<uint8_t*>(map);
+	pageSize = sysconf(_SC_PAGESIZE);
+	flashFile.close();
+	host_debug_i("Mapped \"%s\"", flashFileName);
+#endif
+}
+
+/*
+ * Erased NOR flash reads as 0xFF, so fill a new backing file with that instead of leaving it sparse
+ */
+static int fillFlashFile(size_t size)
+{
+	uint8_t buffer[INTERNAL_FLASH_SECTOR_SIZE];
+	memset(buffer, 0xFF, sizeof(buffer));
+	size_t pos{0};
+	while(pos < size) {
+		int res = flashFile.write(buffer, std::min(sizeof(buffer), size - pos));
+		if(res <= 0) {
+			return res;
+		}
+		pos += res;
+	}
+	return pos;
+}
+
 bool host_flashmem_init(FlashmemConfig& config)
 {
 	if(config.filename != nullptr) {
@@ -73,9 +135,9 @@ bool host_flashmem_init(FlashmemConfig& config)
 
 	if(res == 0) {
 		size_t size = config.createSize ?: flashFileSize;
-		res = flashFile.seek(size, SeekOrigin::Start);
+		res = config.enforceNor ? fillFlashFile(size) : flashFile.seek(size, SeekOrigin::Start);
 		if(res != int(size)) {
-			host_debug_e("Error seeking beyond end of file \"%s\"", flashFileName);
+			host_debug_e("Error extending \"%s\" to %u bytes", flashFileName, size);
 		} else if(!flashFile.truncate(size)) {
 			host_debug_e("Error truncating \"%s\" to %u bytes", flashFileName, size);
 		} else {
@@ -87,18 +149,75 @@ bool host_flashmem_init(FlashmemConfig& config)
 
 	flashFileSize = res;
 	config.createSize = flashFileSize;
+	syncWrites = config.syncWrites;
+	enforceNor = config.enforceNor;
+	activeConfig = config;
+	activeConfig.filename = flashFileName;
+
+	mapFlashFile();
 
 	return true;
 }
 
+const FlashmemConfig& host_flashmem_get_config()
+{
+	return activeConfig;
+}
+
 void host_flashmem_cleanup()
 {
+#ifndef __WIN32
+	if(flashMap != nullptr) {
+		msync(flashMap, flashFileSize, MS_SYNC);
+		munmap(flashMap, flashFileSize);
+		flashMap = nullptr;
+		close(flashFd);
+		flashFd = -1;
+	}
+#endif
 	flashFile.close();
 	host_debug_i("Closed \"%s\"", flashFileName);
 }
 
+#ifndef __WIN32
+/*
+ * Flush modified pages to the backing file, if requested
+ */
+static void syncFlashMap(uint32_t offset, size_t count)
+{
+	if(!syncWrites) {
+		return;
+	}
+	auto start = offset & ~(pageSize - 1);
+	if(msync(&flashMap[start], offset + count - start, MS_SYNC) < 0) {
+		host_debug_w("msync(0x%08x, %u) failed: %s", offset, count, strerror(errno));
+	}
+}
+#endif
+
+/*
+ * Programming NOR flash can only clear bits, so apply this to existing content
+ */
+static void programBytes(uint8_t* dst, const uint8_t* src, size_t count, uint32_t offset)
+{
+	bool warned{false};
+	for(size_t i = 0; i < count; ++i) {
+		if(!warned && (src[i] & ~dst[i] & 0xFF) != 0) {
+			host_debug_w("Write to 0x%08x sets bits in unerased flash", offset + i);
+			warned = true;
+		}
+		dst[i] &= src[i];
+	}
+}
+
 static int readFlashFile(uint32_t offset, void* buffer, size_t count)
 {
+#ifndef __WIN32
+	if(flashMap != nullptr) {
+		memcpy(buffer, &flashMap[offset], count);
+		return count;
+	}
+#endif
 	if(!flashFile) {
 		return -1;
 	}
@@ -114,6 +233,13 @@ static int readFlashFile(uint32_t offset, void* buffer, size_t count)
 
 static int writeFlashFile(uint32_t offset, const void* data, size_t count)
 {
+#ifndef __WIN32
+	if(flashMap != nullptr) {
+		memcpy(&flashMap[offset], data, count);
+		syncFlashMap(offset, count);
+		return count;
+	}
+#endif
 	if(!flashFile) {
 		return -1;
 	}
@@ -127,6 +253,29 @@ static int writeFlashFile(uint32_t offset, const void* data, size_t count)
 	return res;
 }
 
+static int programFlashFile(uint32_t offset, const void* data, size_t count)
+{
+	if(!enforceNor) {
+		return writeFlashFile(offset, data, count);
+	}
+
+	auto src = static_cast<const uint8_t*>(data);
+#ifndef __WIN32
+	if(flashMap != nullptr) {
+		programBytes(&flashMap[offset], src, count, offset);
+		syncFlashMap(offset, count);
+		return count;
+	}
+#endif
+	std::unique_ptr<uint8_t[]> buffer(new uint8_t[count]);
+	int res = readFlashFile(offset, buffer.get(), count);
+	if(res != int(count)) {
+		return -1;
+	}
+	programBytes(buffer.get(), src, count, offset);
+	return writeFlashFile(offset, buffer.get(), count);
+}
+
 SPIFlashInfo flashmem_get_info()
 {
 	SPIFlashInfo info{};
@@ -193,7 +342,7 @@ uint32_t flashmem_read_internal(void* to, uint32_t fromaddr, uint32_t size)
 uint32_t flashmem_write(const void* from, uint32_t toaddr, uint32_t size)
 {
 	CHECK_RANGE(toaddr, size);
-	int res = writeFlashFile(toaddr, from, size);
+	int res = programFlashFile(toaddr, from, size);
 	return (res < 0) ? 0 : res;
 }
 
@@ -217,6 +366,13 @@ bool flashmem_erase_sector(uint32_t sector_id)
 {
 	uint32_t addr = sector_id * INTERNAL_FLASH_SECTOR_SIZE;
 	CHECK_RANGE(addr, INTERNAL_FLASH_SECTOR_SIZE);
+#ifndef __WIN32
+	if(flashMap != nullptr) {
+		memset(&flashMap[addr], 0xFF, INTERNAL_FLASH_SECTOR_SIZE);
+		syncFlashMap(addr, INTERNAL_FLASH_SECTOR_SIZE);
+		return true;
+	}
+#endif
 	uint8_t tmp[INTERNAL_FLASH_SECTOR_SIZE];
 	memset(tmp, 0xFF, sizeof(tmp));
 	return writeFlashFile(addr, tmp, sizeof(tmp)) == sizeof(tmp);
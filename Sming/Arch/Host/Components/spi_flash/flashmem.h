@@ -24,6 +24,8 @@
 struct FlashmemConfig {
 	const char* filename; ///< Path to flash backing file
 	size_t createSize;	///< If file doesn't exist, created with this size
+	bool syncWrites;	///< Flush backing file after every write or erase
+	bool enforceNor;	///< Writes can only clear bits, as for real flash
 };
 
 /**
@@ -38,3 +40,8 @@ struct FlashmemConfig {
 bool host_flashmem_init(FlashmemConfig& config);
 
 void host_flashmem_cleanup();
+
+/**
+ * @brief Get the configuration of the open backing file
+ */
+const FlashmemConfig& host_flashmem_get_config();
@@ -35,7 +35,7 @@ constexpr int COMMAND_NOT_FOUND = -1;
 class Client
 {
 public:
-	using RemoteCommands = HashMap<String, uint8_t>;
+	using RemoteCommands = HashMap<String, uint8_t, MapIndex::Hashed>;
 
 	Client(Stream& stream, char methodEndsWith = ':') : stream(stream), methodEndsWith(methodEndsWith)
 	{
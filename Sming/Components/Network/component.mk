@@ -50,6 +50,10 @@ COMPONENT_VARS			+= HTTP_SERVER_EXPOSE_VERSION
 HTTP_SERVER_EXPOSE_VERSION ?= 0
 GLOBAL_CFLAGS			+= -DHTTP_SERVER_EXPOSE_VERSION=$(HTTP_SERVER_EXPOSE_VERSION)
 
+COMPONENT_VARS			+= HTTP_REQUEST_ARENA_SIZE
+HTTP_REQUEST_ARENA_SIZE ?= 512
+GLOBAL_CFLAGS			+= -DHTTP_REQUEST_ARENA_SIZE=$(HTTP_REQUEST_ARENA_SIZE)
+
 # => LWIP
 COMPONENT_VARS			+= ENABLE_CUSTOM_LWIP
 ifeq ($(SMING_ARCH),Esp8266)
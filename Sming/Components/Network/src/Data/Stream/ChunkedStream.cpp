@@ -37,3 +37,128 @@ size_t ChunkedStream::transform(const uint8_t* source, size_t sourceLength, uint
 
 	return offset;
 }
+
+/*
+ * Prepare the next chunk from source data, if not already done.
+ * Once prepared, the chunk is fixed until seek() consumes it, even if more source data arrives.
+ * This ensures repeated peeks and the subsequent read all see identical content.
+ */
+bool ChunkedStream::startChunk()
+{
+	if(headerLength != 0) {
+		return true;
+	}
+
+	auto source = getSourceStream();
+	if(done || source == nullptr || isOutputPending()) {
+		return false;
+	}
+
+	const char* data;
+	size_t available = source->peekMemoryBlock(0, data);
+	if(available != 0) {
+		dataLength = std::min(available, size_t(0xffff));
+		headerLength = m_snprintf(header, sizeof(header), "%X\r\n", dataLength);
+	} else if(source->isFinished() && !transformed) {
+		dataLength = 0;
+		memcpy(header, _F("0\r\n\r\n"), 5);
+		headerLength = 5;
+	} else {
+		return false;
+	}
+
+	chunkPos = 0;
+	return true;
+}
+
+uint16_t ChunkedStream::readMemoryBlock(char* data, int bufSize)
+{
+	if(!startChunk()) {
+		transformed = true;
+		return StreamTransformer::readMemoryBlock(data, bufSize);
+	}
+
+	size_t count = 0;
+	while(count < size_t(bufSize)) {
+		const char* block;
+		size_t len = peekMemoryBlock(count, block);
+		if(len == 0) {
+			break;
+		}
+		len = std::min(len, bufSize - count);
+		memcpy(data + count, block, len);
+		count += len;
+	}
+
+	return count;
+}
+
+size_t ChunkedStream::peekMemoryBlock(size_t offset, const char*& data)
+{
+	if(!startChunk()) {
+		return 0;
+	}
+
+	size_t pos = chunkPos + offset;
+	if(pos < headerLength) {
+		data = header + pos;
+		return headerLength - pos;
+	}
+
+	pos -= headerLength;
+	if(pos < dataLength) {
+		size_t len = getSourceStream()->peekMemoryBlock(pos, data);
+		return std::min(len, dataLength - pos);
+	}
+
+	if(dataLength == 0) {
+		return 0;
+	}
+
+	pos -= dataLength;
+	if(pos < 2) {
+		data = &"\r\n"[pos];
+		return 2 - pos;
+	}
+
+	return 0;
+}
+
+bool ChunkedStream::seek(int len)
+{
+	if(headerLength == 0) {
+		return transformed && StreamTransformer::seek(len);
+	}
+
+	size_t newPos = chunkPos + len;
+	size_t size = chunkSize();
+	if(len < 0 || newPos > size) {
+		return false;
+	}
+
+	chunkPos = newPos;
+	if(chunkPos == size) {
+		// Source content is only consumed once its chunk has been read completely
+		if(dataLength == 0) {
+			done = true;
+		} else {
+			getSourceStream()->seek(dataLength);
+		}
+		headerLength = 0;
+	}
+
+	return true;
+}
+
+bool ChunkedStream::isFinished()
+{
+	if(headerLength != 0) {
+		return false;
+	}
+
+	if(done) {
+		return true;
+	}
+
+	return transformed && StreamTransformer::isFinished();
+}
@@ -26,6 +26,33 @@ class ChunkedStream : public StreamTransformer
 public:
 	ChunkedStream(IDataSourceStream* stream, size_t resultSize = 512);
 
+	uint16_t readMemoryBlock(char* data, int bufSize) override;
+
+	/**
+	 * @brief Where the source stream supports direct access, chunks are presented
+	 * as separate header, content and footer blocks without copying
+	 */
+	size_t peekMemoryBlock(size_t offset, const char*& data) override;
+
+	bool seek(int len) override;
+
+	bool isFinished() override;
+
 protected:
 	size_t transform(const uint8_t* source, size_t sourceLength, uint8_t* target, size_t targetLength) override;
+
+private:
+	bool startChunk();
+
+	size_t chunkSize() const
+	{
+		return headerLength + dataLength + (dataLength ? 2 : 0);
+	}
+
+	char header[8];			///< Chunk size line, or terminating chunk
+	uint32_t chunkPos{0};	///< Read position within current chunk
+	uint16_t dataLength{0}; ///< Source bytes in current chunk
+	uint8_t headerLength{0}; ///< Non-zero whilst a direct chunk is active
+	bool transformed{false}; ///< Set once the transform path has been used
+	bool done{false};		 ///< Terminating chunk has been read
 };
@@ -0,0 +1,84 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MultipartRangeStream.cpp
+ *
+ ****/
+
+#include "MultipartRangeStream.h"
+#include <Data/Stream/MemoryDataStream.h>
+#include <Data/Stream/RangeStream.h>
+#include <Network/Http/HttpHeaderFields.h>
+#include <esp_system.h>
+
+DEFINE_FSTR_LOCAL(boundaryChars, "0123456789"
+								 "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+								 "abcdefghijklmnopqrstuvwxyz");
+
+MultipartRangeStream::MultipartRangeStream(IDataSourceStream* source, size_t offset, const HttpRangeList& ranges,
+										   size_t contentLength, const String& contentType)
+	: source(source), offset(offset), ranges(ranges), contentLength(contentLength), contentType(contentType)
+{
+	for(unsigned i = 0; i < sizeof(boundary) - 1; ++i) {
+		boundary[i] = boundaryChars[os_random() % boundaryChars.length()];
+	}
+
+	// Headers are small so cheaper to generate twice than to store
+	totalLength = ranges.getTotalLength();
+	for(unsigned i = 0; i <= ranges.count(); ++i) {
+		totalLength += getPartHeader(i).length();
+	}
+}
+
+String MultipartRangeStream::getPartHeader(unsigned index) const
+{
+	String s;
+	s += "\r\n--";
+	s += boundary;
+	if(index == ranges.count()) {
+		s += "--\r\n";
+		return s;
+	}
+	s += "\r\n";
+	HttpHeaderFields fields;
+	if(contentType) {
+		s += fields.toString(HTTP_HEADER_CONTENT_TYPE, contentType);
+	}
+	s += fields.toString(HTTP_HEADER_CONTENT_RANGE, HttpRangeList::getContentRange(ranges[index], contentLength));
+	s += "\r\n";
+	return s;
+}
+
+IDataSourceStream* MultipartRangeStream::getNextStream()
+{
+	if(partIndex > ranges.count()) {
+		return nullptr;
+	}
+
+	if(!headerSent) {
+		auto stream = new MemoryDataStream;
+		stream->print(getPartHeader(partIndex));
+		if(partIndex == ranges.count()) {
+			++partIndex;
+		} else {
+			headerSent = true;
+		}
+		return stream;
+	}
+
+	auto& range = ranges[partIndex++];
+	headerSent = false;
+	return new RangeStream(source, offset + range.start, range.length, false);
+}
+
+bool MultipartRangeStream::seek(int len)
+{
+	if(!MultiStream::seek(len)) {
+		return false;
+	}
+	readPos += len;
+	return true;
+}
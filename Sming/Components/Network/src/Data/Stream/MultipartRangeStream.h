@@ -0,0 +1,78 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MultipartRangeStream.h
+ *
+ ****/
+
+#pragma once
+
+#include <Data/Stream/MultiStream.h>
+#include <Network/Http/HttpRange.h>
+
+/**
+ * @brief Generates a `multipart/byteranges` response body for several ranges of a seekable stream
+ * @ingroup stream
+ *
+ * Each part carries `Content-Type` and `Content-Range` headers followed by the range content.
+ * The total size is known in advance so the response can be sent with a `Content-Length`.
+ */
+class MultipartRangeStream : public MultiStream
+{
+public:
+	/**
+	 * @brief Constructor
+	 * @param source Content stream, will be destroyed along with this stream
+	 * @param offset Position in source corresponding to start of content
+	 * @param ranges Ranges to send, already validated against content length
+	 * @param contentLength Total size of the content
+	 * @param contentType MIME type for each part
+	 */
+	MultipartRangeStream(IDataSourceStream* source, size_t offset, const HttpRangeList& ranges, size_t contentLength,
+						 const String& contentType);
+
+	~MultipartRangeStream()
+	{
+		delete source;
+	}
+
+	StreamType getStreamType() const override
+	{
+		return eSST_Unknown;
+	}
+
+	int available() override
+	{
+		return totalLength - readPos;
+	}
+
+	bool seek(int len) override;
+
+	/**
+	 * @brief Get the boundary string, required for the response `Content-Type` header
+	 */
+	const char* getBoundary() const
+	{
+		return boundary;
+	}
+
+protected:
+	IDataSourceStream* getNextStream() override;
+
+private:
+	String getPartHeader(unsigned index) const;
+
+	IDataSourceStream* source;
+	size_t offset;
+	HttpRangeList ranges;
+	size_t contentLength;
+	String contentType;
+	size_t totalLength{0};
+	size_t readPos{0};
+	unsigned partIndex{0};
+	bool headerSent{false};
+	char boundary[17]{};
+};
@@ -17,6 +17,8 @@
 #include "HttpBodyParser.h"
 #include <Data/WebHelpers/escape.h>
 
+namespace
+{
 /*
  * Content is received in chunks which we need to reassemble into name=value pairs.
  * This structure stores the temporary values during parsing.
@@ -27,11 +29,209 @@ struct FormUrlParserState {
 	String postValue;
 };
 
+/*
+ * URL-decodes text received in chunks. Escape sequences may be split across chunks.
+ */
+class FormUrlDecoder
+{
+public:
+	/*
+	 * Decode text into the output buffer, which must be at least as large as the input
+	 * plus two characters for any incomplete escape sequence from the previous call.
+	 * Returns number of characters written.
+	 */
+	size_t decode(const char* text, size_t length, char* output)
+	{
+		auto out = output;
+		for(unsigned i = 0; i < length; ++i) {
+			char c = text[i];
+			if(escapeLength != 0) {
+				if(isxdigit(c)) {
+					escape[escapeLength++] = c;
+					if(escapeLength == 3) {
+						*out++ = char((unhex(escape[1]) << 4) | unhex(escape[2]));
+						escapeLength = 0;
+					}
+					continue;
+				}
+				// Invalid sequence is passed through unchanged
+				out += flush(out);
+			}
+			if(c == '%') {
+				escape[escapeLength++] = c;
+			} else if(c == '+') {
+				*out++ = ' ';
+			} else {
+				*out++ = c;
+			}
+		}
+		return out - output;
+	}
+
+	/*
+	 * Write out any incomplete escape sequence at end of name or value
+	 */
+	size_t flush(char* output)
+	{
+		memcpy(output, escape, escapeLength);
+		auto len = escapeLength;
+		escapeLength = 0;
+		return len;
+	}
+
+private:
+	static uint8_t unhex(char c)
+	{
+		return (c <= '9') ? (c - '0') : ((c | 0x20) - 'a' + 10);
+	}
+
+	char escape[3];
+	uint8_t escapeLength{0};
+};
+
+/*
+ * Streaming parser state, used where a request has form field handlers
+ */
+struct FormUrlStreamState {
+	FormUrlStreamState(const HttpFormFields& fields, HttpRequest& request) : writer(fields, request)
+	{
+	}
+
+	HttpFormFields::Writer writer;
+	FormUrlDecoder decoder;
+	String name;
+	bool inValue{false};
+	bool failed{false}; ///< Set on error, remaining content is ignored
+};
+
+constexpr size_t maxFieldNameLength{64};
+
+bool formUrlStreamData(FormUrlStreamState& state, const char* at, size_t length)
+{
+	// Allow for incomplete escape sequence carried over from previous chunk
+	char buffer[64 + 2];
+	while(length != 0) {
+		auto chunkLength = std::min(length, sizeof(buffer) - 2);
+		// Names end with '=', or '&' if there's no value
+		const char* delim{nullptr};
+		for(unsigned i = 0; i < chunkLength; ++i) {
+			if(at[i] == '&' || (at[i] == '=' && !state.inValue)) {
+				delim = &at[i];
+				chunkLength = i;
+				break;
+			}
+		}
+
+		auto decodedLength = state.decoder.decode(at, chunkLength, buffer);
+		if(delim != nullptr) {
+			decodedLength += state.decoder.flush(&buffer[decodedLength]);
+		}
+		at += chunkLength;
+		length -= chunkLength;
+
+		if(state.inValue) {
+			if(!state.writer.write(buffer, decodedLength)) {
+				return false;
+			}
+		} else {
+			if(state.name.length() + decodedLength > maxFieldNameLength) {
+				debug_w("[FORM] Field name too long");
+				return false;
+			}
+			state.name.concat(buffer, decodedLength);
+		}
+
+		if(delim == nullptr) {
+			continue;
+		}
+
+		// Skip delimiter
+		++at;
+		--length;
+		if(state.inValue) {
+			state.inValue = false;
+			if(!state.writer.end()) {
+				return false;
+			}
+			continue;
+		}
+
+		if(!state.writer.begin(state.name)) {
+			return false;
+		}
+		state.name.setLength(0);
+		if(*delim == '=') {
+			state.inValue = true;
+		} else if(!state.writer.end()) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Called where a request has form field handlers
+ */
+size_t formUrlStreamParser(HttpRequest& request, const char* at, int length)
+{
+	auto state = static_cast<FormUrlStreamState*>(request.args);
+
+	if(length == PARSE_DATASTART) {
+		delete state;
+		request.args = new FormUrlStreamState(*request.formFields, request);
+		return 0;
+	}
+
+	if(state == nullptr) {
+		debug_e("Invalid request argument");
+		return 0;
+	}
+
+	if(length == PARSE_DATAEND) {
+		// Complete last field, if there is one
+		bool success = !state->failed;
+		if(success) {
+			char buffer[2];
+			auto len = state->decoder.flush(buffer);
+			if(state->inValue) {
+				success = state->writer.write(buffer, len);
+			} else if(state->name.length() + len > maxFieldNameLength) {
+				debug_w("[FORM] Field name too long");
+				success = false;
+			} else {
+				state->name.concat(buffer, len);
+				if(state->name.length() != 0) {
+					success = state->writer.begin(state->name);
+				}
+			}
+			success = success && state->writer.end();
+		}
+
+		delete state;
+		request.args = nullptr;
+		return success ? 0 : 1;
+	}
+
+	if(state->failed || !formUrlStreamData(*state, at, length)) {
+		state->failed = true;
+		return 0;
+	}
+
+	return length;
+}
+
+} // namespace
+
 /*
  * The incoming URL is parsed
  */
 size_t formUrlParser(HttpRequest& request, const char* at, int length)
 {
+	if(request.formFields != nullptr) {
+		return formUrlStreamParser(request, at, length);
+	}
+
 	auto state = static_cast<FormUrlParserState*>(request.args);
 
 	if(length == PARSE_DATASTART) {
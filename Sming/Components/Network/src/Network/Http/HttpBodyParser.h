@@ -31,7 +31,7 @@ const int PARSE_DATAEND = -2;   ///< End of incoming data
  * @param length Negative lengths have special meanings
  * @see `PARSE_DATASTART`
  * @see `PARSE_DATAEND`
- * @return parsed bytes
+ * @return parsed bytes. For `PARSE_DATAEND`, return 0 on success or non-zero if the content could not be processed.
  */
 using HttpBodyParserDelegate = Delegate<size_t(HttpRequest& request, const char* at, int length)>;
 
@@ -43,6 +43,8 @@ using BodyParsers = HashMap<String, HttpBodyParserDelegate>;
 /**
  * @brief Parses application/x-www-form-urlencoded body data
  * @see `HttpBodyParserDelegate`
+ * @note Values are stored in `HttpRequest::postParams`, unless the request has form fields set
+ * in which case they are decoded and passed on as they arrive. See `HttpFormFields`.
  */
 size_t formUrlParser(HttpRequest& request, const char* at, int length);
 
@@ -16,6 +16,7 @@
 #include "Data/Stream/LimitedMemoryStream.h"
 #include "Data/Stream/ChunkedStream.h"
 #include "Data/Stream/UrlencodedOutputStream.h"
+#include <Clock.h>
 
 bool HttpClientConnection::connect(const String& host, int port, bool useSsl)
 {
@@ -41,6 +42,8 @@ bool HttpClientConnection::connect(const String& host, int port, bool useSsl)
 
 bool HttpClientConnection::send(HttpRequest* request)
 {
+	lastActivity = millis();
+
 	if(!waitingQueue.enqueue(request)) {
 		// the queue is full and we cannot add more requests at the time.
 		debug_e("HCC::send: The request queue is full at the moment");
@@ -68,6 +71,15 @@ int HttpClientConnection::onMessageBegin(http_parser* parser)
 		return 1; // there are no requests in the queue
 	}
 
+	if(stats != nullptr) {
+		uint32_t ttfb = millis() - incomingRequest->sendTime;
+		++stats->responses;
+		stats->ttfbTotal += ttfb;
+		if(ttfb > stats->ttfbMax) {
+			stats->ttfbMax = ttfb;
+		}
+	}
+
 	return 0;
 }
 
@@ -134,6 +146,7 @@ int HttpClientConnection::onMessageComplete(http_parser* parser)
 	incomingRequest = nullptr;
 
 	state = eHCS_Ready;
+	lastActivity = millis();
 
 	auto response = getResponse();
 
@@ -249,14 +262,14 @@ REENTER:
 
 		// if the executionQueue is not empty then we have to check if we can pipeline that request
 		if(executionQueue.count() != 0) {
-			if(!(allowPipe && (request->method == HTTP_GET || request->method == HTTP_HEAD))) {
+			if(!(pipelining && allowPipe && isIdempotent(request->method))) {
 				// if the current request cannot be pipelined -> break;
 				break;
 			}
 
 			// if we have previous request
 			if(outgoingRequest != nullptr) {
-				if(!(outgoingRequest->method == HTTP_GET || outgoingRequest->method == HTTP_HEAD)) {
+				if(!isIdempotent(outgoingRequest->method)) {
 					// the outgoing request does not allow pipelining
 					break;
 				}
@@ -287,7 +300,7 @@ REENTER:
 	case eHCS_StartBody:
 	case eHCS_SendingBody: {
 		if(sendRequestBody(outgoingRequest)) {
-			if(!(outgoingRequest->method == HTTP_GET || outgoingRequest->method == HTTP_HEAD)) {
+			if(!(pipelining && isIdempotent(outgoingRequest->method))) {
 				// we should wait for the response from this request.
 				state = eHCS_WaitResponse;
 				break;
@@ -323,6 +336,8 @@ void HttpClientConnection::onClosed()
 
 void HttpClientConnection::sendRequestHeaders(HttpRequest* request)
 {
+	request->sendTime = millis();
+
 	String s = toString(request->method);
 	s += ' ';
 	s += request->uri.getPathWithQuery();
@@ -25,6 +25,38 @@
 
 using RequestQueue = ObjectQueue<HttpRequest, HTTP_REQUEST_POOL_SIZE>;
 
+/**
+ * @brief Statistics for HTTP client connections
+ */
+struct HttpClientStats {
+	uint32_t requests{0};	  ///< Requests submitted
+	uint32_t reused{0};		  ///< Requests sent using an already-connected connection
+	uint32_t connections{0};   ///< Connections created
+	uint32_t evicted{0};	   ///< Idle connections released from the pool
+	uint32_t responses{0};	 ///< Responses received
+	uint32_t ttfbTotal{0};	 ///< Sum of time-to-first-byte for all responses, in milliseconds
+	uint32_t ttfbMax{0};	   ///< Longest time-to-first-byte, in milliseconds
+	uint16_t maxQueueDepth{0}; ///< Highest number of requests queued at once
+
+	/**
+	 * @brief Get proportion of requests which did not require a new connection
+	 * @retval float 0.0 - 1.0
+	 */
+	float reuseRatio() const
+	{
+		return (requests == 0) ? 0 : float(reused) / requests;
+	}
+
+	/**
+	 * @brief Get average time between sending a request and the start of the response
+	 * @retval uint32_t Time in milliseconds
+	 */
+	uint32_t averageTtfb() const
+	{
+		return (responses == 0) ? 0 : ttfbTotal / responses;
+	}
+};
+
 class HttpClientConnection : public HttpConnection
 {
 public:
@@ -58,6 +90,56 @@ public:
 		return (waitingQueue.count() + executionQueue.count() == 0);
 	}
 
+	/**
+	 * @brief Get number of requests waiting or in progress
+	 */
+	unsigned getQueueDepth() const
+	{
+		return waitingQueue.count() + executionQueue.count();
+	}
+
+	/**
+	 * @brief Get time when a request was last submitted or completed
+	 * @retval uint32_t Value of `millis()`
+	 */
+	uint32_t getLastActivity() const
+	{
+		return lastActivity;
+	}
+
+	/**
+	 * @brief Enable HTTP pipelining
+	 * @param enable If true, idempotent requests may be sent without waiting for
+	 * preceding responses once the server has indicated support for keep-alive
+	 */
+	void setPipelining(bool enable)
+	{
+		pipelining = enable;
+	}
+
+	bool getPipelining() const
+	{
+		return pipelining;
+	}
+
+	/**
+	 * @brief Set location to record statistics
+	 * @param stats Must remain valid for the lifetime of this connection, or nullptr
+	 */
+	void setStats(HttpClientStats* stats)
+	{
+		this->stats = stats;
+	}
+
+	/**
+	 * @brief Determine whether a request may be repeated without side-effects, and so may be pipelined
+	 */
+	static bool isIdempotent(HttpMethod method)
+	{
+		return method == HTTP_GET || method == HTTP_HEAD || method == HTTP_OPTIONS || method == HTTP_PUT ||
+			   method == HTTP_DELETE;
+	}
+
 protected:
 	// HTTP parser methods
 
@@ -103,8 +185,11 @@ private:
 
 	HttpRequest* incomingRequest = nullptr;
 	HttpRequest* outgoingRequest = nullptr;
+	HttpClientStats* stats = nullptr;
+	uint32_t lastActivity = 0;
 
-	bool allowPipe = false; /// < Flag to specify if HTTP pipelining is allowed for this connection
+	bool allowPipe = false;  /// < Flag to specify if HTTP pipelining is supported by the server
+	bool pipelining = false; /// < Flag to specify if HTTP pipelining is enabled for this connection
 };
 
 /** @} */
@@ -117,7 +117,7 @@ int HttpConnection::staticOnHeaderValue(http_parser* parser, const char* at, siz
 {
 	GET_CONNECTION()
 
-	return connection->header.onHeaderValue(connection->incomingHeaders, at, length);
+	return connection->header.onHeaderValue(connection->getIncomingHeaders(), at, length);
 }
 
 int HttpConnection::staticOnHeadersComplete(http_parser* parser)
@@ -140,7 +140,7 @@ int HttpConnection::staticOnHeadersComplete(http_parser* parser)
 	 * useful for handling responses to a CONNECT request which may not contain
 	 * `Upgrade` or `Connection: upgrade` headers.
 	 */
-	int error = connection->onHeadersComplete(connection->incomingHeaders);
+	int error = connection->onHeadersComplete(connection->getIncomingHeaders());
 	connection->resetHeaders();
 
 	return error;
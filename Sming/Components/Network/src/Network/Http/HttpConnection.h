@@ -82,6 +82,15 @@ protected:
 	/** @brief Called after all headers have been received and processed */
 	void resetHeaders();
 
+	/**
+	 * @brief Get the container into which incoming headers are parsed
+	 * @note Server connections parse directly into the request, avoiding a copy
+	 */
+	virtual HttpHeaders& getIncomingHeaders()
+	{
+		return incomingHeaders;
+	}
+
 	/** @brief Initializes the http parser for a specific type of HTTP message
 	 *  @param type
 	 */
@@ -0,0 +1,87 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpFormFields.cpp
+ *
+ ****/
+
+#include "HttpFormFields.h"
+#include "HttpRequest.h"
+#include <debug_progmem.h>
+
+const HttpFormFields::Handler* HttpFormFields::findHandler(const String& name) const
+{
+	int i = handlers.indexOf(name);
+	if(i >= 0) {
+		return &handlers.valueAt(i);
+	}
+
+	if(defaultHandler.callback || defaultHandler.maxLength != 0) {
+		return &defaultHandler;
+	}
+
+	return nullptr;
+}
+
+bool HttpFormFields::Writer::begin(const String& fieldName)
+{
+	if(active && !end()) {
+		return false;
+	}
+
+	name = fieldName;
+	handler = fields.findHandler(name);
+	length = 0;
+	active = true;
+
+	if(handler == nullptr) {
+		debug_d("[FORM] Discarding field '%s'", name.c_str());
+		return true;
+	}
+
+	if(handler->callback) {
+		return handler->callback(request, name, HttpFormFieldEvent::Start, nullptr, 0);
+	}
+
+	request.postParams[name] = "";
+	return true;
+}
+
+bool HttpFormFields::Writer::write(const char* data, size_t length)
+{
+	if(handler == nullptr || length == 0) {
+		return true;
+	}
+
+	this->length += length;
+
+	if(handler->callback) {
+		return handler->callback(request, name, HttpFormFieldEvent::Data, data, length);
+	}
+
+	if(this->length > handler->maxLength) {
+		debug_w("[FORM] Field '%s' exceeds %u bytes", name.c_str(), handler->maxLength);
+		return false;
+	}
+
+	return request.postParams[name].concat(data, length);
+}
+
+bool HttpFormFields::Writer::end()
+{
+	if(!active) {
+		return true;
+	}
+
+	active = false;
+	auto h = handler;
+	handler = nullptr;
+	if(h == nullptr || !h->callback) {
+		return true;
+	}
+
+	return h->callback(request, name, HttpFormFieldEvent::End, nullptr, 0);
+}
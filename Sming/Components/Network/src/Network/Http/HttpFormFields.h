@@ -0,0 +1,167 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpFormFields.h
+ *
+ ****/
+
+#pragma once
+
+#include <WString.h>
+#include <WHashMap.h>
+#include <Delegate.h>
+
+class HttpRequest;
+
+/**
+ * @brief Events passed to form field callbacks
+ * @ingroup http
+ */
+enum class HttpFormFieldEvent {
+	Start, ///< New field, no data
+	Data,  ///< Fragment of decoded field value
+	End,   ///< Field value complete
+};
+
+/**
+ * @brief Callback to receive form field content as it arrives
+ * @param request
+ * @param name Decoded field name
+ * @param event
+ * @param data Decoded value fragment, for `Data` events only
+ * @param length Number of bytes in `data`
+ * @retval bool Return false to abort parsing. The request then fails with a content error.
+ * @ingroup http
+ */
+using HttpFormFieldDelegate =
+	Delegate<bool(HttpRequest& request, const String& name, HttpFormFieldEvent event, const char* data, size_t length)>;
+
+/**
+ * @brief Describes how incoming form fields should be handled
+ * @ingroup http
+ *
+ * By default, body parsers store every form field value in `HttpRequest::postParams`.
+ * This requires the entire value to be held in memory, which may not be possible for large posts.
+ *
+ * When a request has form fields set (see `HttpResource::formFields`), values are decoded
+ * as they arrive and passed to the registered handlers instead:
+ *
+ * - Streamed fields pass value fragments to a callback, so are never held in memory.
+ * - Buffered fields are stored in `HttpRequest::postParams` as usual, but fail the request
+ *   if they exceed a given length.
+ * - Any other fields are passed to the default handler, if set, otherwise discarded.
+ *
+ * Supported by `formUrlParser` and `formMultipartParser`.
+ */
+class HttpFormFields
+{
+private:
+	struct Handler;
+
+public:
+	/**
+	 * @brief Stream content for a field
+	 * @param name Field name
+	 * @param callback Receives field data as it arrives
+	 */
+	void onField(const String& name, HttpFormFieldDelegate callback)
+	{
+		handlers[name] = Handler{callback, 0};
+	}
+
+	/**
+	 * @brief Store content for a field in `HttpRequest::postParams`
+	 * @param name Field name
+	 * @param maxLength Values exceeding this length cause the request to fail
+	 */
+	void bufferField(const String& name, size_t maxLength)
+	{
+		handlers[name] = Handler{nullptr, maxLength};
+	}
+
+	/**
+	 * @brief Stream content for fields without a specific handler
+	 */
+	void onOtherField(HttpFormFieldDelegate callback)
+	{
+		defaultHandler = Handler{callback, 0};
+	}
+
+	/**
+	 * @brief Store content for fields without a specific handler
+	 * @param maxLength Values exceeding this length cause the request to fail, 0 to discard the fields
+	 */
+	void bufferOtherFields(size_t maxLength)
+	{
+		defaultHandler = Handler{nullptr, maxLength};
+	}
+
+	/**
+	 * @brief Remove all handlers
+	 */
+	void clear()
+	{
+		handlers.clear();
+		defaultHandler = Handler{};
+	}
+
+	/**
+	 * @brief Used by body parsers to pass field content to the appropriate handler
+	 */
+	class Writer
+	{
+	public:
+		Writer(const HttpFormFields& fields, HttpRequest& request) : fields(fields), request(request)
+		{
+		}
+
+		/**
+		 * @brief Start a new field
+		 * @param fieldName Decoded field name
+		 * @retval bool false on error
+		 */
+		bool begin(const String& fieldName);
+
+		/**
+		 * @brief Add decoded data to the current field
+		 * @retval bool false on error
+		 */
+		bool write(const char* data, size_t length);
+
+		/**
+		 * @brief Complete the current field
+		 * @retval bool false on error
+		 */
+		bool end();
+
+		/**
+		 * @brief Determine if a field is in progress
+		 */
+		bool isActive() const
+		{
+			return active;
+		}
+
+	private:
+		const HttpFormFields& fields;
+		HttpRequest& request;
+		String name;
+		const Handler* handler{nullptr};
+		size_t length{0};
+		bool active{false};
+	};
+
+private:
+	struct Handler {
+		HttpFormFieldDelegate callback;
+		size_t maxLength{0};
+	};
+
+	const Handler* findHandler(const String& name) const;
+
+	HashMap<String, Handler> handlers;
+	Handler defaultHandler;
+};
@@ -33,24 +33,25 @@ public:
 
 	int onHeaderValue(HttpHeaders& headers, const char* at, size_t length)
 	{
-		if(!lastWasValue) {
-			currentField = lastData;
-			headers[currentField] = nullptr;
+		bool isNew = !lastWasValue;
+		if(isNew) {
+			currentField = headers.findOrCreate(lastData);
 			lastWasValue = true;
 		}
-		headers[currentField].concat(at, length);
+		headers.appendText(currentField, at, length, isNew);
 		return 0;
 	}
 
 	void reset()
 	{
 		lastWasValue = true;
-		lastData = nullptr;
-		currentField = nullptr;
+		// Keep buffer for next message
+		lastData.setLength(0);
+		currentField = HTTP_HEADER_UNKNOWN;
 	}
 
 private:
-	bool lastWasValue = true; ///< Indicates whether last callback was Field or Value
-	String lastData;		  ///< Content of field or value, may be constructed over several callbacks
-	String currentField;	  ///< Header field name
+	bool lastWasValue = true;							   ///< Indicates whether last callback was Field or Value
+	String lastData;									   ///< Content of field or value, may be constructed over several callbacks
+	HttpHeaderFieldName currentField{HTTP_HEADER_UNKNOWN}; ///< Header field being received
 };
@@ -22,6 +22,26 @@ HTTP_HEADER_FIELDNAME_MAP(XX)
 DEFINE_FSTR_VECTOR_LOCAL(fieldNameStrings, FlashString, HTTP_HEADER_FIELDNAME_MAP(XX));
 #undef XX
 
+namespace
+{
+constexpr char toLower(char c)
+{
+	return (c >= 'A' && c <= 'Z') ? char(c + 'a' - 'A') : c;
+}
+
+/*
+ * Case-insensitive FNV-1a hash of a field name.
+ *
+ * Standard field names are hashed at compile time and used as `case` labels in
+ * `findStandardField()`, so any collision between them is a compilation error.
+ */
+constexpr uint32_t fieldNameHash(const char* name, size_t length, uint32_t hash = 2166136261U)
+{
+	return (length == 0) ? hash : fieldNameHash(name + 1, length - 1, (hash ^ uint8_t(toLower(*name))) * 16777619U);
+}
+
+} // namespace
+
 HttpHeaderFields::Flags HttpHeaderFields::getFlags(HttpHeaderFieldName name) const
 {
 	switch(name) {
@@ -80,11 +100,29 @@ String HttpHeaderFields::toString(const String& name, const String& value)
 	return s;
 }
 
+HttpHeaderFieldName HttpHeaderFields::findStandardField(const String& name)
+{
+	HttpHeaderFieldName field;
+	switch(fieldNameHash(name.c_str(), name.length())) {
+#define XX(tag, str, flags, comment)                                                                                   \
+	case fieldNameHash(str, sizeof(str) - 1):                                                                          \
+		field = HttpHeaderFieldName::tag;                                                                              \
+		break;
+		HTTP_HEADER_FIELDNAME_MAP(XX)
+#undef XX
+	default:
+		return HTTP_HEADER_UNKNOWN;
+	}
+
+	// Hash matches so only need one comparison to confirm
+	return name.equalsIgnoreCase(fieldNameStrings[unsigned(field) - 1]) ? field : HTTP_HEADER_UNKNOWN;
+}
+
 HttpHeaderFieldName HttpHeaderFields::fromString(const String& name) const
 {
-	auto index = fieldNameStrings.indexOf(name);
-	if(index >= 0) {
-		return static_cast<HttpHeaderFieldName>(index + 1);
+	auto field = findStandardField(name);
+	if(field != HTTP_HEADER_UNKNOWN) {
+		return field;
 	}
 
 	return findCustomFieldName(name);
@@ -79,7 +79,11 @@
 	XX(WWW_AUTHENTICATE, "WWW-Authenticate", Flag::Multi,                                                              \
 	   "Indicates HTTP authentication scheme(s) and applicable parameters")                                            \
 	XX(PROXY_AUTHENTICATE, "Proxy-Authenticate", Flag::Multi,                                                          \
-	   "Indicates proxy authentication scheme(s) and applicable parameters")
+	   "Indicates proxy authentication scheme(s) and applicable parameters")                                           \
+	XX(ACCEPT_RANGES, "Accept-Ranges", 0, "Indicates server supports range requests")                                  \
+	XX(CONTENT_RANGE, "Content-Range", 0, "Location of partial content within the full representation")                \
+	XX(IF_RANGE, "If-Range", 0, "Precondition for Range: send partial content only if ETag or date matches")           \
+	XX(RANGE, "Range", 0, "Request for one or more parts of a representation, e.g. bytes=0-499")
 
 enum class HttpHeaderFieldName {
 	UNKNOWN = 0,
@@ -130,6 +134,14 @@ public:
 	 */
 	HttpHeaderFieldName fromString(const String& name) const;
 
+	/** @brief Find the enumerated value for a standard field name
+	 *  @param name
+	 *  @retval HttpHeaderFieldName field name code, HTTP_HEADER_UNKNOWN if not a standard field
+	 *  @note comparison is not case-sensitive. A perfect hash is used so lookup time does not
+	 *  depend on the number of standard fields.
+	 */
+	static HttpHeaderFieldName findStandardField(const String& name);
+
 	/** @brief Find the enumerated value for the given field name string, create a custom entry if not found
 	 *  @param name
 	 *  @retval HttpHeaderFieldName field name code
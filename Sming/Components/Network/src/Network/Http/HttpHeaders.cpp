@@ -11,6 +11,13 @@
 #include "HttpHeaders.h"
 #include <debug_progmem.h>
 
+namespace
+{
+constexpr unsigned initialCapacity{8};
+}
+
+const String HttpHeaders::nil;
+
 const String& HttpHeaders::operator[](const String& name) const
 {
 	auto field = fromString(name);
@@ -20,6 +27,110 @@ const String& HttpHeaders::operator[](const String& name) const
 	return operator[](field);
 }
 
+String& HttpHeaders::operator[](const HttpHeaderFieldName& name)
+{
+	int i = indexOf(name);
+	if(i >= 0) {
+		return getValue(entries[i]);
+	}
+
+	if(entryCount == capacity) {
+		grow();
+	}
+
+	auto& entry = entries[entryCount++];
+	entry.name = name;
+	entry.value = nullptr;
+
+	unsigned mask = capacity * 2 - 1;
+	unsigned slot = unsigned(name) & mask;
+	while(slots[slot] != 0) {
+		slot = (slot + 1) & mask;
+	}
+	slots[slot] = entryCount;
+
+	return entry.value;
+}
+
+int HttpHeaders::indexOf(HttpHeaderFieldName name) const
+{
+	if(entryCount == 0) {
+		return -1;
+	}
+
+	// Table is never more than half full so there is always an empty slot
+	unsigned mask = capacity * 2 - 1;
+	for(unsigned slot = unsigned(name) & mask;; slot = (slot + 1) & mask) {
+		unsigned index = slots[slot];
+		if(index == 0) {
+			return -1;
+		}
+		if(entries[index - 1].name == name) {
+			return index - 1;
+		}
+	}
+}
+
+void HttpHeaders::grow()
+{
+	unsigned newCapacity = (capacity == 0) ? initialCapacity : capacity * 2;
+	auto newEntries = new Entry[newCapacity];
+	for(unsigned i = 0; i < entryCount; ++i) {
+		newEntries[i].move(entries[i]);
+	}
+	entries.reset(newEntries);
+	slots.reset(new uint16_t[newCapacity * 2]);
+	capacity = newCapacity;
+	buildIndex();
+}
+
+void HttpHeaders::buildIndex()
+{
+	unsigned slotCount = capacity * 2;
+	memset(slots.get(), 0, slotCount * sizeof(slots[0]));
+	unsigned mask = slotCount - 1;
+	for(unsigned i = 0; i < entryCount; ++i) {
+		unsigned slot = unsigned(entries[i].name) & mask;
+		while(slots[slot] != 0) {
+			slot = (slot + 1) & mask;
+		}
+		slots[slot] = i + 1;
+	}
+}
+
+void HttpHeaders::remove(const HttpHeaderFieldName& name)
+{
+	int i = indexOf(name);
+	if(i < 0) {
+		return;
+	}
+
+	--entryCount;
+	for(unsigned j = i; j < entryCount; ++j) {
+		entries[j].move(entries[j + 1]);
+	}
+	entries[entryCount].value = nullptr;
+	entries[entryCount].clearText();
+	buildIndex();
+}
+
+void HttpHeaders::clear()
+{
+	HttpHeaderFields::clear();
+	if(entryCount == 0) {
+		return;
+	}
+	for(unsigned i = 0; i < entryCount; ++i) {
+		entries[i].value = nullptr;
+		entries[i].clearText();
+	}
+	if(arena) {
+		arena->reset();
+	}
+	entryCount = 0;
+	buildIndex();
+}
+
 bool HttpHeaders::append(const HttpHeaderFieldName& name, const String& value)
 {
 	int i = indexOf(name);
@@ -46,3 +157,41 @@ void HttpHeaders::setMultiple(const HttpHeaders& headers)
 		operator[](fieldNameString) = headers.valueAt(i);
 	}
 }
+
+void HttpHeaders::appendText(HttpHeaderFieldName name, const char* text, size_t length, bool replace)
+{
+	int i = indexOf(name);
+	if(i < 0) {
+		operator[](name);
+		i = entryCount - 1;
+	}
+	auto& entry = entries[i];
+	if(replace) {
+		entry.value = nullptr;
+		entry.clearText();
+	}
+	if(length == 0) {
+		return;
+	}
+
+	if(arena && !entry.value && entry.textLength + length <= UINT16_MAX) {
+		auto newText = arena->append(entry.text, entry.textLength, text, length);
+		if(newText != nullptr) {
+			entry.text = newText;
+			entry.textLength += length;
+			return;
+		}
+	}
+
+	// No arena, or it's full
+	getValue(entry).concat(text, length);
+}
+
+void HttpHeaders::enableArena(size_t blockSize)
+{
+	if(blockSize == 0) {
+		arena.reset();
+	} else {
+		arena.reset(new Arena(blockSize));
+	}
+}
@@ -20,18 +20,27 @@
 #pragma once
 
 #include "HttpHeaderFields.h"
-#include "WHashMap.h"
 #include "DateTime.h"
+#include <Data/Arena.h>
+#include <memory>
 
 /** @brief Encapsulates a set of HTTP header information
  *  @note fields are stored as a map of field names vs. values.
  *  Standard fields may be accessed using enumeration tags.
- *  Behaviour is as for HashMap, with the addition of methods to support enumerated field names.
+ *
+ *  Entries are held in a single block, indexed by a small open-addressing hash table,
+ *  so field lookup does not depend on the number of headers present.
+ *  Storage is retained by `clear()` so it may be re-used for subsequent requests.
+ *  References to values remain valid until another field is added or removed.
+ *
+ *  Received headers may optionally be stored in an `Arena`, see `enableArena()`.
+ *  Values are then only copied into a String when accessed, and all storage
+ *  is recovered by `clear()` in a single operation.
  *
  *  @todo add name and/or value escaping
  *  @ingroup http
  */
-class HttpHeaders : public HttpHeaderFields, private HashMap<HttpHeaderFieldName, String>
+class HttpHeaders : public HttpHeaderFields
 {
 public:
 	HttpHeaders() = default;
@@ -41,7 +50,23 @@ public:
 		*this = headers;
 	}
 
-	using HashMap::operator[];
+	/** @brief Fetch a reference to the header field value
+	 *  @param name
+	 *  @retval const String& Reference to value
+	 *  @note if the field doesn't exist a null String reference is returned
+	 */
+	const String& operator[](const HttpHeaderFieldName& name) const
+	{
+		int i = indexOf(name);
+		return (i < 0) ? nil : getValue(entries[i]);
+	}
+
+	/** @brief Fetch a reference to the header field value
+	 *  @param name
+	 *  @retval String& Reference to value
+	 *  @note if the field doesn't exist it is created with the default null value
+	 */
+	String& operator[](const HttpHeaderFieldName& name);
 
 	/** @brief Fetch a reference to the header field value by name
 	 *  @param name
@@ -70,7 +95,13 @@ public:
 		return toString(keyAt(index), valueAt(index));
 	}
 
-	using HashMap::contains;
+	/**
+	 * @brief Determine if given header field is present
+	 */
+	bool contains(const HttpHeaderFieldName& name) const
+	{
+		return indexOf(name) >= 0;
+	}
 
 	/**
 	 * @brief Determine if given header field is present
@@ -80,8 +111,6 @@ public:
 		return contains(fromString(name));
 	}
 
-	using HashMap::remove;
-
 	/**
 	 * @brief Append value to multi-value field
 	 * @param name
@@ -90,6 +119,8 @@ public:
 	 */
 	bool append(const HttpHeaderFieldName& name, const String& value);
 
+	void remove(const HttpHeaderFieldName& name);
+
 	void remove(const String& name)
 	{
 		remove(fromString(name));
@@ -97,6 +128,33 @@ public:
 
 	void setMultiple(const HttpHeaders& headers);
 
+	/**
+	 * @brief Append received text to a field value
+	 * @param name
+	 * @param text
+	 * @param length
+	 * @param replace true to discard any existing value first
+	 * @note Used when parsing incoming headers. If an arena is enabled the text is stored there
+	 * and only copied into a String when the value is accessed.
+	 */
+	void appendText(HttpHeaderFieldName name, const char* text, size_t length, bool replace);
+
+	/**
+	 * @brief Store received header text in an arena, instead of allocating a String for each value
+	 * @param blockSize Size of initial arena block, 0 to disable
+	 * @note Should be called before any fields are added
+	 */
+	void enableArena(size_t blockSize);
+
+	/**
+	 * @brief Get arena, if enabled
+	 * @retval const Arena* nullptr if not enabled
+	 */
+	const Arena* getArena() const
+	{
+		return arena.get();
+	}
+
 	HttpHeaders& operator=(const HttpHeaders& headers)
 	{
 		clear();
@@ -104,14 +162,17 @@ public:
 		return *this;
 	}
 
-	void clear()
+	/**
+	 * @brief Remove all fields
+	 * @note Allocated storage is retained
+	 */
+	void clear();
+
+	unsigned count() const
 	{
-		HttpHeaderFields::clear();
-		HashMap::clear();
+		return entryCount;
 	}
 
-	using HashMap::count;
-
 	DateTime getLastModifiedDate() const
 	{
 		DateTime dt;
@@ -125,4 +186,66 @@ public:
 		String strSD = operator[](HTTP_HEADER_DATE);
 		return dt.fromHttpDate(strSD) ? dt : DateTime();
 	}
+
+private:
+	struct Entry {
+		HttpHeaderFieldName name;
+		String value;
+		char* text{nullptr}; ///< Value held in arena, not yet copied into `value`
+		uint16_t textLength{0};
+
+		void move(Entry& other)
+		{
+			name = other.name;
+			value = std::move(other.value);
+			text = other.text;
+			textLength = other.textLength;
+			other.clearText();
+		}
+
+		void clearText()
+		{
+			text = nullptr;
+			textLength = 0;
+		}
+	};
+
+	/*
+	 * Arena values are copied into a String on first access
+	 */
+	static String& getValue(Entry& entry)
+	{
+		if(entry.text != nullptr) {
+			entry.value = String(entry.text, entry.textLength);
+			entry.clearText();
+		}
+		return entry.value;
+	}
+
+	HttpHeaderFieldName keyAt(unsigned index) const
+	{
+		return (index < entryCount) ? entries[index].name : HTTP_HEADER_UNKNOWN;
+	}
+
+	const String& valueAt(unsigned index) const
+	{
+		return (index < entryCount) ? getValue(entries[index]) : nil;
+	}
+
+	String& valueAt(unsigned index)
+	{
+		return getValue(entries[index]);
+	}
+
+	int indexOf(HttpHeaderFieldName name) const;
+	void grow();
+	void buildIndex();
+
+	static const String nil;
+
+	std::unique_ptr<Entry[]> entries;
+	std::unique_ptr<uint16_t[]> slots; ///< Hash table of entry index + 1, 0 if slot unused
+	std::unique_ptr<Arena> arena;	   ///< Optional storage for received values
+	uint16_t capacity{0};			   ///< Number of entries allocated, hash table is twice this size
+	uint16_t entryCount{0};
 };
@@ -0,0 +1,152 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpRange.cpp
+ *
+ ****/
+
+#include "HttpRange.h"
+#include <cctype>
+
+namespace
+{
+void skipSpace(const char*& s)
+{
+	while(*s == ' ' || *s == '\t') {
+		++s;
+	}
+}
+
+bool parseNumber(const char*& s, size_t& value)
+{
+	if(!isdigit(*s)) {
+		return false;
+	}
+	value = 0;
+	while(isdigit(*s)) {
+		size_t newValue = value * 10 + (*s++ - '0');
+		if(newValue < value) {
+			return false; // Overflow
+		}
+		value = newValue;
+	}
+	return true;
+}
+
+} // namespace
+
+HttpRangeList::Result HttpRangeList::parse(const char* value, size_t contentLength)
+{
+	rangeCount = 0;
+
+	if(value == nullptr || strncasecmp(value, _F("bytes="), 6) != 0) {
+		return Result::ignore;
+	}
+
+	auto s = value + 6;
+	unsigned specCount{0};
+	size_t total{0};
+	for(;;) {
+		skipSpace(s);
+		if(*s == ',') {
+			// Empty list elements are permitted
+			++s;
+			continue;
+		}
+		if(*s == '\0') {
+			break;
+		}
+
+		size_t first;
+		size_t last;
+		if(*s == '-') {
+			// Suffix range: final N bytes
+			++s;
+			size_t suffix;
+			if(!parseNumber(s, suffix)) {
+				return Result::ignore;
+			}
+			if(suffix == 0 || contentLength == 0) {
+				first = contentLength;
+				last = 0;
+			} else {
+				first = (suffix < contentLength) ? contentLength - suffix : 0;
+				last = contentLength - 1;
+			}
+		} else {
+			if(!parseNumber(s, first) || *s++ != '-') {
+				return Result::ignore;
+			}
+			if(parseNumber(s, last)) {
+				if(last < first) {
+					return Result::ignore;
+				}
+				if(last >= contentLength) {
+					last = contentLength - 1;
+				}
+			} else {
+				last = contentLength - 1;
+			}
+		}
+
+		skipSpace(s);
+		if(*s != ',' && *s != '\0') {
+			return Result::ignore;
+		}
+		++specCount;
+
+		if(first >= contentLength) {
+			// Not satisfiable, but others may be
+			continue;
+		}
+
+		if(rangeCount == HTTP_MAX_RANGES) {
+			rangeCount = 0;
+			return Result::ignore;
+		}
+		size_t length = last - first + 1;
+		total += length;
+		if(total > contentLength) {
+			// Overlapping ranges: cheaper to send the whole thing
+			rangeCount = 0;
+			return Result::ignore;
+		}
+		ranges[rangeCount++] = Range{first, length};
+	}
+
+	if(specCount == 0) {
+		return Result::ignore;
+	}
+
+	return (rangeCount == 0) ? Result::unsatisfiable : Result::ok;
+}
+
+size_t HttpRangeList::getTotalLength() const
+{
+	size_t total{0};
+	for(unsigned i = 0; i < rangeCount; ++i) {
+		total += ranges[i].length;
+	}
+	return total;
+}
+
+String HttpRangeList::getContentRange(const Range& range, size_t contentLength)
+{
+	String s = F("bytes ");
+	s += range.start;
+	s += '-';
+	s += range.end();
+	s += '/';
+	s += contentLength;
+	return s;
+}
+
+String HttpRangeList::getUnsatisfiedRange(size_t contentLength)
+{
+	String s = F("bytes */");
+	s += contentLength;
+	return s;
+}
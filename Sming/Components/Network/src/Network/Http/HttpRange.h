@@ -0,0 +1,91 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpRange.h - Byte range requests as described in RFC 7233
+ *
+ ****/
+
+#pragma once
+
+#include <WString.h>
+
+/**
+ * @brief Maximum number of ranges accepted in a single request
+ *
+ * Requests for more ranges than this are served in full.
+ */
+#ifndef HTTP_MAX_RANGES
+#define HTTP_MAX_RANGES 8
+#endif
+
+/**
+ * @brief A parsed `Range` request header
+ * @ingroup http
+ */
+class HttpRangeList
+{
+public:
+	struct Range {
+		size_t start;
+		size_t length;
+
+		size_t end() const
+		{
+			return start + length - 1;
+		}
+	};
+
+	enum class Result {
+		ignore,		   ///< Header is absent, malformed or too complex: send full content
+		ok,			   ///< One or more ranges may be served
+		unsatisfiable, ///< No ranges overlap the content
+	};
+
+	/**
+	 * @brief Parse a `Range` header value
+	 * @param value e.g. "bytes=0-499,-100"
+	 * @param contentLength Total size of the content
+	 * @retval Result
+	 *
+	 * Ranges are clipped to the content, and those lying outside it are discarded.
+	 * Requests whose ranges overlap so as to exceed the content size are ignored.
+	 */
+	Result parse(const char* value, size_t contentLength);
+
+	unsigned count() const
+	{
+		return rangeCount;
+	}
+
+	const Range& operator[](unsigned index) const
+	{
+		return ranges[index];
+	}
+
+	/**
+	 * @brief Get the total number of bytes covered by all ranges
+	 */
+	size_t getTotalLength() const;
+
+	/**
+	 * @brief Get value for a `Content-Range` header
+	 * @param range
+	 * @param contentLength Total size of the content
+	 * @retval String e.g. "bytes 0-499/1234"
+	 */
+	static String getContentRange(const Range& range, size_t contentLength);
+
+	/**
+	 * @brief Get value for a `Content-Range` header in a 416 response
+	 * @param contentLength Total size of the content
+	 * @retval String e.g. "bytes *\/1234"
+	 */
+	static String getUnsatisfiedRange(size_t contentLength);
+
+private:
+	Range ranges[HTTP_MAX_RANGES];
+	unsigned rangeCount{0};
+};
@@ -62,7 +62,10 @@ void HttpRequest::reset()
 	delete responseStream;
 	responseStream = nullptr;
 
+	formFields = nullptr;
+
 	postParams.clear();
+	pathParams.clear();
 	files.clear();
 	headers.clear();
 }
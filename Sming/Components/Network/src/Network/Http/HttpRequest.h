@@ -20,6 +20,7 @@
 #include "Data/Stream/DataSourceStream.h"
 #include "HttpHeaders.h"
 #include "HttpParams.h"
+#include "HttpFormFields.h"
 #include "Data/ObjectMap.h"
 
 class HttpConnection;
@@ -53,8 +54,9 @@ public:
 	 */
 	HttpRequest(const HttpRequest& value)
 		: uri(value.uri), method(value.method), headers(value.headers), postParams(value.postParams),
-		  headersCompletedDelegate(value.headersCompletedDelegate), requestBodyDelegate(value.requestBodyDelegate),
-		  requestCompletedDelegate(value.requestCompletedDelegate), sslInitDelegate(value.sslInitDelegate)
+		  pathParams(value.pathParams), headersCompletedDelegate(value.headersCompletedDelegate),
+		  requestBodyDelegate(value.requestBodyDelegate), requestCompletedDelegate(value.requestCompletedDelegate),
+		  sslInitDelegate(value.sslInitDelegate)
 	{
 	}
 
@@ -148,6 +150,17 @@ public:
 		return static_cast<const HttpParams&>(postParams)[name];
 	}
 
+	/**
+	 * @brief Get parameter captured from the request path
+	 * @param name Name of parameter, as given in the resource path (e.g. `/devices/{name}`)
+	 * @param defaultValue Returned if parameter is not present
+	 * @retval String
+	 */
+	String getPathParameter(const String& name, const String& defaultValue = nullptr) const
+	{
+		return static_cast<const HttpParams&>(pathParams)[name] ?: defaultValue;
+	}
+
 	/**
 	 * @brief Get parameter from query fields
 	 * @param name Name of parameter
@@ -285,8 +298,16 @@ public:
 	HttpMethod method = HTTP_GET; ///< Request method
 	HttpHeaders headers;		  ///< Request headers
 	HttpParams postParams;		  ///< POST parameters
+	HttpParams pathParams;		  ///< Parameters captured from the path by the server resource tree
 	HttpFiles files;			  ///< Attached files
 
+	/**
+	 * @brief Server: Handlers for incoming form fields
+	 * @note Set from the resource when headers are complete, but may be changed in the resource's
+	 * `onHeadersComplete` callback. If null, all fields are stored in `postParams`.
+	 */
+	const HttpFormFields* formFields = nullptr;
+
 	int retries = 0; ///< how many times the request should be send again...
 
 	void* args = nullptr; ///< Used to store data that should be valid during a single request
@@ -306,6 +327,7 @@ protected:
 
 private:
 	HttpParams* queryParams = nullptr; // << @todo deprecate
+	uint32_t sendTime = 0;			   ///< Client: when request was sent, used to measure response time
 };
 
 inline String toString(const HttpRequest& req)
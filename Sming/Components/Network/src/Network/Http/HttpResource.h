@@ -68,6 +68,7 @@ public:
 	HttpResourceDelegate onHeadersComplete = nullptr;		 ///< headers are ready
 	HttpResourceDelegate onRequestComplete = nullptr;		 ///< request is complete OR upgraded
 	HttpServerConnectionUpgradeDelegate onUpgrade = nullptr; ///< request is upgraded and raw data is passed to it
+	const HttpFormFields* formFields = nullptr;				 ///< Optional handlers for streamed form content
 
 	void addPlugin(HttpResourcePlugin* plugin);
 
@@ -53,3 +53,41 @@ HttpResource* HttpResourceTree::set(String path, const HttpPathDelegate& callbac
 	set(path, res);
 	return res;
 }
+
+void HttpResourceTree::buildRouter()
+{
+	router.clear();
+	routerRevision = index.revision;
+	for(unsigned i = 0; i < count(); ++i) {
+		auto& path = entries[i].key;
+		if(!router.add(path, i)) {
+			debug_w("[HTTP] Invalid path '%s'", path.c_str());
+		}
+	}
+}
+
+HttpResource* HttpResourceTree::match(const String& path, HttpParams* params)
+{
+	if(routerRevision != index.revision) {
+		buildRouter();
+	}
+
+	HttpRouter::Match match;
+	if(!router.match(path, match)) {
+		return nullptr;
+	}
+
+	if(params != nullptr) {
+		// Parameter names appear in the same order within the matched pattern
+		auto& pattern = entries[match.route].key;
+		int pos = 0;
+		for(unsigned i = 0; i < match.paramCount; ++i) {
+			int start = pattern.indexOf('{', pos);
+			pos = pattern.indexOf('}', start);
+			auto& param = match.params[i];
+			(*params)[pattern.substring(start + 1, pos)] = String(path.c_str() + param.offset, param.length);
+		}
+	}
+
+	return entries[match.route].value;
+}
@@ -13,17 +13,53 @@
 #pragma once
 
 #include "HttpResource.h"
+#include "HttpRouter.h"
+#include "HttpParams.h"
 
 using HttpPathDelegate = Delegate<void(HttpRequest& request, HttpResponse& response)>;
 
 /** @brief Identifies the default resource path */
 #define RESOURCE_PATH_DEFAULT String('*')
 
+/**
+ * @brief Linear lookup which also counts changes to the set of entries
+ * @ingroup httpserver
+ *
+ * ObjectMap notifies its index of every addition and removal, however it's made,
+ * so HttpResourceTree uses this to determine when its router must be rebuilt.
+ */
+class HttpResourceIndex : public MapIndex::Linear
+{
+public:
+	template <typename GetKey> void added(unsigned, GetKey)
+	{
+		++revision;
+	}
+
+	template <typename GetKey> void changed(unsigned, GetKey)
+	{
+		++revision;
+	}
+
+	void clear()
+	{
+		++revision;
+	}
+
+	unsigned revision{0};
+};
+
 /**
  * @brief Class to map URL paths to classes which handle them
  * @ingroup httpserver
+ *
+ * Paths may contain `{name}` parameters and a trailing `*` wildcard, see `HttpRouter`.
+ * Requests are matched using a radix tree which is built on first use and rebuilt
+ * whenever resources are added or removed.
+ *
+ * @note Keys must not be modified directly (e.g. via `keyAt()`) as the router cannot detect this.
  */
-class HttpResourceTree : public ObjectMap<String, HttpResource>
+class HttpResourceTree : public ObjectMap<String, HttpResource, HttpResourceIndex>
 {
 public:
 	/** @brief Set the default resource handler
@@ -57,6 +93,14 @@ public:
 		return find(RESOURCE_PATH_DEFAULT);
 	}
 
+	/**
+	 * @brief Find the resource which handles a request path
+	 * @param path Request path
+	 * @param params If provided, receives values for any parameters in the matched route
+	 * @retval HttpResource* The matching resource, or the default resource if there is no match
+	 */
+	HttpResource* match(const String& path, HttpParams* params = nullptr);
+
 	using ObjectMap::set;
 
 	template <class... Tail>
@@ -136,5 +180,9 @@ private:
 		registerPlugin(plugins...);
 	}
 
+	void buildRouter();
+
 	HttpResourcePlugin::OwnedList loadedPlugins;
+	HttpRouter router;
+	unsigned routerRevision{0}; ///< Index revision when router was built
 };
@@ -0,0 +1,177 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpRouter.cpp
+ *
+ ****/
+
+#include "HttpRouter.h"
+
+struct HttpRouter::Node {
+	String label;		  ///< Literal text matched by this node
+	Node* next{nullptr};  ///< Next sibling, each has a distinct first character
+	Node* child{nullptr}; ///< First literal child
+	Node* param{nullptr}; ///< Child matching a single path segment
+	int route{-1};		  ///< Route which terminates at this node
+	int wildcard{-1};	 ///< Route matching any remaining text
+
+	~Node()
+	{
+		delete param;
+		delete child;
+		delete next;
+	}
+};
+
+void HttpRouter::clear()
+{
+	delete root;
+	root = nullptr;
+}
+
+bool HttpRouter::add(const String& pattern, uint16_t route)
+{
+	if(root == nullptr) {
+		root = new Node;
+	}
+
+	auto node = root;
+	auto text = pattern.c_str();
+	size_t length = pattern.length();
+	unsigned paramCount = 0;
+	size_t pos = 0;
+	while(pos < length) {
+		if(text[pos] == '{') {
+			auto end = static_cast<const char*>(memchr(&text[pos], '}', length - pos));
+			if(end == nullptr || ++paramCount > maxParams) {
+				return false;
+			}
+			if(node->param == nullptr) {
+				node->param = new Node;
+			}
+			node = node->param;
+			pos = end + 1 - text;
+			continue;
+		}
+
+		if(text[pos] == '*' && pos + 1 == length) {
+			if(node->wildcard < 0) {
+				node->wildcard = route;
+			}
+			return true;
+		}
+
+		auto end = pos + 1;
+		while(end < length && text[end] != '{' && !(text[end] == '*' && end + 1 == length)) {
+			++end;
+		}
+		node = addLiteral(*node, &text[pos], end - pos);
+		pos = end;
+	}
+
+	if(node->route < 0) {
+		node->route = route;
+	}
+	return true;
+}
+
+HttpRouter::Node* HttpRouter::addLiteral(Node& parent, const char* text, size_t length)
+{
+	auto node = parent.child;
+	while(node != nullptr && node->label[0] != text[0]) {
+		node = node->next;
+	}
+
+	if(node == nullptr) {
+		node = new Node;
+		node->label.setString(text, length);
+		node->next = parent.child;
+		parent.child = node;
+		return node;
+	}
+
+	size_t common = 1;
+	while(common < length && common < node->label.length() && node->label[common] == text[common]) {
+		++common;
+	}
+
+	// Split node so it matches only the common prefix
+	if(common < node->label.length()) {
+		auto tail = new Node;
+		tail->label = node->label.substring(common);
+		tail->child = node->child;
+		tail->param = node->param;
+		tail->route = node->route;
+		tail->wildcard = node->wildcard;
+		node->label.setLength(common);
+		node->child = tail;
+		node->param = nullptr;
+		node->route = -1;
+		node->wildcard = -1;
+	}
+
+	if(common == length) {
+		return node;
+	}
+
+	return addLiteral(*node, text + common, length - common);
+}
+
+bool HttpRouter::match(const char* path, size_t length, Match& match) const
+{
+	if(root == nullptr) {
+		return false;
+	}
+
+	match.paramCount = 0;
+	return matchNode(*root, path, length, 0, match);
+}
+
+bool HttpRouter::matchNode(const Node& node, const char* path, size_t length, size_t pos, Match& match) const
+{
+	if(pos == length) {
+		if(node.route >= 0) {
+			match.route = node.route;
+			return true;
+		}
+	} else {
+		for(auto child = node.child; child != nullptr; child = child->next) {
+			auto label = child->label.c_str();
+			if(label[0] != path[pos]) {
+				continue;
+			}
+			size_t labelLength = child->label.length();
+			if(labelLength <= length - pos && memcmp(label, &path[pos], labelLength) == 0 &&
+			   matchNode(*child, path, length, pos + labelLength, match)) {
+				return true;
+			}
+			break;
+		}
+
+		if(node.param != nullptr) {
+			auto end = pos;
+			while(end < length && path[end] != '/') {
+				++end;
+			}
+			if(end > pos) {
+				auto& param = match.params[match.paramCount++];
+				param.offset = pos;
+				param.length = end - pos;
+				if(matchNode(*node.param, path, length, end, match)) {
+					return true;
+				}
+				--match.paramCount;
+			}
+		}
+	}
+
+	if(node.wildcard >= 0) {
+		match.route = node.wildcard;
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,99 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpRouter.h
+ *
+ ****/
+
+#pragma once
+
+#include <WString.h>
+
+/**
+ * @brief Radix tree used to match request paths against a set of route patterns
+ * @ingroup httpserver
+ *
+ * Patterns may contain:
+ *
+ * 	- Literal text, e.g. `/api/status`
+ * 	- Parameters, e.g. `/api/device/{id}/state`. A parameter matches one complete path segment,
+ * 	  i.e. one or more characters excluding '/'.
+ * 	- A trailing `*` wildcard. This matches any remaining text, including '/'.
+ *
+ * Where more than one route matches, literal text takes precedence over parameters,
+ * which take precedence over wildcards.
+ *
+ * Lookup time depends on the path length, not the number of routes.
+ */
+class HttpRouter
+{
+public:
+	/** @brief Maximum number of parameters in a single route */
+	static constexpr unsigned maxParams = 8;
+
+	/** @brief Result of a successful match */
+	struct Match {
+		/** @brief Location of a captured parameter value in the request path */
+		struct Param {
+			uint16_t offset;
+			uint16_t length;
+		};
+
+		uint16_t route;		///< Route identifier as passed to `add()`
+		uint8_t paramCount; ///< Number of parameters captured
+		Param params[maxParams];
+	};
+
+	HttpRouter() = default;
+	HttpRouter(const HttpRouter&) = delete;
+	HttpRouter& operator=(const HttpRouter&) = delete;
+
+	~HttpRouter()
+	{
+		clear();
+	}
+
+	/**
+	 * @brief Add a route
+	 * @param pattern Path pattern
+	 * @param route Value to return when this route matches
+	 * @retval bool false if the pattern is invalid
+	 * @note If an equivalent pattern has already been added it takes precedence
+	 */
+	bool add(const String& pattern, uint16_t route);
+
+	/**
+	 * @brief Find the route which best matches a path
+	 * @param path
+	 * @param length
+	 * @param match On success, receives route identifier and parameter locations
+	 * @retval bool true if a route matched
+	 */
+	bool match(const char* path, size_t length, Match& match) const;
+
+	bool match(const String& path, Match& match) const
+	{
+		return this->match(path.c_str(), path.length(), match);
+	}
+
+	/**
+	 * @brief Remove all routes
+	 */
+	void clear();
+
+	bool isEmpty() const
+	{
+		return root == nullptr;
+	}
+
+private:
+	struct Node;
+
+	Node* addLiteral(Node& parent, const char* text, size_t length);
+	bool matchNode(const Node& node, const char* path, size_t length, size_t pos, Match& match) const;
+
+	Node* root{nullptr};
+};
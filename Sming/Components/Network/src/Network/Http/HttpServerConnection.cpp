@@ -16,6 +16,8 @@
 #include "Network/TcpServer.h"
 #include <Data/WebConstants.h>
 #include "Data/Stream/ChunkedStream.h"
+#include "Data/Stream/MultipartRangeStream.h"
+#include <Data/Stream/RangeStream.h>
 #include <SystemClock.h>
 
 #if HTTP_SERVER_EXPOSE_VERSION == 1
@@ -49,10 +51,7 @@ int HttpServerConnection::onPath(const Url& uri)
 
 	request.setURL(uri);
 
-	resource = resourceTree->find(request.uri.Path);
-	if(resource == nullptr) {
-		resource = resourceTree->getDefault();
-	}
+	resource = resourceTree->match(request.uri.Path, &request.pathParams);
 
 	return resource ? resource->handleUrl(*this, request, response) : 0;
 }
@@ -62,8 +61,8 @@ int HttpServerConnection::onMessageComplete(http_parser* parser)
 	// we are finished with this request
 	int hasError = 0;
 
-	if(bodyParser) {
-		bodyParser(request, nullptr, PARSE_DATAEND);
+	if(bodyParser && bodyParser(request, nullptr, PARSE_DATAEND) != 0) {
+		hasContentError = true;
 	}
 
 	if(hasContentError) {
@@ -102,10 +101,11 @@ int HttpServerConnection::onHeadersComplete(const HttpHeaders& headers)
 	 * useful for handling responses to a CONNECT request which may not contain
 	 * `Upgrade` or `Connection: upgrade` headers.
 	 */
+	// Headers have been parsed directly into `request.headers`, see `getIncomingHeaders()`
 	int error = 0;
-	request.setHeaders(headers);
 
 	if(resource != nullptr) {
+		request.formFields = resource->formFields;
 		error = resource->handleHeaders(*this, request, response);
 		if(error != 0) {
 			return error;
@@ -276,6 +276,13 @@ void HttpServerConnection::sendResponseHeaders(HttpResponse* response)
 	}
 #endif /* DISABLE_HTTPSRV_ETAG */
 
+#ifndef DISABLE_HTTPSRV_RANGES
+	if(response->code == HTTP_STATUS_OK && response->stream != nullptr &&
+	   !response->headers.contains(HTTP_HEADER_TRANSFER_ENCODING)) {
+		applyRange(*response);
+	}
+#endif
+
 	String statusLine = F("HTTP/1.1 ");
 	statusLine += unsigned(response->code);
 	statusLine += ' ';
@@ -318,6 +325,76 @@ void HttpServerConnection::sendResponseHeaders(HttpResponse* response)
 	sendString("\r\n");
 }
 
+#ifndef DISABLE_HTTPSRV_RANGES
+/*
+ * Serve partial content as described in RFC 7233.
+ * The stream must be seekable and of known size.
+ */
+void HttpServerConnection::applyRange(HttpResponse& response)
+{
+	auto stream = response.stream;
+	int offset = stream->seekFrom(0, SeekOrigin::Current);
+	int avail = stream->available();
+	if(offset < 0 || avail < 0) {
+		return;
+	}
+
+	response.headers[HTTP_HEADER_ACCEPT_RANGES] = F("bytes");
+	const HttpHeaders& headers = response.headers;
+
+	if(request.method != HTTP_GET || !request.headers.contains(HTTP_HEADER_RANGE)) {
+		return;
+	}
+
+	// Content may have changed since client's previous request: if so, send all of it
+	if(request.headers.contains(HTTP_HEADER_IF_RANGE)) {
+		String validator = request.headers[HTTP_HEADER_IF_RANGE];
+		if(validator.startsWith("W/")) {
+			// Weak entity tags cannot be used for range requests
+			return;
+		}
+		auto& current = headers[validator.startsWith("\"") ? HTTP_HEADER_ETAG : HTTP_HEADER_LAST_MODIFIED];
+		if(validator != current) {
+			return;
+		}
+	}
+
+	size_t contentLength = avail;
+	HttpRangeList ranges;
+	switch(ranges.parse(request.headers[HTTP_HEADER_RANGE].c_str(), contentLength)) {
+	case HttpRangeList::Result::ignore:
+		return;
+
+	case HttpRangeList::Result::unsatisfiable:
+		response.code = HTTP_STATUS_RANGE_NOT_SATISFIABLE;
+		response.headers[HTTP_HEADER_CONTENT_RANGE] = HttpRangeList::getUnsatisfiedRange(contentLength);
+		response.headers[HTTP_HEADER_CONTENT_LENGTH] = "0";
+		delete response.stream;
+		response.stream = nullptr;
+		return;
+
+	case HttpRangeList::Result::ok:
+		break;
+	}
+
+	response.code = HTTP_STATUS_PARTIAL_CONTENT;
+
+	if(ranges.count() == 1) {
+		auto& range = ranges[0];
+		response.headers[HTTP_HEADER_CONTENT_RANGE] = HttpRangeList::getContentRange(range, contentLength);
+		response.stream = new RangeStream(stream, offset + range.start, range.length);
+		return;
+	}
+
+	String contentType = headers[HTTP_HEADER_CONTENT_TYPE];
+	auto multipart = new MultipartRangeStream(stream, offset, ranges, contentLength, contentType);
+	String s = F("multipart/byteranges; boundary=");
+	s += multipart->getBoundary();
+	response.headers[HTTP_HEADER_CONTENT_TYPE] = s;
+	response.stream = multipart;
+}
+#endif
+
 bool HttpServerConnection::sendResponseBody(HttpResponse* response)
 {
 	if(state == eHCS_StartBody) {
@@ -18,6 +18,14 @@
 
 #include <functional>
 
+/**
+ * @brief Size of per-connection arena used to store incoming request headers
+ * @note Set to 0 to disable
+ */
+#ifndef HTTP_REQUEST_ARENA_SIZE
+#define HTTP_REQUEST_ARENA_SIZE 512
+#endif
+
 /** @ingroup   	httpserver
  *  @brief      Provides http server connection
  *  @{
@@ -35,6 +43,7 @@ class HttpServerConnection : public HttpConnection
 public:
 	HttpServerConnection(tcp_pcb* clientTcp) : HttpConnection(clientTcp, HTTP_REQUEST)
 	{
+		request.headers.enableArena(HTTP_REQUEST_ARENA_SIZE);
 	}
 
 	~HttpServerConnection()
@@ -94,6 +103,11 @@ protected:
 	int onBody(const char* at, size_t length) override;
 	int onMessageComplete(http_parser* parser) override;
 
+	HttpHeaders& getIncomingHeaders() override
+	{
+		return request.headers;
+	}
+
 	bool onProtocolUpgrade(http_parser* parser) override
 	{
 		if(upgradeCallback) {
@@ -111,6 +125,7 @@ protected:
 
 private:
 	void sendResponseHeaders(HttpResponse* response);
+	void applyRange(HttpResponse& response);
 	bool sendResponseBody(HttpResponse* response);
 
 public:
@@ -28,6 +28,108 @@ DEFINE_FSTR(WSSTR_VERSION, "Sec-WebSocket-Version")
 DEFINE_FSTR(WSSTR_SECRET, "258EAFA5-E914-47DA-95CA-C5AB0DC85B11")
 
 WebsocketList WebsocketConnection::websocketList;
+WsBroadcastStats WebsocketConnection::broadcastStats;
+
+class WsBroadcastStream;
+
+/**
+ * @brief Tracks broadcast data queued for a connection
+ * @note Shared with the queued streams as these may outlive the connection object
+ */
+struct WsBroadcastQueue {
+	size_t bytes{0};					 ///< Queued data not yet sent
+	WsBroadcastStream* pending{nullptr}; ///< Most recent stream if nothing has been read from it yet
+};
+
+/**
+ * @brief Stream referencing a shared, pre-encoded broadcast frame
+ */
+class WsBroadcastStream : public IDataSourceStream
+{
+public:
+	WsBroadcastStream(std::shared_ptr<WsBroadcastQueue> queue, std::shared_ptr<const char> frame, size_t length)
+		: queue(queue), frame(frame), length(length)
+	{
+		queue->bytes += length;
+		queue->pending = this;
+	}
+
+	~WsBroadcastStream()
+	{
+		queue->bytes -= length - readPos;
+		start();
+	}
+
+	/**
+	 * @brief Replace content before anything has been read
+	 */
+	void replace(const std::shared_ptr<const char>& frame, size_t length)
+	{
+		queue->bytes += length;
+		queue->bytes -= this->length;
+		this->frame = frame;
+		this->length = length;
+	}
+
+	StreamType getStreamType() const override
+	{
+		return eSST_Memory;
+	}
+
+	int available() override
+	{
+		return length - readPos;
+	}
+
+	uint16_t readMemoryBlock(char* data, int bufSize) override
+	{
+		start();
+		size_t count = std::min(size_t(bufSize), length - readPos);
+		memcpy(data, frame.get() + readPos, count);
+		return count;
+	}
+
+	size_t peekMemoryBlock(size_t offset, const char*& data) override
+	{
+		// Content may be referenced by the TCP stack so must not be replaced from here on
+		start();
+		size_t pos = readPos + offset;
+		if(pos >= length) {
+			return 0;
+		}
+		data = frame.get() + pos;
+		return length - pos;
+	}
+
+	bool seek(int len) override
+	{
+		if(len < 0 || readPos + len > length) {
+			return false;
+		}
+		start();
+		readPos += len;
+		queue->bytes -= len;
+		return true;
+	}
+
+	bool isFinished() override
+	{
+		return readPos >= length;
+	}
+
+private:
+	void start()
+	{
+		if(queue->pending == this) {
+			queue->pending = nullptr;
+		}
+	}
+
+	std::shared_ptr<WsBroadcastQueue> queue;
+	std::shared_ptr<const char> frame;
+	size_t length;
+	size_t readPos{0};
+};
 
 /** @brief ws_parser function table
  * 	@note stored in flash memory; as it is word-aligned it can be accessed directly
@@ -215,93 +317,144 @@ bool WebsocketConnection::send(IDataSourceStream* source, ws_frame_type_t type,
 
 	debug_d("Sending: %d bytes, Type: %d\n", available, type);
 
-	size_t packetLength = 2;
-	uint16_t lengthValue = available;
+	uint8_t packet[WEBSOCKET_MAX_HEADER_SIZE];
+	size_t packetLength;
+	if(useMask) {
+		uint32_t key = os_random();
+		uint8_t maskKey[4];
+		memcpy(maskKey, &key, sizeof(maskKey));
+		packetLength = encodeFrameHeader(packet, available, type, maskKey, isFin);
 
-	// calculate message length ....
-	if(available <= 125) {
-		lengthValue = available;
-	} else if(available < 65536) {
-		lengthValue = 126;
-		packetLength += 2;
+		auto xorStream = new XorOutputStream(source, maskKey, sizeof(maskKey));
+		source = xorStream;
 	} else {
-		lengthValue = 127;
-		packetLength += 8;
+		packetLength = encodeFrameHeader(packet, available, type, nullptr, isFin);
 	}
 
-	if(useMask) {
-		packetLength += 4; // we use mask with size 4 bytes
+	// send the header
+	if(!connection->send(reinterpret_cast<const char*>(packet), packetLength)) {
+		delete source;
+		return false;
 	}
 
-	uint8_t packet[packetLength];
-	memset(packet, 0, packetLength);
+	return connection->send(source);
+}
 
-	int i = 0;
+size_t WebsocketConnection::encodeFrameHeader(uint8_t* buffer, uint64_t payloadLength, ws_frame_type_t type,
+											  const uint8_t* mask, bool isFin)
+{
+	unsigned i = 0;
 	// byte 0
-	if(isFin) {
-		packet[i] |= bit(7); // set Fin
-	}
-	packet[i++] |= (uint8_t)type; // set opcode
+	buffer[i++] = (isFin ? bit(7) : 0) | uint8_t(type);
 	// byte 1
-	if(useMask) {
-		packet[i] |= bit(7); // set mask
-	}
+	uint8_t maskFlag = mask ? bit(7) : 0;
 
 	// length
-	if(lengthValue < 126) {
-		packet[i++] |= lengthValue;
-	} else if(lengthValue == 126) {
-		packet[i++] |= 126;
-		packet[i++] = (available >> 8) & 0xFF;
-		packet[i++] = available & 0xFF;
-	} else if(lengthValue == 127) {
-		packet[i++] |= 127;
-		packet[i++] = 0;
-		packet[i++] = 0;
-		packet[i++] = 0;
-		packet[i++] = 0;
-		packet[i++] = (available >> 24) & 0xFF;
-		packet[i++] = (available >> 16) & 0xFF;
-		packet[i++] = (available >> 8) & 0xFF;
-		packet[i++] = (available)&0xFF;
+	if(payloadLength <= 125) {
+		buffer[i++] = maskFlag | uint8_t(payloadLength);
+	} else if(payloadLength < 65536) {
+		buffer[i++] = maskFlag | 126;
+		buffer[i++] = (payloadLength >> 8) & 0xFF;
+		buffer[i++] = payloadLength & 0xFF;
+	} else {
+		buffer[i++] = maskFlag | 127;
+		for(int shift = 56; shift >= 0; shift -= 8) {
+			buffer[i++] = (payloadLength >> shift) & 0xFF;
+		}
 	}
 
-	if(useMask) {
-		uint8_t maskKey[4] = {0x00, 0x00, 0x00, 0x00};
-		for(uint8_t x = 0; x < sizeof(maskKey); x++) {
-			maskKey[x] = (char)os_random();
-			packet[i++] = maskKey[x];
+	if(mask != nullptr) {
+		memcpy(&buffer[i], mask, 4);
+		i += 4;
+	}
+
+	return i;
+}
+
+void WebsocketConnection::broadcast(const char* message, size_t length, ws_frame_type_t type)
+{
+	uint8_t header[WEBSOCKET_MAX_HEADER_SIZE];
+	size_t headerLength = encodeFrameHeader(header, length, type);
+	size_t frameLength = headerLength + length;
+	auto buffer = new char[frameLength];
+	if(buffer == nullptr) {
+		debug_e("Unable to allocate broadcast frame");
+		return;
+	}
+	memcpy(buffer, header, headerLength);
+	memcpy(&buffer[headerLength], message, length);
+	std::shared_ptr<const char> frame(buffer, [](const char* ptr) { delete[] ptr; });
+	++broadcastStats.frames;
+
+	// Connections may be closed by backpressure handling, which removes them from the list
+	for(unsigned i = websocketList.count(); i-- > 0;) {
+		if(i >= websocketList.count()) {
+			continue;
 		}
+		auto ws = websocketList[i];
+		if(ws->isClientConnection) {
+			// Client frames must be individually masked
+			ws->send(message, length, type);
+		} else {
+			ws->sendBroadcastFrame(frame, frameLength);
+		}
+	}
+}
 
-		auto xorStream = new XorOutputStream(source, maskKey, sizeof(maskKey));
-		source = xorStream;
+bool WebsocketConnection::sendBroadcastFrame(const std::shared_ptr<const char>& frame, size_t length)
+{
+	if(connection == nullptr || !activated) {
+		return false;
 	}
 
-	// send the header
-	if(!connection->send(reinterpret_cast<const char*>(packet), packetLength)) {
-		delete source;
+	if(!broadcastQueue) {
+		broadcastQueue = std::make_shared<WsBroadcastQueue>();
+	}
+
+	auto& queue = *broadcastQueue;
+	if(queue.bytes != 0 && queue.bytes + length > broadcastLimit) {
+		switch(broadcastPolicy) {
+		case WsBroadcastPolicy::Coalesce:
+			if(queue.pending != nullptr) {
+				queue.pending->replace(frame, length);
+				++broadcastStats.coalesced;
+				return true;
+			}
+			++broadcastStats.dropped;
+			return false;
+
+		case WsBroadcastPolicy::Disconnect:
+			debug_w("WS broadcast queue full (%u bytes), closing connection", queue.bytes);
+			++broadcastStats.disconnected;
+			close();
+			return false;
+
+		case WsBroadcastPolicy::Drop:
+		default:
+			++broadcastStats.dropped;
+			return false;
+		}
+	}
+
+	auto stream = new WsBroadcastStream(broadcastQueue, frame, length);
+	if(stream == nullptr || !connection->send(stream)) {
 		return false;
 	}
 
-	return connection->send(source);
+	++broadcastStats.queued;
+	return true;
 }
 
-void WebsocketConnection::broadcast(const char* message, size_t length, ws_frame_type_t type)
+size_t WebsocketConnection::getBroadcastQueued() const
 {
-	char* copy = new char[length];
-	memcpy(copy, message, length);
-	std::shared_ptr<const char> data(copy, [](const char* ptr) { delete[] ptr; });
-
-	for(unsigned i = 0; i < websocketList.count(); i++) {
-		auto stream = new SharedMemoryStream<const char>(data, length);
-		websocketList[i]->send(stream, type);
-	}
+	return broadcastQueue ? broadcastQueue->bytes : 0;
 }
 
 void WebsocketConnection::close()
 {
 	debug_d("Terminating Websocket connection.");
 	websocketList.removeElement(this);
+	broadcastQueue.reset();
 	if(state != eWSCS_Closed) {
 		state = eWSCS_Closed;
 		if(isClientConnection) {
@@ -12,6 +12,7 @@
 
 #include "Network/TcpServer.h"
 #include "../HttpConnection.h"
+#include <memory>
 
 extern "C" {
 #include "ws_parser/ws_parser.h"
@@ -25,6 +26,19 @@ extern "C" {
 
 #define WEBSOCKET_VERSION 13 // 1.3
 
+/**
+ * @brief Default limit on broadcast data queued for a single connection, in bytes
+ * @see WebsocketConnection::setBroadcastLimit()
+ */
+#ifndef WEBSOCKET_BROADCAST_QUEUE_SIZE
+#define WEBSOCKET_BROADCAST_QUEUE_SIZE 4096
+#endif
+
+/**
+ * @brief Maximum size of an encoded frame header
+ */
+#define WEBSOCKET_MAX_HEADER_SIZE 14
+
 DECLARE_FSTR(WSSTR_CONNECTION)
 DECLARE_FSTR(WSSTR_UPGRADE)
 DECLARE_FSTR(WSSTR_WEBSOCKET)
@@ -36,6 +50,7 @@ DECLARE_FSTR(WSSTR_VERSION)
 DECLARE_FSTR(WSSTR_SECRET)
 
 class WebsocketConnection;
+struct WsBroadcastQueue;
 
 using WebsocketList = Vector<WebsocketConnection*>;
 
@@ -52,6 +67,26 @@ enum WsConnectionState {
 	eWSCS_Closed,
 };
 
+/**
+ * @brief Determines what happens when a broadcast frame would exceed a connection's queue limit
+ */
+enum class WsBroadcastPolicy {
+	Drop,		///< Discard the new frame for this connection
+	Coalesce,   ///< Replace the most recent unsent frame with the new one (latest value wins)
+	Disconnect, ///< Close the connection
+};
+
+/**
+ * @brief Counters maintained by `WebsocketConnection::broadcast()`
+ */
+struct WsBroadcastStats {
+	uint32_t frames;	   ///< Frames encoded
+	uint32_t queued;	   ///< Frames queued to connections
+	uint32_t dropped;	  ///< Frames discarded due to backpressure
+	uint32_t coalesced;	///< Frames which replaced an unsent frame
+	uint32_t disconnected; ///< Connections closed due to backpressure
+};
+
 struct WsFrameInfo {
 	ws_frame_type_t type = WS_FRAME_TEXT;
 	char* payload = nullptr;
@@ -123,6 +158,10 @@ public:
 	 * @param message
 	 * @param length
 	 * @param type
+	 *
+	 * The frame is encoded once into a shared buffer which is referenced by every server connection.
+	 * Where a connection already has more than its limit of broadcast data queued,
+	 * the frame is handled according to the connection's `WsBroadcastPolicy`.
 	 */
 	static void broadcast(const char* message, size_t length, ws_frame_type_t type = WS_FRAME_TEXT);
 
@@ -275,6 +314,7 @@ public:
 	{
 		this->connection = connection;
 		this->isClientConnection = isClientConnection;
+		broadcastQueue.reset();
 	}
 
 	/** @brief  Gets the state of the websocket connection
@@ -285,6 +325,45 @@ public:
 		return state;
 	}
 
+	/**
+	 * @brief Set backpressure limit for broadcast messages
+	 * @param maxBytes Amount of broadcast data which may be queued for this connection
+	 * @param policy How to deal with frames which would exceed the limit
+	 * @note A frame is always accepted if nothing is queued, regardless of its size
+	 */
+	void setBroadcastLimit(size_t maxBytes, WsBroadcastPolicy policy = WsBroadcastPolicy::Drop)
+	{
+		broadcastLimit = maxBytes;
+		broadcastPolicy = policy;
+	}
+
+	/**
+	 * @brief Get amount of broadcast data queued for this connection but not yet sent
+	 */
+	size_t getBroadcastQueued() const;
+
+	static const WsBroadcastStats& getBroadcastStats()
+	{
+		return broadcastStats;
+	}
+
+	static void resetBroadcastStats()
+	{
+		broadcastStats = {};
+	}
+
+	/**
+	 * @brief Encode a frame header
+	 * @param buffer Must have room for at least WEBSOCKET_MAX_HEADER_SIZE bytes
+	 * @param payloadLength
+	 * @param type
+	 * @param mask Masking key (4 bytes), nullptr for an unmasked frame
+	 * @param isFin true if this is the final frame
+	 * @retval size_t Number of bytes written to `buffer`
+	 */
+	static size_t encodeFrameHeader(uint8_t* buffer, uint64_t payloadLength, ws_frame_type_t type,
+									const uint8_t* mask = nullptr, bool isFin = true);
+
 protected:
 	// Static handlers for ws_parser
 	static int staticOnDataBegin(void* userData, ws_frame_type_t type);
@@ -302,6 +381,8 @@ protected:
 	 */
 	bool processFrame(TcpClient& client, char* at, int size);
 
+	bool sendBroadcastFrame(const std::shared_ptr<const char>& frame, size_t length);
+
 protected:
 	WebsocketDelegate wsConnect = nullptr;
 	WebsocketMessageDelegate wsMessage = nullptr;
@@ -321,6 +402,11 @@ private:
 	static const ws_parser_callbacks_t parserSettings;
 
 	static WebsocketList websocketList;
+	static WsBroadcastStats broadcastStats;
+
+	std::shared_ptr<WsBroadcastQueue> broadcastQueue;
+	size_t broadcastLimit = WEBSOCKET_BROADCAST_QUEUE_SIZE;
+	WsBroadcastPolicy broadcastPolicy = WsBroadcastPolicy::Drop;
 
 	bool isClientConnection = true;
 
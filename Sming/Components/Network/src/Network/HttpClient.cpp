@@ -14,36 +14,105 @@
 #include "Data/Stream/FileStream.h"
 
 HttpClient::HttpConnectionPool HttpClient::httpConnectionPool;
-SimpleTimer HttpClient::cleanUpTimer;
+HttpClientSettings HttpClient::settings;
+HttpClientStats HttpClient::stats;
+SimpleTimer HttpClient::idleTimer;
 
-bool HttpClient::send(HttpRequest* request)
+void HttpClient::HttpConnectionPool::clear()
+{
+	for(auto& entry : *this) {
+		delete entry.connection;
+	}
+	Vector::clear();
+}
+
+void HttpClient::HttpConnectionPool::removeAt(unsigned index)
 {
-	String cacheKey = getCacheKey(request->uri);
+	delete operator[](index).connection;
+	removeElementAt(index);
+}
 
-	HttpClientConnection* connection = nullptr;
+void HttpClient::configure(const HttpClientSettings& settings)
+{
+	HttpClient::settings = settings;
+	for(auto& entry : httpConnectionPool) {
+		entry.connection->setPipelining(settings.pipelining);
+	}
+	scheduleIdleCheck();
+}
 
-	int i = httpConnectionPool.indexOf(cacheKey);
-	if(i >= 0) {
-		// Check existing connection
-		connection = httpConnectionPool.valueAt(i);
+unsigned HttpClient::getQueueDepth()
+{
+	unsigned depth = 0;
+	for(auto& entry : httpConnectionPool) {
+		depth += entry.connection->getQueueDepth();
 	}
+	return depth;
+}
 
+bool HttpClient::send(HttpRequest* request)
+{
+	auto connection = getConnection(getCacheKey(request->uri));
 	if(connection == nullptr) {
-		debug_d("Creating new HttpClientConnection");
-		connection = new HttpClientConnection();
-		if(connection == nullptr) {
-			debug_e("Cannot send request. Out of memory");
-			// Out of memory
-			delete request;
-			return false;
+		debug_e("Cannot send request. Out of memory");
+		delete request;
+		return false;
+	}
+
+	++stats.requests;
+	bool res = connection->send(request);
+
+	auto depth = getQueueDepth();
+	if(depth > stats.maxQueueDepth) {
+		stats.maxQueueDepth = depth;
+	}
+
+	scheduleIdleCheck();
+	return res;
+}
+
+HttpClientConnection* HttpClient::getConnection(const String& key)
+{
+	HttpClientConnection* idle = nullptr; // Most recently used idle connection
+	HttpClientConnection* busy = nullptr; // Busy connection with fewest queued requests
+	unsigned hostConnections = 0;
+	for(auto& entry : httpConnectionPool) {
+		if(entry.key != key) {
+			continue;
+		}
+		++hostConnections;
+		auto connection = entry.connection;
+		if(connection->isFinished()) {
+			if(idle == nullptr || int32_t(connection->getLastActivity() - idle->getLastActivity()) > 0) {
+				idle = connection;
+			}
+		} else if(busy == nullptr || connection->getQueueDepth() < busy->getQueueDepth()) {
+			busy = connection;
+		}
+	}
+
+	auto connection = idle;
+	if(connection == nullptr && hostConnections >= settings.maxHostConnections) {
+		connection = busy;
+	}
+
+	if(connection != nullptr) {
+		if(connection->getConnectionState() == eTCS_Connected) {
+			++stats.reused;
 		}
-		httpConnectionPool[cacheKey] = connection;
+		return connection;
 	}
 
-	if(!cleanUpTimer.isStarted()) {
-		cleanUpTimer.initializeMs<60000>(HttpClient::cleanInactive).start(); // run every minute
+	debug_d("Creating new HttpClientConnection");
+	connection = new HttpClientConnection();
+	if(connection == nullptr) {
+		return nullptr;
 	}
-	return connection->send(request);
+	connection->setPipelining(settings.pipelining);
+	connection->setStats(&stats);
+	httpConnectionPool.add(PoolEntry{key, connection});
+	++stats.connections;
+	return connection;
 }
 
 bool HttpClient::downloadFile(const Url& url, const String& saveFileName, RequestCompletedDelegate requestComplete)
@@ -64,17 +133,66 @@ bool HttpClient::downloadFile(const Url& url, const String& saveFileName, Reques
 		createRequest(url)->setResponseStream(fileStream)->setMethod(HTTP_GET)->onRequestComplete(requestComplete));
 }
 
-void HttpClient::cleanInactive()
+/*
+ * Requests are commonly sent from a completion callback, so the connection running that callback
+ * must not be destroyed here. Eviction is deferred to the idle timer callback instead.
+ */
+void HttpClient::scheduleIdleCheck()
+{
+	idleTimer.initializeMs(1, HttpClient::checkIdle).startOnce();
+}
+
+void HttpClient::checkIdle()
 {
-	debug_d("Total connections: %d", httpConnectionPool.count());
+	uint32_t now = millis();
+	uint32_t timeout = settings.idleTimeout * 1000U;
+	uint32_t nextCheck = timeout;
+	unsigned idleCount = 0;
 
-	for(size_t i = 0; i < httpConnectionPool.count(); i++) {
-		auto connection = httpConnectionPool.valueAt(i);
+	// Release connections which have been idle too long or closed by the server
+	for(unsigned i = 0; i < httpConnectionPool.count();) {
+		auto connection = httpConnectionPool[i].connection;
+		if(!connection->isFinished()) {
+			++i;
+			continue;
+		}
 
-		if(connection->getConnectionState() > eTCS_Connecting && !connection->isActive()) {
-			debug_d("Removing stale connection: State: %d, Active: %d, Finished: %d", connection->getConnectionState(),
-					connection->isActive(), connection->isFinished());
+		uint32_t age = now - connection->getLastActivity();
+		if(age >= timeout || (connection->getConnectionState() > eTCS_Connecting && !connection->isActive())) {
+			debug_d("Removing idle connection: State: %d, Active: %d", connection->getConnectionState(),
+					connection->isActive());
 			httpConnectionPool.removeAt(i);
+			++stats.evicted;
+			continue;
+		}
+
+		nextCheck = std::min(nextCheck, timeout - age);
+		++idleCount;
+		++i;
+	}
+
+	// Close least-recently used connections
+	for(; idleCount > settings.maxIdleConnections; --idleCount) {
+		int lru = -1;
+		for(unsigned i = 0; i < httpConnectionPool.count(); ++i) {
+			auto connection = httpConnectionPool[i].connection;
+			if(!connection->isFinished()) {
+				continue;
+			}
+			if(lru < 0 ||
+			   int32_t(connection->getLastActivity() - httpConnectionPool[lru].connection->getLastActivity()) < 0) {
+				lru = i;
+			}
 		}
+		debug_d("Removing least-recently used connection");
+		httpConnectionPool.removeAt(lru);
+		++stats.evicted;
 	}
+
+	if(httpConnectionPool.count() == 0) {
+		idleTimer.stop();
+		return;
+	}
+
+	idleTimer.initializeMs(std::max(nextCheck, uint32_t(1)), HttpClient::checkIdle).startOnce();
 }
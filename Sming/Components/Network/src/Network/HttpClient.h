@@ -25,6 +25,16 @@
 #include "Data/Stream/LimitedMemoryStream.h"
 #include <SimpleTimer.h>
 
+/**
+ * @brief Connection pool settings for HttpClient
+ */
+struct HttpClientSettings {
+	uint8_t maxHostConnections{1}; ///< Maximum simultaneous connections to a single host and port
+	uint8_t maxIdleConnections{4}; ///< Idle connections kept open for re-use, least-recently used are closed first
+	uint16_t idleTimeout{60};	  ///< Seconds to keep an idle connection open
+	bool pipelining{false};		   ///< Send idempotent requests without waiting for preceding responses
+};
+
 class HttpClient
 {
 public:
@@ -128,6 +138,43 @@ public:
 		httpConnectionPool.clear();
 	}
 
+	/**
+	 * @brief Change connection pool settings
+	 * @note Pipelining setting is applied to existing connections
+	 */
+	static void configure(const HttpClientSettings& settings);
+
+	static const HttpClientSettings& getSettings()
+	{
+		return settings;
+	}
+
+	/**
+	 * @brief Get statistics for all connections
+	 */
+	static const HttpClientStats& getStats()
+	{
+		return stats;
+	}
+
+	static void resetStats()
+	{
+		stats = HttpClientStats{};
+	}
+
+	/**
+	 * @brief Get number of requests currently waiting or in progress
+	 */
+	static unsigned getQueueDepth();
+
+	/**
+	 * @brief Get number of connections in the pool
+	 */
+	static unsigned getConnectionCount()
+	{
+		return httpConnectionPool.count();
+	}
+
 protected:
 	String getCacheKey(const Url& url)
 	{
@@ -135,12 +182,36 @@ protected:
 	}
 
 protected:
-	using HttpConnectionPool = ObjectMap<String, HttpClientConnection>;
+	struct PoolEntry {
+		String key;						  ///< host:port
+		HttpClientConnection* connection; ///< Owned by pool
+	};
+
+	/**
+	 * @brief Contains all client connections, there may be several for each host
+	 */
+	class HttpConnectionPool : public Vector<PoolEntry>
+	{
+	public:
+		~HttpConnectionPool()
+		{
+			clear();
+		}
+
+		void clear();
+		void removeAt(unsigned index);
+	};
+
 	static HttpConnectionPool httpConnectionPool;
 
 private:
-	static SimpleTimer cleanUpTimer;
-	static void cleanInactive();
+	static HttpClientConnection* getConnection(const String& key);
+	static void scheduleIdleCheck();
+	static void checkIdle();
+
+	static HttpClientSettings settings;
+	static HttpClientStats stats;
+	static SimpleTimer idleTimer;
 };
 
 /** @} */
@@ -35,6 +35,7 @@ TcpConnection* HttpServer::createClient(tcp_pcb* clientTcp)
 	con->setResourceTree(&paths);
 	con->setBodyParsers(&bodyParsers);
 	con->setCloseOnContentError(settings.closeOnContentError);
+	con->setZeroCopy(settings.zeroCopy);
 
 	return con;
 }
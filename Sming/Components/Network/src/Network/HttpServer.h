@@ -31,6 +31,7 @@ struct HttpServerSettings {
 	bool useDefaultBodyParsers = 1; ///< if the default body parsers,  as form-url-encoded, should be used
 	bool closeOnContentError =
 		true; ///< close the connection if a body parser or resource fails to parse the body content.
+	bool zeroCopy = false; ///< send memory and flash-based responses by reference, see TcpConnection::setZeroCopy()
 };
 
 class HttpServer : public TcpServer
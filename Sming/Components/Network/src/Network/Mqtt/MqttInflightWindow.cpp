@@ -0,0 +1,124 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MqttInflightWindow.cpp
+ *
+ ****/
+
+#include "MqttInflightWindow.h"
+
+namespace
+{
+void deleteMessage(mqtt_message_t*& message)
+{
+	if(message != nullptr) {
+		mqtt_message_clear(message, 0);
+		delete message;
+		message = nullptr;
+	}
+}
+
+} // namespace
+
+MqttInflightWindow::Entry* MqttInflightWindow::add(mqtt_message_t* message, uint32_t now)
+{
+	if(full()) {
+		return nullptr;
+	}
+
+	// Identifiers are issued in sequence, skipping any whose slot is still in use
+	for(;;) {
+		uint16_t id = nextId++;
+		if(nextId == 0) {
+			nextId = 1;
+		}
+		auto& entry = entries[id % capacity];
+		if(entry.state != State::Free) {
+			continue;
+		}
+
+		entry.message = message;
+		entry.sequence = sequence++;
+		entry.sentTime = now;
+		entry.id = id;
+		entry.state = State::AwaitingAck;
+		entry.pending = false;
+		++used;
+		message->publish.message_id = id;
+		return &entry;
+	}
+}
+
+void MqttInflightWindow::release(Entry& entry)
+{
+	deleteMessage(entry.message);
+	entry.state = State::AwaitingComp;
+	setPending(entry);
+}
+
+void MqttInflightWindow::setPending(Entry& entry)
+{
+	if(!entry.pending) {
+		entry.pending = true;
+		++pendingCount;
+	}
+}
+
+void MqttInflightWindow::remove(Entry& entry)
+{
+	deleteMessage(entry.message);
+	if(entry.pending) {
+		--pendingCount;
+	}
+	entry = Entry{};
+	--used;
+}
+
+unsigned MqttInflightWindow::resendAll()
+{
+	unsigned dropped{0};
+	for(auto& entry : entries) {
+		if(entry.state == State::Free || entry.pending) {
+			continue;
+		}
+		if(entry.state == State::AwaitingAck && entry.message == nullptr) {
+			remove(entry);
+			++dropped;
+			continue;
+		}
+		entry.pending = true;
+		++pendingCount;
+	}
+	return dropped;
+}
+
+MqttInflightWindow::Entry* MqttInflightWindow::nextPending()
+{
+	if(pendingCount == 0) {
+		return nullptr;
+	}
+
+	Entry* oldest{nullptr};
+	for(auto& entry : entries) {
+		if(entry.pending && (oldest == nullptr || int32_t(entry.sequence - oldest->sequence) < 0)) {
+			oldest = &entry;
+		}
+	}
+
+	oldest->pending = false;
+	--pendingCount;
+	return oldest;
+}
+
+void MqttInflightWindow::clear()
+{
+	for(auto& entry : entries) {
+		deleteMessage(entry.message);
+		entry = Entry{};
+	}
+	used = 0;
+	pendingCount = 0;
+}
@@ -0,0 +1,139 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MqttInflightWindow.h - Tracks outgoing QoS 1 and 2 messages awaiting acknowledgement
+ *
+ ****/
+
+#pragma once
+
+#include <mqtt-codec/src/message.h>
+
+#ifndef MQTT_INFLIGHT_WINDOW_SIZE
+#define MQTT_INFLIGHT_WINDOW_SIZE 8
+#endif
+
+/**
+ * @brief Holds published messages until the broker has acknowledged them
+ * @ingroup mqttclient
+ *
+ * Message identifiers are allocated so that each maps to its own slot (id % window size),
+ * so acknowledgements are matched without searching.
+ *
+ * Messages are retained so they can be re-sent with the DUP flag set if the connection is lost.
+ * For QoS 2, the message itself is released on receipt of PUBREC and only the identifier
+ * is kept until PUBCOMP arrives.
+ */
+class MqttInflightWindow
+{
+public:
+	enum class State : uint8_t {
+		Free,
+		AwaitingAck,  ///< PUBLISH sent, waiting for PUBACK (QoS 1) or PUBREC (QoS 2)
+		AwaitingComp, ///< PUBREL sent, waiting for PUBCOMP
+	};
+
+	struct Entry {
+		mqtt_message_t* message; ///< Retained for re-sending, null if this is not possible
+		uint32_t sequence;		 ///< Order in which entries were added
+		uint32_t sentTime;		 ///< Time of first transmission, in milliseconds
+		uint16_t id;
+		State state;
+		bool pending; ///< PUBLISH or PUBREL needs to be (re)sent
+	};
+
+	static constexpr unsigned capacity{MQTT_INFLIGHT_WINDOW_SIZE};
+
+	MqttInflightWindow() = default;
+	MqttInflightWindow(const MqttInflightWindow&) = delete;
+
+	~MqttInflightWindow()
+	{
+		clear();
+	}
+
+	/**
+	 * @brief Set maximum number of unacknowledged messages
+	 * @param limit Value is capped at MQTT_INFLIGHT_WINDOW_SIZE
+	 */
+	void setLimit(unsigned limit)
+	{
+		this->limit = (limit == 0 || limit > capacity) ? capacity : limit;
+	}
+
+	unsigned getLimit() const
+	{
+		return limit;
+	}
+
+	unsigned count() const
+	{
+		return used;
+	}
+
+	bool full() const
+	{
+		return used >= limit;
+	}
+
+	/**
+	 * @brief Assign a message identifier and take ownership of a message
+	 * @param message PUBLISH message, with QoS 1 or 2
+	 * @param now Time message is sent, in milliseconds
+	 * @retval Entry* The new entry, null if window is full
+	 */
+	Entry* add(mqtt_message_t* message, uint32_t now);
+
+	/**
+	 * @brief Find entry for an acknowledged message identifier
+	 * @retval Entry* null if not found
+	 */
+	Entry* find(uint16_t id)
+	{
+		auto& entry = entries[id % capacity];
+		return (entry.state != State::Free && entry.id == id) ? &entry : nullptr;
+	}
+
+	/**
+	 * @brief PUBREC received: release message content and schedule PUBREL
+	 */
+	void release(Entry& entry);
+
+	/**
+	 * @brief Schedule an entry to be sent again, e.g. if the previous attempt failed
+	 */
+	void setPending(Entry& entry);
+
+	/**
+	 * @brief Transaction complete: free the entry
+	 */
+	void remove(Entry& entry);
+
+	/**
+	 * @brief Mark all entries to be re-sent, on reconnection
+	 * @retval unsigned Number of entries discarded because they cannot be re-sent
+	 */
+	unsigned resendAll();
+
+	/**
+	 * @brief Get the oldest entry requiring (re)transmission
+	 * @retval Entry* null if none
+	 */
+	Entry* nextPending();
+
+	/**
+	 * @brief Discard all entries
+	 */
+	void clear();
+
+private:
+	Entry entries[capacity]{};
+	unsigned limit{capacity};
+	unsigned used{0};
+	unsigned pendingCount{0};
+	uint32_t sequence{0};
+	uint16_t nextId{1};
+};
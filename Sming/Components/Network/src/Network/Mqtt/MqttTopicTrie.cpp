@@ -0,0 +1,238 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MqttTopicTrie.cpp
+ *
+ ****/
+
+#include "MqttTopicTrie.h"
+#include <debug_progmem.h>
+
+namespace
+{
+/*
+ * Locate end of topic level starting at `pos`.
+ * Returns start of the following level, or nullptr if this is the last one.
+ */
+const char* nextLevel(const char* pos, const char* end, size_t& length)
+{
+	auto sep = static_cast<const char*>(memchr(pos, '/', end - pos));
+	if(sep == nullptr) {
+		length = end - pos;
+		return nullptr;
+	}
+	length = sep - pos;
+	return sep + 1;
+}
+
+bool isWildcard(const char* pos, size_t length, char c)
+{
+	return length == 1 && *pos == c;
+}
+
+} // namespace
+
+struct MqttTopicTrie::Dispatch {
+	MqttClient& client;
+	mqtt_message_t* message;
+	int result;
+	unsigned count;
+
+	void invoke(const MqttDelegate& handler)
+	{
+		int res = handler(client, message);
+		if(res != 0) {
+			result = res;
+		}
+		++count;
+	}
+};
+
+MqttTopicTrie::Node* MqttTopicTrie::Node::findChild(const char* name, size_t length) const
+{
+	for(auto child = children; child != nullptr; child = child->next) {
+		if(child->level.length() == length && memcmp(child->level.c_str(), name, length) == 0) {
+			return child;
+		}
+	}
+	return nullptr;
+}
+
+void MqttTopicTrie::Node::clear()
+{
+	delete plus;
+	plus = nullptr;
+	while(children != nullptr) {
+		auto child = children;
+		children = child->next;
+		delete child;
+	}
+	handler = nullptr;
+	hashHandler = nullptr;
+}
+
+bool MqttTopicTrie::isValidFilter(const String& filter)
+{
+	if(filter.length() == 0) {
+		return false;
+	}
+
+	auto pos = filter.c_str();
+	auto end = pos + filter.length();
+	while(pos != nullptr) {
+		size_t length;
+		auto next = nextLevel(pos, end, length);
+		// Wildcards must occupy an entire level, and '#' must be the last one
+		if(length > 1 && memchr(pos, '+', length) != nullptr) {
+			return false;
+		}
+		auto hash = static_cast<const char*>(memchr(pos, '#', length));
+		if(hash != nullptr && (length > 1 || next != nullptr)) {
+			return false;
+		}
+		pos = next;
+	}
+
+	return true;
+}
+
+bool MqttTopicTrie::add(const String& filter, MqttDelegate handler)
+{
+	if(!isValidFilter(filter)) {
+		debug_w("[MQTT] Invalid topic filter '%s'", filter.c_str());
+		return false;
+	}
+
+	auto node = &root;
+	auto pos = filter.c_str();
+	auto end = pos + filter.length();
+	while(pos != nullptr) {
+		size_t length;
+		auto next = nextLevel(pos, end, length);
+		if(isWildcard(pos, length, '#')) {
+			node->hashHandler = handler;
+			return true;
+		}
+
+		Node* child;
+		if(isWildcard(pos, length, '+')) {
+			if(node->plus == nullptr) {
+				node->plus = new Node;
+			}
+			child = node->plus;
+		} else {
+			child = node->findChild(pos, length);
+			if(child == nullptr) {
+				child = new Node;
+				child->level.setString(pos, length);
+				child->next = node->children;
+				node->children = child;
+			}
+		}
+		node = child;
+		pos = next;
+	}
+
+	node->handler = handler;
+	return true;
+}
+
+bool MqttTopicTrie::remove(const String& filter)
+{
+	if(!isValidFilter(filter)) {
+		return false;
+	}
+	return remove(root, filter.c_str(), filter.c_str() + filter.length());
+}
+
+/*
+ * Remove filter below `node`, pruning any nodes left empty
+ */
+bool MqttTopicTrie::remove(Node& node, const char* pos, const char* end)
+{
+	size_t length;
+	auto next = nextLevel(pos, end, length);
+	if(isWildcard(pos, length, '#')) {
+		if(!node.hashHandler) {
+			return false;
+		}
+		node.hashHandler = nullptr;
+		return true;
+	}
+
+	Node** link;
+	if(isWildcard(pos, length, '+')) {
+		link = &node.plus;
+	} else {
+		auto child = node.findChild(pos, length);
+		link = &node.children;
+		while(*link != child) {
+			link = &(*link)->next;
+		}
+	}
+
+	auto child = *link;
+	if(child == nullptr) {
+		return false;
+	}
+
+	bool found;
+	if(next != nullptr) {
+		found = remove(*child, next, end);
+	} else {
+		found = bool(child->handler);
+		child->handler = nullptr;
+	}
+
+	if(found && child->isEmpty()) {
+		*link = (link == &node.plus) ? nullptr : child->next;
+		delete child;
+	}
+
+	return found;
+}
+
+/*
+ * Match topic levels from `pos` against the children of `node`.
+ * `pos` is null when all levels have been consumed.
+ */
+void MqttTopicTrie::match(const Node& node, const char* pos, const char* end, Dispatch& dispatch) const
+{
+	// Wildcards in the first level don't match system topics such as `$SYS/...`
+	bool wildcards = (&node != &root) || pos == nullptr || pos == end || *pos != '$';
+
+	// '#' also matches the parent level
+	if(node.hashHandler && wildcards) {
+		dispatch.invoke(node.hashHandler);
+	}
+
+	if(pos == nullptr) {
+		if(node.handler) {
+			dispatch.invoke(node.handler);
+		}
+		return;
+	}
+
+	size_t length;
+	auto next = nextLevel(pos, end, length);
+	auto child = node.findChild(pos, length);
+	if(child != nullptr) {
+		match(*child, next, end, dispatch);
+	}
+	if(node.plus != nullptr && wildcards) {
+		match(*node.plus, next, end, dispatch);
+	}
+}
+
+unsigned MqttTopicTrie::dispatch(MqttClient& client, mqtt_message_t* message, int& result) const
+{
+	Dispatch dispatch{client, message, 0, 0};
+	auto& topic = message->publish.topic_name;
+	auto pos = reinterpret_cast<const char*>(topic.data);
+	match(root, pos, pos + topic.length, dispatch);
+	result = dispatch.result;
+	return dispatch.count;
+}
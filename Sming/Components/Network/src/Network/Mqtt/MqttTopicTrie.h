@@ -0,0 +1,111 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MqttTopicTrie.h - Dispatches incoming messages according to topic filter
+ *
+ ****/
+
+#pragma once
+
+#include <WString.h>
+#include <Delegate.h>
+#include <mqtt-codec/src/message.h>
+
+class MqttClient;
+
+using MqttDelegate = Delegate<int(MqttClient& client, mqtt_message_t* message)>;
+
+/**
+ * @brief Maps topic filters to handlers
+ * @ingroup mqttclient
+ *
+ * Filters are stored as a tree with one node per topic level, so matching a topic takes one step
+ * per level (plus one for each `+` wildcard branch) regardless of how many filters are registered.
+ * Matching requires no heap allocation.
+ *
+ * Wildcards follow the MQTT specification:
+ *
+ * - `+` matches exactly one level, e.g. `sensor/+/temp` matches `sensor/kitchen/temp`
+ * - `#` matches the parent level and any number of child levels, e.g. `sensor/#` matches `sensor`
+ *   and `sensor/kitchen/temp`. It must be the final level of the filter.
+ * - Topics beginning with `$` are not matched by a wildcard in the first level
+ */
+class MqttTopicTrie
+{
+public:
+	MqttTopicTrie() = default;
+	MqttTopicTrie(const MqttTopicTrie&) = delete;
+
+	/**
+	 * @brief Set handler for a topic filter, replacing any existing one
+	 * @retval bool false if filter is invalid
+	 */
+	bool add(const String& filter, MqttDelegate handler);
+
+	/**
+	 * @brief Remove handler for a topic filter
+	 * @retval bool false if filter was not found
+	 */
+	bool remove(const String& filter);
+
+	/**
+	 * @brief Remove all handlers
+	 */
+	void clear()
+	{
+		root.clear();
+	}
+
+	bool isEmpty() const
+	{
+		return root.isEmpty();
+	}
+
+	/**
+	 * @brief Invoke handlers for all filters matching the topic of a PUBLISH message
+	 * @param client Passed to handlers
+	 * @param message
+	 * @param result On return, the last non-zero value returned by a handler, or 0
+	 * @retval unsigned Number of handlers invoked
+	 * @note Handlers must not add or remove filters
+	 */
+	unsigned dispatch(MqttClient& client, mqtt_message_t* message, int& result) const;
+
+	/**
+	 * @brief Check whether a topic filter is well-formed
+	 */
+	static bool isValidFilter(const String& filter);
+
+private:
+	struct Node {
+		String level;
+		Node* next{nullptr};	  ///< Sibling
+		Node* children{nullptr};  ///< Child levels, excluding wildcards
+		Node* plus{nullptr};	  ///< Child for `+` wildcard
+		MqttDelegate handler;	  ///< Filter ending at this level
+		MqttDelegate hashHandler; ///< Filter ending at this level with `/#`
+
+		~Node()
+		{
+			clear();
+		}
+
+		bool isEmpty() const
+		{
+			return !handler && !hashHandler && children == nullptr && plus == nullptr;
+		}
+
+		Node* findChild(const char* name, size_t length) const;
+		void clear();
+	};
+
+	struct Dispatch;
+
+	bool remove(Node& node, const char* pos, const char* end);
+	void match(const Node& node, const char* pos, const char* end, Dispatch& dispatch) const;
+
+	Node root;
+};
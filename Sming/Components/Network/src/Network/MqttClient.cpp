@@ -11,6 +11,7 @@
 #include "MqttClient.h"
 
 #include "Data/Stream/DataSourceStream.h"
+#include <Clock.h>
 
 const mqtt_parser_callbacks_t MqttClient::callbacks PROGMEM = {
 	.on_message_begin = staticOnMessageBegin,
@@ -45,6 +46,9 @@ mqtt_message_t* createMessage(mqtt_type_t messageType)
 
 void deleteMessage(mqtt_message_t* message)
 {
+	if(message == nullptr) {
+		return;
+	}
 	mqtt_message_clear(message, 0);
 	delete message;
 }
@@ -54,10 +58,21 @@ void clearMessage(mqtt_message_t& message)
 	mqtt_message_clear(&message, 0);
 }
 
+// QoS 1 and 2 messages are tracked until acknowledged
+bool isReliable(const mqtt_message_t* message)
+{
+	return message->common.type == MQTT_TYPE_PUBLISH && message->common.qos != MQTT_QOS_AT_MOST_ONCE;
+}
+
 bool copyString(mqtt_buffer_t& destBuffer, const String& sourceString)
 {
 	destBuffer.length = sourceString.length();
 	MQTT_FREE(destBuffer.data); // Avoid memory leaks
+	if(destBuffer.length == 0) {
+		// Empty buffers have no data, so cannot be mistaken for a stream payload
+		destBuffer.data = nullptr;
+		return true;
+	}
 	destBuffer.data = (uint8_t*)MQTT_MALLOC(sourceString.length());
 	if(destBuffer.data == nullptr) {
 		debug_e("Not enough memory");
@@ -67,6 +82,16 @@ bool copyString(mqtt_buffer_t& destBuffer, const String& sourceString)
 	return true;
 }
 
+/*
+ * Stream payloads have zero length with data referring to the stream.
+ * An empty buffer payload has no data.
+ */
+bool isStreamPayload(const mqtt_message_t* message)
+{
+	return message->common.type == MQTT_TYPE_PUBLISH && message->publish.content.length == MQTT_PUBLISH_STREAM &&
+		   message->publish.content.data != nullptr;
+}
+
 } // namespace
 
 MqttClient::MqttClient(bool withDefaultPayloadParser, bool autoDestruct)
@@ -160,6 +185,24 @@ int MqttClient::staticOnMessageEnd(void* userData, mqtt_message_t* message)
 	return client->onMessageEnd(message);
 }
 
+void MqttClient::completeInflight(uint16_t messageId, MqttInflightWindow::State state)
+{
+	auto entry = inflight.find(messageId);
+	if(entry == nullptr || entry->state != state) {
+		debug_w("[MQTT] Unexpected acknowledgement for message %u", messageId);
+		return;
+	}
+
+	uint32_t latency = millis() - entry->sentTime;
+	++stats.acknowledged;
+	stats.ackLatencyTotal += latency;
+	if(latency > stats.ackLatencyMax) {
+		stats.ackLatencyMax = latency;
+	}
+
+	inflight.remove(*entry);
+}
+
 int MqttClient::onMessageEnd(mqtt_message_t* message)
 {
 	if(message->common.type == MQTT_TYPE_CONNACK) {
@@ -174,6 +217,39 @@ int MqttClient::onMessageEnd(mqtt_message_t* message)
 		}
 	}
 
+	/*
+	 * Acknowledgements free space in the inflight window.
+	 * Several may arrive in one TCP segment: queued messages are sent when parsing is complete.
+	 */
+	switch(message->common.type) {
+	case MQTT_TYPE_PUBACK:
+		completeInflight(message->puback.message_id, MqttInflightWindow::State::AwaitingAck);
+		break;
+
+	case MQTT_TYPE_PUBREC: {
+		auto entry = inflight.find(message->pubrec.message_id);
+		if(entry != nullptr && entry->state == MqttInflightWindow::State::AwaitingAck) {
+			// PUBREL is sent next time we're ready
+			inflight.release(*entry);
+		}
+		break;
+	}
+
+	case MQTT_TYPE_PUBCOMP:
+		completeInflight(message->pubcomp.message_id, MqttInflightWindow::State::AwaitingComp);
+		break;
+
+	default:
+		break;
+	}
+
+	if(message->common.type == MQTT_TYPE_PUBLISH && !topicHandlers.isEmpty()) {
+		int result;
+		if(topicHandlers.dispatch(*this, message, result) != 0) {
+			return result;
+		}
+	}
+
 	auto& handler = static_cast<const HandlerMap&>(eventHandlers)[message->common.type];
 	if(handler) {
 		return handler(*this, message);
@@ -239,6 +315,14 @@ bool MqttClient::connect(const Url& url, const String& clientName)
 	}
 	connectQueued = true;
 
+	// Anything still awaiting acknowledgement follows the connect message, unless the session is discarded
+	if(connectMessage.connect.flags.clean_session) {
+		stats.dropped += inflight.count();
+		inflight.clear();
+	} else {
+		stats.dropped += inflight.resendAll();
+	}
+
 	return TcpClient::connect(url.Host, url.getPort(), useSsl);
 }
 
@@ -261,9 +345,7 @@ bool MqttClient::publish(const String& topic, const String& content, uint8_t fla
 
 	bool success = requestQueue.enqueue(message);
 	if(success) {
-		// Try to force-send message to decrease latency.
-		// Should work for small size messages but there is no guarantee.
-		commit();
+		scheduleSend(message);
 	}
 
 	return success;
@@ -297,9 +379,7 @@ bool MqttClient::publish(const String& topic, IDataSourceStream* stream, uint8_t
 
 	bool success = requestQueue.enqueue(message);
 	if(success) {
-		// Try to force-send message to decrease latency.
-		// Should work for small size messages but there is no guarantee.
-		commit();
+		scheduleSend(message);
 	}
 
 	return success;
@@ -325,6 +405,20 @@ bool MqttClient::subscribe(const String& topic)
 	return requestQueue.enqueue(message);
 }
 
+bool MqttClient::subscribe(const String& filter, MqttDelegate handler)
+{
+	if(requestQueue.full() || !topicHandlers.add(filter, handler)) {
+		return false;
+	}
+
+	if(!subscribe(filter)) {
+		topicHandlers.remove(filter);
+		return false;
+	}
+
+	return true;
+}
+
 bool MqttClient::unsubscribe(const String& topic)
 {
 	debug_d("unsubscribing from '%s'", topic.c_str());
@@ -333,7 +427,9 @@ bool MqttClient::unsubscribe(const String& topic)
 		return false;
 	}
 
-	auto message = createMessage(MQTT_TYPE_SUBSCRIBE);
+	topicHandlers.remove(topic);
+
+	auto message = createMessage(MQTT_TYPE_UNSUBSCRIBE);
 
 	message->unsubscribe.topics = (mqtt_topic_t*)MQTT_MALLOC(sizeof(mqtt_topic_t));
 	memset(message->unsubscribe.topics, 0, sizeof(mqtt_topic_t));
@@ -345,6 +441,176 @@ bool MqttClient::unsubscribe(const String& topic)
 	return requestQueue.enqueue(message);
 }
 
+/*
+ * Messages are sent in this order:
+ *
+ * - CONNECT
+ * - PUBREL and re-sent PUBLISH messages for the inflight window
+ * - Queued requests. QoS 1 and 2 messages wait here if the inflight window is full.
+ *
+ * If a message is to be retained in the inflight window, `entry` is set on return.
+ */
+/*
+ * Determine whether a message can be serialised within the given length.
+ * Only the first message in a write may have a stream payload.
+ */
+bool MqttClient::fits(mqtt_message_t* message, size_t maxLength)
+{
+	if(maxLength == SIZE_MAX) {
+		return true;
+	}
+	return !isStreamPayload(message) && mqtt_serialiser_size(&serialiser, message) <= maxLength;
+}
+
+/*
+ * Get the next message to send, if it fits within maxLength.
+ * A message which doesn't fit is left queued.
+ */
+mqtt_message_t* MqttClient::getNextMessage(MqttInflightWindow::Entry*& entry, size_t maxLength)
+{
+	entry = nullptr;
+
+	if(connectQueued) {
+		if(!fits(&connectMessage, maxLength)) {
+			return nullptr;
+		}
+		connectQueued = false;
+		return &connectMessage;
+	}
+
+	auto pending = inflight.nextPending();
+	if(pending != nullptr) {
+		if(pending->state == MqttInflightWindow::State::AwaitingComp) {
+			auto message = createMessage(MQTT_TYPE_PUBREL);
+			if(message == nullptr) {
+				// Try again later, otherwise the transaction never completes
+				inflight.setPending(*pending);
+				return nullptr;
+			}
+			// Fixed header flags required by protocol
+			message->common.qos = MQTT_QOS_AT_LEAST_ONCE;
+			message->pubrel.message_id = pending->id;
+			if(!fits(message, maxLength)) {
+				deleteMessage(message);
+				inflight.setPending(*pending);
+				return nullptr;
+			}
+			return message;
+		}
+
+		if(!fits(pending->message, maxLength)) {
+			inflight.setPending(*pending);
+			return nullptr;
+		}
+		entry = pending;
+		entry->message->common.dup = MQTT_DUP_TRUE;
+		++stats.retransmitted;
+		return entry->message;
+	}
+
+	auto message = requestQueue.peek();
+	if(message == nullptr || !fits(message, maxLength)) {
+		return nullptr;
+	}
+
+	if(isReliable(message)) {
+		entry = inflight.add(message, millis());
+		if(entry == nullptr) {
+			// Wait for acknowledgements
+			return nullptr;
+		}
+		if(inflight.count() > stats.maxInflight) {
+			stats.maxInflight = inflight.count();
+		}
+	}
+
+	if(message->common.type == MQTT_TYPE_PUBLISH) {
+		++stats.published;
+	}
+
+	return requestQueue.dequeue();
+}
+
+void MqttClient::scheduleSend(mqtt_message_t* message)
+{
+	if(!batchMode) {
+		// Try to force-send message to decrease latency.
+		// Should work for small size messages but there is no guarantee.
+		commit();
+		return;
+	}
+
+	// Hold back until there's enough to fill a segment, or the deadline passes
+	if(isStreamPayload(message)) {
+		batchLength += TCP_MSS;
+	} else {
+		batchLength += mqtt_serialiser_size(&serialiser, message);
+	}
+	if(batchLength >= TCP_MSS) {
+		commit();
+		return;
+	}
+
+	if(!flushTimer.isStarted()) {
+		auto callback = [](void* arg) { static_cast<MqttClient*>(arg)->commit(); };
+		flushTimer.initializeMs(batchFlushDelay, callback, this).startOnce();
+	}
+}
+
+/*
+ * Serialise outgoingMessage and queue it for sending.
+ * Returns the number of bytes queued, including any payload stream, or 0 on error.
+ */
+size_t MqttClient::sendOutgoingMessage(MqttInflightWindow::Entry* inflightEntry, IDataSourceStream*& payloadStream)
+{
+	debug_d("[MQTT] Sending message type %u", outgoingMessage->common.type);
+
+	payloadStream = nullptr;
+	if(isStreamPayload(outgoingMessage)) {
+		payloadStream = reinterpret_cast<IDataSourceStream*>(outgoingMessage->publish.content.data);
+		outgoingMessage->publish.content.length = payloadStream->available();
+	}
+
+	size_t packetLength = mqtt_serialiser_size(&serialiser, outgoingMessage);
+	if(!packetLength) {
+		debug_e("Error: Invalid MQTT message detected!");
+		if(inflightEntry != nullptr) {
+			inflight.remove(*inflightEntry);
+			outgoingMessage = nullptr;
+		}
+		return 0;
+	}
+
+	size_t totalLength = packetLength;
+	if(outgoingMessage->common.type == MQTT_TYPE_PUBLISH && payloadStream != nullptr) {
+		// The packetLength should be big enough for the header ONLY.
+		// Payload will be attached as a second stream
+		packetLength -= outgoingMessage->publish.content.length;
+		outgoingMessage->publish.content.data = nullptr;
+	}
+
+	uint8_t packet[packetLength];
+	mqtt_serialiser_write(&serialiser, outgoingMessage, packet, packetLength);
+
+	// Consecutive sends are appended to the same buffer
+	send(reinterpret_cast<const char*>(packet), packetLength);
+	if(payloadStream != nullptr) {
+		send(payloadStream);
+	}
+
+	if(inflightEntry != nullptr) {
+		if(payloadStream != nullptr) {
+			// Stream content has been consumed so cannot be re-sent
+			inflightEntry->message = nullptr;
+		} else {
+			// Window now owns the message
+			outgoingMessage = nullptr;
+		}
+	}
+
+	return totalLength;
+}
+
 void MqttClient::onReadyToSendData(TcpConnectionEvent sourceEvent)
 {
 	switch(state) {
@@ -353,12 +619,8 @@ void MqttClient::onReadyToSendData(TcpConnectionEvent sourceEvent)
 		if(outgoingMessage != &connectMessage) {
 			deleteMessage(outgoingMessage);
 		}
-		if(connectQueued) {
-			outgoingMessage = &connectMessage;
-			connectQueued = false;
-		} else {
-			outgoingMessage = requestQueue.dequeue();
-		}
+		MqttInflightWindow::Entry* inflightEntry;
+		outgoingMessage = getNextMessage(inflightEntry);
 		if(!outgoingMessage) {
 			// Send PINGREQ every PingRepeatTime time, if there is no outgoing traffic
 			if(!pingTimer.expired()) {
@@ -368,36 +630,32 @@ void MqttClient::onReadyToSendData(TcpConnectionEvent sourceEvent)
 			outgoingMessage = createMessage(MQTT_TYPE_PINGREQ);
 		}
 
-		debug_d("[MQTT] Sending message type %u", outgoingMessage->common.type);
-
-		IDataSourceStream* payloadStream{nullptr};
-		if(outgoingMessage->common.type == MQTT_TYPE_PUBLISH &&
-		   outgoingMessage->publish.content.length == MQTT_PUBLISH_STREAM) {
-			payloadStream = reinterpret_cast<IDataSourceStream*>(outgoingMessage->publish.content.data);
-			if(payloadStream) {
-				outgoingMessage->publish.content.length = payloadStream->available();
-			}
-		}
-
-		size_t packetLength = mqtt_serialiser_size(&serialiser, outgoingMessage);
-		if(!packetLength) {
-			debug_e("Error: Invalid MQTT message detected!");
+		IDataSourceStream* payloadStream;
+		size_t length = sendOutgoingMessage(inflightEntry, payloadStream);
+		if(length == 0) {
 			break;
 		}
-
-		if(outgoingMessage->common.type == MQTT_TYPE_PUBLISH && payloadStream != nullptr) {
-			// The packetLength should be big enough for the header ONLY.
-			// Payload will be attached as a second stream
-			packetLength -= outgoingMessage->publish.content.length;
-			outgoingMessage->publish.content.data = nullptr;
-		}
-
-		uint8_t packet[packetLength];
-		mqtt_serialiser_write(&serialiser, outgoingMessage, packet, packetLength);
-
-		send(reinterpret_cast<const char*>(packet), packetLength);
-		if(payloadStream != nullptr) {
-			send(payloadStream);
+		++stats.writes;
+
+		if(batchMode) {
+			// Add as many further messages as will fit into this write
+			flushTimer.stop();
+			batchLength = 0;
+			size_t space = getAvailableWriteSize();
+			while(payloadStream == nullptr && length < space) {
+				if(outgoingMessage != &connectMessage) {
+					deleteMessage(outgoingMessage);
+				}
+				outgoingMessage = getNextMessage(inflightEntry, space - length);
+				if(outgoingMessage == nullptr) {
+					break;
+				}
+				auto messageLength = sendOutgoingMessage(inflightEntry, payloadStream);
+				if(messageLength == 0) {
+					break;
+				}
+				length += messageLength;
+			}
 		}
 
 		state = eMCS_SendingData;
@@ -14,8 +14,13 @@
 
 void TcpClient::freeStreams()
 {
-	delete stream;
+	// Content may still be referenced by the TCP send queue
+	if(!releaseZeroCopyStream(stream)) {
+		delete stream;
+	}
 	stream = nullptr;
+	delete queuedStream;
+	queuedStream = nullptr;
 }
 
 bool TcpClient::connect(const String& server, int port, bool useSsl)
@@ -44,8 +49,10 @@ bool TcpClient::send(const char* data, uint16_t len, bool forceCloseAfterSent)
 		return false;
 	}
 
-	auto memoryStream = static_cast<MemoryDataStream*>(stream);
-	if(memoryStream == nullptr || memoryStream->getStreamType() != eSST_MemoryWritable) {
+	// Appending may re-allocate the buffer, so avoid if content is referenced by the send queue
+	auto memoryStream = static_cast<MemoryDataStream*>(queuedStream ?: stream);
+	if(memoryStream == nullptr || memoryStream->getStreamType() != eSST_MemoryWritable ||
+	   isZeroCopyPending(memoryStream)) {
 		memoryStream = new MemoryDataStream();
 	}
 
@@ -67,41 +74,14 @@ bool TcpClient::send(IDataSourceStream* source, bool forceCloseAfterSent)
 		return false;
 	}
 
-	if(stream == nullptr) {
-		stream = source;
-	} else if(stream != source) {
-		if(stream->getStreamType() == eSST_Chain) {
-			auto chainStream = static_cast<StreamChain*>(stream);
-			if(!chainStream->attachStream(source)) {
-				debug_w("Unable to attach source to existing stream chain!");
-				delete source;
-				return false;
-			}
-		} else {
-			debug_d("Creating stream chain ...");
-			auto chainStream = new StreamChain();
-			if(chainStream == nullptr) {
-				delete source;
-				debug_w("Unable to create stream chain!");
-				return false;
-			}
-
-			if(!chainStream->attachStream(stream)) {
-				delete source;
-				delete chainStream;
-				debug_w("Unable to attach stream to new chain!");
-				return false;
-			}
-
-			if(!chainStream->attachStream(source)) {
-				delete source;
-				delete chainStream;
-				debug_w("Unable to attach source to new chain!");
-				return false;
-			}
-
-			stream = chainStream;
-		}
+	/*
+	 * A stream whose content is referenced by the send queue must not be wrapped in a chain,
+	 * so anything further is held back until it has finished.
+	 */
+	bool hold = queuedStream != nullptr ||
+				(stream != nullptr && stream->getStreamType() != eSST_Chain && isZeroCopyPending(stream));
+	if(!appendStream(hold ? queuedStream : stream, source)) {
+		return false;
 	}
 
 	int length = source->available();
@@ -116,6 +96,53 @@ bool TcpClient::send(IDataSourceStream* source, bool forceCloseAfterSent)
 	return true;
 }
 
+bool TcpClient::appendStream(IDataSourceStream*& target, IDataSourceStream* source)
+{
+	if(target == nullptr) {
+		target = source;
+		return true;
+	}
+
+	if(target == source) {
+		return true;
+	}
+
+	if(target->getStreamType() == eSST_Chain) {
+		auto chainStream = static_cast<StreamChain*>(target);
+		if(!chainStream->attachStream(source)) {
+			debug_w("Unable to attach source to existing stream chain!");
+			delete source;
+			return false;
+		}
+		return true;
+	}
+
+	debug_d("Creating stream chain ...");
+	auto chainStream = new StreamChain();
+	if(chainStream == nullptr) {
+		delete source;
+		debug_w("Unable to create stream chain!");
+		return false;
+	}
+
+	if(!chainStream->attachStream(target)) {
+		delete source;
+		delete chainStream;
+		debug_w("Unable to attach stream to new chain!");
+		return false;
+	}
+
+	if(!chainStream->attachStream(source)) {
+		delete source;
+		delete chainStream;
+		debug_w("Unable to attach source to new chain!");
+		return false;
+	}
+
+	target = chainStream;
+	return true;
+}
+
 err_t TcpClient::onConnected(err_t err)
 {
 	if(err == ERR_OK) {
@@ -196,7 +223,10 @@ void TcpClient::pushAsyncPart()
 
 	if(stream->isFinished()) {
 		debug_d("TcpClient stream finished");
+		auto next = queuedStream;
+		queuedStream = nullptr;
 		freeStreams();
+		stream = next;
 		trySend(eTCE_Poll);
 		flush();
 	}
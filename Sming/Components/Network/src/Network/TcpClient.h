@@ -162,10 +162,14 @@ protected:
 	void pushAsyncPart();
 	void freeStreams();
 
+private:
+	bool appendStream(IDataSourceStream*& target, IDataSourceStream* source);
+
 protected:
 	IDataSourceStream* stream = nullptr; ///< The currently active stream being sent
 
 private:
+	IDataSourceStream* queuedStream = nullptr; ///< Sent after the active stream, whilst its content is referenced
 	TcpClientState state = eTCS_Ready;
 	TcpClientCompleteDelegate completed;
 	TcpClientEventDelegate ready;
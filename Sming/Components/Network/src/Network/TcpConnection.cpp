@@ -26,6 +26,73 @@
 #define debug_tcp_ext(fmt, ...) debug_none(fmt, ##__VA_ARGS__)
 #endif
 
+/*
+ * When a connection is closed whilst lwIP still references stream content (zero-copy mode)
+ * the pcb is handed over to one of these. It keeps the stream alive until the referenced data
+ * has been acknowledged or the connection fails.
+ */
+struct TcpConnection::ZeroCopyReleaser {
+	IDataSourceStream* stream; ///< Deleted on release, if owned
+	const IDataSourceStream* ref;
+	uint32_t remaining; ///< Bytes to be acknowledged before stream data is no longer referenced
+	bool closed;
+
+	~ZeroCopyReleaser()
+	{
+		delete stream;
+	}
+
+	static void release(tcp_pcb* tpcb, ZeroCopyReleaser* releaser)
+	{
+		tcp_arg(tpcb, nullptr);
+		tcp_sent(tpcb, nullptr);
+		tcp_recv(tpcb, nullptr);
+		tcp_err(tpcb, nullptr);
+		tcp_poll(tpcb, nullptr, 0);
+		delete releaser;
+	}
+
+	void attach(tcp_pcb* tpcb)
+	{
+		tcp_arg(tpcb, this);
+
+		tcp_sent(tpcb, [](void* arg, tcp_pcb* tcp, uint16_t len) -> err_t {
+			auto releaser = static_cast<ZeroCopyReleaser*>(arg);
+			releaser->remaining -= std::min(uint32_t(len), releaser->remaining);
+			if(releaser->remaining == 0 && releaser->closed) {
+				release(tcp, releaser);
+			}
+			return ERR_OK;
+		});
+
+		tcp_recv(tpcb, [](void* arg, tcp_pcb* tcp, pbuf* p, err_t err) -> err_t {
+			if(p != nullptr) {
+				tcp_recved(tcp, p->tot_len);
+				pbuf_free(p);
+			}
+			return ERR_OK;
+		});
+
+		// Connection has gone, and all references with it
+		tcp_err(tpcb, [](void* arg, err_t err) { delete static_cast<ZeroCopyReleaser*>(arg); });
+
+		tcp_poll(
+			tpcb,
+			[](void* arg, tcp_pcb* tcp) -> err_t {
+				auto releaser = static_cast<ZeroCopyReleaser*>(arg);
+				if(!releaser->closed) {
+					// Graceful close: outstanding data is still delivered
+					releaser->closed = (tcp_close(tcp) == ERR_OK);
+				}
+				if(releaser->closed && releaser->remaining == 0) {
+					release(tcp, releaser);
+				}
+				return ERR_OK;
+			},
+			1);
+	}
+};
+
 TcpConnection::~TcpConnection()
 {
 	autoSelfDestruct = false;
@@ -217,6 +284,9 @@ int TcpConnection::write(const char* data, int len, uint8_t apiflags)
 		}
 
 		err = tcp_write(tcp, data, len, apiflags);
+		if(err == ERR_OK) {
+			unackedBytes += len;
+		}
 	}
 
 	if(err < 0) {
@@ -235,6 +305,24 @@ int TcpConnection::write(IDataSourceStream* stream)
 		return 0;
 	}
 
+	if(zcPending != 0) {
+		// Referenced content must be acknowledged before anything further is read from the stream
+		return (stream == zcStream) ? writeZeroCopy(stream) : 0;
+	}
+
+	StreamSpan spans[4];
+
+	if(zeroCopy && ssl == nullptr) {
+		size_t length = 0;
+		auto spanCount = stream->peekSpans(spans, ARRAY_SIZE(spans));
+		for(unsigned i = 0; i < spanCount; ++i) {
+			length += spans[i].length;
+		}
+		if(length >= TCP_ZERO_COPY_MIN_SIZE) {
+			return writeZeroCopy(stream);
+		}
+	}
+
 	// Send data from DataStream
 	size_t total = 0;
 	unsigned pushCount = 0;
@@ -244,28 +332,46 @@ int TcpConnection::write(IDataSourceStream* stream)
 			break;
 		}
 
+		// Where stream content can be accessed directly there's no need to copy it into the buffer first
 		char buffer[NETWORK_SEND_BUFFER_SIZE];
-		auto bytesRead = stream->readMemoryBlock(buffer, std::min(sizeof(buffer), available));
-		if(bytesRead == 0) {
+		auto spanCount = stream->getSpans(spans, ARRAY_SIZE(spans), buffer, std::min(sizeof(buffer), available));
+		if(spanCount == 0) {
 			break;
 		}
 
 		++pushCount;
 
-		int bytesWritten = write(buffer, bytesRead, TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE);
-		debug_tcp_d("Written: %d, Available: %u, isFinished: %d, PushCount: %u", bytesWritten, available,
-					stream->isFinished(), pushCount);
-
-		if(bytesWritten < 0) {
-			break;
+		size_t bytesWritten = 0;
+		int err = 0;
+		for(unsigned i = 0; i < spanCount && bytesWritten < available; ++i) {
+			size_t len = std::min(spans[i].length, available - bytesWritten);
+			int res = write(spans[i].data, len, TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE);
+			if(res < 0) {
+				err = res;
+				break;
+			}
+			bytesWritten += size_t(res);
+			if(size_t(res) < len) {
+				break;
+			}
 		}
 
+		debug_tcp_d("Written: %u, Available: %u, isFinished: %d, PushCount: %u", bytesWritten, available,
+					stream->isFinished(), pushCount);
+
 		if(bytesWritten == 0) {
+			if(err < 0) {
+				break;
+			}
 			continue;
 		}
 
-		total += size_t(bytesWritten);
+		total += bytesWritten;
 		stream->seek(bytesWritten);
+
+		if(err < 0) {
+			break;
+		}
 	}
 
 	if(pushCount == 0) {
@@ -277,6 +383,122 @@ int TcpConnection::write(IDataSourceStream* stream)
 	return total;
 }
 
+int TcpConnection::writeZeroCopy(IDataSourceStream* stream)
+{
+	if(zcPending != 0 && unackedBytes != zcLead + zcPending) {
+		// Other data has been queued since, wait for it to be acknowledged
+		return 0;
+	}
+
+	size_t total = 0;
+	while(tcp_sndqueuelen(tcp) < TCP_SND_QUEUELEN) {
+		size_t available = getAvailableWriteSize();
+		if(available == 0) {
+			break;
+		}
+
+		// Stream position is only advanced on acknowledgement, so skip over data already queued
+		const char* data;
+		size_t len = stream->peekMemoryBlock(zcPending, data);
+		if(len == 0) {
+			break;
+		}
+		len = std::min(len, available);
+
+		err_t err = tcp_write(tcp, data, len, TCP_WRITE_FLAG_MORE);
+		if(err != ERR_OK) {
+			debug_tcp_ext("zero-copy write failed with err %d (\"%s\")", err, lwip_strerr(err));
+			break;
+		}
+
+		if(zcPending == 0) {
+			zcStream = stream;
+			zcLead = unackedBytes;
+		}
+		zcPending += len;
+		unackedBytes += len;
+		total += len;
+	}
+
+	debug_tcp_d("Referenced: %u, Pending: %u, Lead: %u", total, zcPending, zcLead);
+
+	if(total != 0) {
+		flush();
+	}
+
+	return total;
+}
+
+void TcpConnection::zeroCopyAcknowledged(uint16_t len)
+{
+	uint32_t acked = std::min(uint32_t(len), unackedBytes);
+	unackedBytes -= acked;
+
+	if(zcPending == 0) {
+		return;
+	}
+
+	auto n = std::min(acked, zcLead);
+	zcLead -= n;
+	acked -= n;
+
+	n = std::min(acked, zcPending);
+	if(n == 0) {
+		return;
+	}
+	zcPending -= n;
+
+	auto stream = zcStream;
+	bool owned = zcOwned;
+	if(zcPending == 0) {
+		zcStream = nullptr;
+		zcOwned = false;
+	}
+
+	if(!owned) {
+		stream->seek(n);
+	} else if(zcPending == 0) {
+		delete stream;
+	}
+}
+
+bool TcpConnection::releaseZeroCopyStream(IDataSourceStream* stream)
+{
+	if(stream == nullptr) {
+		return false;
+	}
+
+	if(zcReleaser != nullptr && zcReleaser->stream == nullptr && zcReleaser->ref == stream) {
+		zcReleaser->stream = stream;
+		return true;
+	}
+
+	if(isZeroCopyPending(stream)) {
+		zcOwned = true;
+		return true;
+	}
+
+	return false;
+}
+
+void TcpConnection::detachZeroCopy()
+{
+	auto releaser = new ZeroCopyReleaser{zcOwned ? zcStream : nullptr, zcStream, zcLead + zcPending, false};
+	if(releaser == nullptr) {
+		debug_tcp_e("Out of memory, aborting with zero-copy data outstanding");
+		tcp_arg(tcp, nullptr);
+		tcp_abort(tcp);
+		if(zcOwned) {
+			delete zcStream;
+		}
+		return;
+	}
+
+	debug_tcp_d("closing with %u referenced bytes outstanding", zcPending);
+	releaser->attach(tcp);
+	zcReleaser = releaser;
+}
+
 void TcpConnection::close()
 {
 	if(ssl != nullptr) {
@@ -288,11 +510,18 @@ void TcpConnection::close()
 	}
 	debug_tcp_d("connection closing");
 
-	tcp_poll(tcp, staticOnPoll, 1);
-	tcp_arg(tcp, nullptr); // reset pointer to close connection on next callback
+	if(zcPending != 0) {
+		detachZeroCopy();
+	} else {
+		tcp_poll(tcp, staticOnPoll, 1);
+		tcp_arg(tcp, nullptr); // reset pointer to close connection on next callback
+	}
 	tcp = nullptr;
+	zeroCopyReset();
 
+	// Stream ownership may still be handed over whilst processing closure
 	onClosed();
+	zcReleaser = nullptr;
 
 	checkSelfFree();
 }
@@ -304,6 +533,7 @@ void TcpConnection::initialize(tcp_pcb* pcb)
 	tcp = pcb;
 	sleep = 0;
 	canSend = true;
+	zeroCopyReset();
 
 	tcp_nagle_disable(tcp);
 	tcp_arg(tcp, this);
@@ -435,9 +665,15 @@ err_t TcpConnection::internalOnReceive(pbuf* p, err_t err)
 			tcp_recved(tcp, p->tot_len);
 			pbuf_free(p);
 		}
-		closeTcpConnection(tcp); // ??
+		if(zcPending != 0) {
+			detachZeroCopy();
+		} else {
+			closeTcpConnection(tcp); // ??
+		}
 		tcp = nullptr;
+		zeroCopyReset();
 		onError(err);
+		zcReleaser = nullptr;
 		//close();
 		return err == ERR_ABRT ? ERR_ABRT : ERR_OK;
 	}
@@ -498,6 +734,7 @@ err_t TcpConnection::internalOnReceive(pbuf* p, err_t err)
 err_t TcpConnection::internalOnSent(uint16_t len)
 {
 	sleep = 0;
+	zeroCopyAcknowledged(len);
 	err_t res = onSent(len);
 	checkSelfFree();
 	debug_tcp_ext("<sent");
@@ -530,6 +767,10 @@ err_t TcpConnection::internalOnPoll()
 void TcpConnection::internalOnError(err_t err)
 {
 	tcp = nullptr; // IMPORTANT. No available connection after error!
+	if(zcOwned) {
+		delete zcStream;
+	}
+	zeroCopyReset();
 	onError(err);
 	checkSelfFree();
 	debug_tcp_ext("<error");
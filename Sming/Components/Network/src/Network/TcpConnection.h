@@ -23,6 +23,16 @@
 
 #define NETWORK_SEND_BUFFER_SIZE 1024
 
+/**
+ * @brief Minimum amount of contiguous stream data required for zero-copy transmission
+ *
+ * Smaller blocks are cheaper to copy, and doing so avoids having to wait for acknowledgement
+ * before the stream can be released (e.g. HTTP response headers).
+ */
+#ifndef TCP_ZERO_COPY_MIN_SIZE
+#define TCP_ZERO_COPY_MIN_SIZE NETWORK_SEND_BUFFER_SIZE
+#endif
+
 enum TcpConnectionEvent {
 	eTCE_Connected = 0, ///< Occurs after connection establishment
 	eTCE_Received,		///< Occurs on data receive
@@ -85,11 +95,54 @@ public:
 
 	/** @brief Writes stream data directly to the TCP buffer
 	 *  @param stream
-	 *  @param apiflags TCP_WRITE_FLAG_COPY, TCP_WRITE_FLAG_MORE
 	 *  @retval int negative on error, 0 when retry is needed or positive on success
+	 *  @note In zero-copy mode the stream read position only advances as data is acknowledged,
+	 *  so `stream->isFinished()` does not return true until all of its content has been delivered.
 	 */
 	int write(IDataSourceStream* stream);
 
+	/**
+	 * @brief Enable or disable zero-copy transmission of stream content
+	 * @param enable
+	 *
+	 * When enabled, streams which support `IDataSourceStream::peekMemoryBlock()` are
+	 * passed to lwIP by reference instead of being copied into the TCP send buffer.
+	 *
+	 * The stream must not be written to or destroyed until it reports finished.
+	 * To dispose of it earlier, pass it to `releaseZeroCopyStream()` instead of deleting it.
+	 * If the connection is closed whilst referenced data is still outstanding, the connection is closed
+	 * gracefully in the background and any released stream is kept alive until lwIP has finished with it,
+	 * i.e. the data is acknowledged or the connection fails.
+	 *
+	 * Zero-copy is not used for SSL connections as content must be encrypted.
+	 */
+	void setZeroCopy(bool enable)
+	{
+		zeroCopy = enable;
+	}
+
+	bool getZeroCopy() const
+	{
+		return zeroCopy;
+	}
+
+	/**
+	 * @brief Determine whether stream content is currently held by reference in the TCP send queue
+	 * @param stream The stream to check, nullptr for any stream
+	 */
+	bool isZeroCopyPending(const IDataSourceStream* stream = nullptr) const
+	{
+		return zcPending != 0 && (stream == nullptr || stream == zcStream);
+	}
+
+	/**
+	 * @brief Hand over ownership of a stream which may still be referenced by the send queue
+	 * @param stream
+	 * @retval bool true if ownership was taken, in which case the stream is deleted once lwIP has finished with it.
+	 * If false is returned the caller may delete the stream immediately.
+	 */
+	bool releaseZeroCopyStream(IDataSourceStream* stream);
+
 	uint16_t getAvailableWriteSize()
 	{
 		return (canSend && tcp) ? tcp_sndbuf(tcp) : 0;
@@ -206,6 +259,19 @@ protected:
 private:
 	static err_t staticOnPoll(void* arg, tcp_pcb* tcp);
 	static void closeTcpConnection(tcp_pcb* tpcb);
+	struct ZeroCopyReleaser;
+	void detachZeroCopy();
+
+	int writeZeroCopy(IDataSourceStream* stream);
+	void zeroCopyAcknowledged(uint16_t len);
+	void zeroCopyReset()
+	{
+		zcStream = nullptr;
+		zcOwned = false;
+		zcLead = 0;
+		zcPending = 0;
+		unackedBytes = 0;
+	}
 
 	void checkSelfFree()
 	{
@@ -223,9 +289,16 @@ protected:
 	Ssl::Session* ssl = nullptr;
 	Ssl::Session::InitDelegate sslInit;
 	bool useSsl = false;
+	bool zeroCopy = false;
 
 private:
 	TcpConnectionDestroyedDelegate destroyedDelegate = nullptr;
+	IDataSourceStream* zcStream = nullptr;	///< Stream whose content is referenced in the send queue
+	ZeroCopyReleaser* zcReleaser = nullptr; ///< Set only whilst closing with referenced data outstanding
+	uint32_t unackedBytes = 0;				///< Total bytes queued but not yet acknowledged
+	uint32_t zcLead = 0;					///< Unacknowledged bytes queued before the referenced data
+	uint32_t zcPending = 0;					///< Referenced stream bytes not yet acknowledged
+	bool zcOwned = false;					///< Set when stream ownership has been passed to us
 };
 
 /** @} */
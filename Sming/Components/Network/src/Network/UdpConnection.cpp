@@ -93,10 +93,95 @@ bool UdpConnection::sendTo(IpAddress remoteIP, uint16_t remotePort, const char*
 	}
 }
 
+/*
+ * Build a datagram from spans, referencing content where possible
+ */
+pbuf* UdpConnection::createPacket(const StreamSpan* spans, unsigned count)
+{
+	size_t length{0};
+	for(unsigned i = 0; i < count; ++i) {
+		length += spans[i].length;
+	}
+	if(length > 0xffff) {
+		return nullptr;
+	}
+
+#ifdef ARCH_ESP8266
+	pbuf* packet = pbuf_alloc(PBUF_TRANSPORT, length, PBUF_RAM);
+	if(packet == nullptr) {
+		return nullptr;
+	}
+	// PBUF_RAM buffers are always contiguous
+	auto ptr = static_cast<char*>(packet->payload);
+	for(unsigned i = 0; i < count; ++i) {
+		memcpy(ptr, spans[i].data, spans[i].length);
+		ptr += spans[i].length;
+	}
+	return packet;
+#else
+	// UDP header is allocated separately by udp_sendto()
+	pbuf* packet{nullptr};
+	for(unsigned i = 0; i < count; ++i) {
+		if(spans[i].length == 0) {
+			continue;
+		}
+		pbuf* p = pbuf_alloc(PBUF_TRANSPORT, spans[i].length, PBUF_REF);
+		if(p == nullptr) {
+			if(packet != nullptr) {
+				pbuf_free(packet);
+			}
+			return nullptr;
+		}
+		p->payload = const_cast<char*>(spans[i].data);
+		if(packet == nullptr) {
+			packet = p;
+		} else {
+			pbuf_cat(packet, p);
+		}
+	}
+	if(packet == nullptr) {
+		packet = pbuf_alloc(PBUF_TRANSPORT, 0, PBUF_RAM);
+	}
+	return packet;
+#endif
+}
+
+bool UdpConnection::sendTo(IpAddress remoteIP, uint16_t remotePort, const StreamSpan* spans, unsigned count)
+{
+	if(udp == nullptr) {
+		return false;
+	}
+
+	pbuf* p = createPacket(spans, count);
+	if(p == nullptr) {
+		return false;
+	}
+
+	err_t res = udp_sendto(udp, p, remoteIP, remotePort);
+	pbuf_free(p);
+	return res == ERR_OK;
+}
+
+unsigned UdpConnection::sendBatchTo(IpAddress remoteIP, uint16_t remotePort, const StreamSpan* datagrams,
+									unsigned count)
+{
+	unsigned sent{0};
+	for(unsigned i = 0; i < count; ++i) {
+		if(sendTo(remoteIP, remotePort, &datagrams[i], 1)) {
+			++sent;
+		}
+	}
+	debug_d("UDP sent %u of %u datagrams", sent, count);
+	return sent;
+}
+
 void UdpConnection::onReceive(pbuf* buf, IpAddress remoteIP, uint16_t remotePort)
 {
 	debug_d("UDP received: %d bytes", buf->tot_len);
-	if(onDataCallback) {
+	if(onDatagramCallback) {
+		UdpDatagram datagram(buf);
+		onDatagramCallback(*this, datagram, remoteIP, remotePort);
+	} else if(onDataCallback) {
 		auto data = new char[buf->tot_len + 1];
 		pbuf_copy_partial(buf, data, buf->tot_len, 0);
 		data[buf->tot_len] = '\0';
@@ -11,6 +11,7 @@
 #pragma once
 
 #include <Network/IpConnection.h>
+#include <Network/UdpDatagram.h>
 #include <lwip/udp.h>
 
 /** @defgroup   udp UDP
@@ -24,6 +25,13 @@ class UdpConnection;
 using UdpConnectionDataDelegate =
 	Delegate<void(UdpConnection& connection, char* data, int size, IpAddress remoteIP, uint16_t remotePort)>;
 
+/**
+ * @brief Receive callback which accesses datagram content directly from network buffers
+ * @see See `UdpConnection::setDatagramDelegate()`
+ */
+using UdpConnectionDatagramDelegate =
+	Delegate<void(UdpConnection& connection, const UdpDatagram& datagram, IpAddress remoteIP, uint16_t remotePort)>;
+
 class UdpConnection : public IpConnection
 {
 public:
@@ -71,6 +79,45 @@ public:
 		return sendTo(remoteIP, remotePort, data.c_str(), data.length());
 	}
 
+	/**
+	 * @brief Send a single datagram assembled from several regions of memory
+	 * @param remoteIP
+	 * @param remotePort
+	 * @param spans Regions to send, in order
+	 * @param count Number of entries in `spans`
+	 * @retval bool true on success
+	 *
+	 * Content is referenced by the network stack rather than being copied into a new buffer.
+	 * It must remain valid until this method returns.
+	 *
+	 * @note On the Esp8266 the WiFi driver may retain outgoing packets after this call returns,
+	 * so content is copied.
+	 */
+	bool sendTo(IpAddress remoteIP, uint16_t remotePort, const StreamSpan* spans, unsigned count);
+
+	/**
+	 * @brief Send several datagrams to the same destination
+	 * @param remoteIP
+	 * @param remotePort
+	 * @param datagrams Content for each datagram
+	 * @param count Number of datagrams
+	 * @retval unsigned Number of datagrams sent successfully
+	 * @note Content is referenced as for `sendTo(IpAddress, uint16_t, const StreamSpan*, unsigned)`
+	 */
+	unsigned sendBatchTo(IpAddress remoteIP, uint16_t remotePort, const StreamSpan* datagrams, unsigned count);
+
+	/**
+	 * @brief Set callback to receive datagrams without copying
+	 * @param handler Invoked for every datagram received, instead of the data handler passed to the constructor
+	 *
+	 * The default handler copies each datagram into a newly allocated buffer.
+	 * This handler instead receives a view of the network buffers, valid only for the duration of the call.
+	 */
+	void setDatagramDelegate(UdpConnectionDatagramDelegate handler)
+	{
+		onDatagramCallback = handler;
+	}
+
 	/**
 	 * @brief Sets the UDP multicast IP.
 	 * @param ip
@@ -98,10 +145,12 @@ protected:
 protected:
 	bool initialize(udp_pcb* pcb = nullptr);
 	static void staticOnReceive(void* arg, struct udp_pcb* pcb, struct pbuf* p, LWIP_IP_ADDR_T* addr, u16_t port);
+	pbuf* createPacket(const StreamSpan* spans, unsigned count);
 
 protected:
 	udp_pcb* udp = nullptr;
 	UdpConnectionDataDelegate onDataCallback = nullptr;
+	UdpConnectionDatagramDelegate onDatagramCallback = nullptr;
 };
 
 /** @} */
@@ -0,0 +1,119 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * UdpDatagram.h
+ *
+ ****/
+
+#pragma once
+
+#include <Data/Stream/DataSourceStream.h>
+#include <lwip/pbuf.h>
+
+/**
+ * @brief Read-only view of a received UDP datagram
+ * @ingroup udp
+ *
+ * Provides access to datagram content without copying it out of the network buffers.
+ * Content may be split across several buffers: check `isContiguous()` before using `data()`,
+ * or use `getSpans()` to obtain a scatter list.
+ *
+ * For parsing, contiguous content may be wrapped in a `NetworkPacket` (see `Data/Packet.h`).
+ *
+ * @note The view is only valid for the duration of the receive callback.
+ */
+class UdpDatagram
+{
+public:
+	explicit UdpDatagram(pbuf* buf) : buf(buf)
+	{
+	}
+
+	UdpDatagram(const UdpDatagram&) = delete;
+
+	/**
+	 * @brief Get total length of datagram content
+	 */
+	size_t length() const
+	{
+		return buf->tot_len;
+	}
+
+	/**
+	 * @brief Determine if content is stored in a single buffer
+	 */
+	bool isContiguous() const
+	{
+		return buf->len == buf->tot_len;
+	}
+
+	/**
+	 * @brief Get pointer to content
+	 * @retval const uint8_t* nullptr if content is not contiguous
+	 */
+	const uint8_t* data() const
+	{
+		return isContiguous() ? static_cast<const uint8_t*>(buf->payload) : nullptr;
+	}
+
+	/**
+	 * @brief Get list of buffers containing datagram content
+	 * @param spans Array to receive the region descriptors
+	 * @param maxSpans Number of entries available in `spans`
+	 * @retval unsigned Number of spans obtained
+	 */
+	unsigned getSpans(StreamSpan* spans, unsigned maxSpans) const
+	{
+		unsigned count{0};
+		for(auto p = buf; p != nullptr && count < maxSpans && p->len != 0; p = p->next) {
+			spans[count++] = StreamSpan{static_cast<const char*>(p->payload), p->len};
+		}
+		return count;
+	}
+
+	/**
+	 * @brief Copy content into a buffer
+	 * @param offset Start position within datagram
+	 * @param buffer
+	 * @param count Number of bytes to read
+	 * @retval size_t Number of bytes copied
+	 */
+	size_t read(size_t offset, void* buffer, size_t count) const
+	{
+		return pbuf_copy_partial(buf, buffer, count, offset);
+	}
+
+	/**
+	 * @brief Get a single byte of content
+	 */
+	uint8_t operator[](size_t offset) const
+	{
+		return pbuf_get_at(buf, offset);
+	}
+
+	/**
+	 * @brief Get a copy of the content
+	 */
+	String toString() const
+	{
+		String s;
+		if(s.setLength(length())) {
+			read(0, s.begin(), s.length());
+		}
+		return s;
+	}
+
+	/**
+	 * @brief Get the underlying network buffer chain
+	 */
+	pbuf* getBuffer() const
+	{
+		return buf;
+	}
+
+private:
+	pbuf* buf;
+};
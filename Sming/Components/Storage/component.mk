@@ -4,6 +4,15 @@ COMPONENT_DOXYGEN_INPUT := src/include
 
 COMPONENT_RELINK_VARS := PARTITION_TABLE_OFFSET
 
+# Track flash erase counts and redundant writes
+COMPONENT_VARS		+= ENABLE_STORAGE_WEAR_STATS
+ifeq ($(SMING_ARCH),Host)
+ENABLE_STORAGE_WEAR_STATS ?= 1
+else
+ENABLE_STORAGE_WEAR_STATS ?= 0
+endif
+GLOBAL_CFLAGS		+= -DENABLE_STORAGE_WEAR_STATS=$(ENABLE_STORAGE_WEAR_STATS)
+
 CONFIG_VARS			+= HWCONFIG HWCONFIG_OPTS
 ifndef HWCONFIG
 override HWCONFIG	:= standard
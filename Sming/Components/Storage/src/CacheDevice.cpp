@@ -0,0 +1,299 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CacheDevice.cpp
+ *
+ ****/
+
+#include "include/Storage/CacheDevice.h"
+#include <debug_progmem.h>
+
+namespace Storage
+{
+CacheDevice::CacheDevice(Device& device, uint8_t slotCount)
+	: device(device), blockSize(std::max(device.getBlockSize(), size_t(1))), slotCount(slotCount)
+{
+	if(slotCount != 0) {
+		slots.reset(new Slot[slotCount]{});
+		buffer.reset(new uint8_t[slotCount * blockSize]);
+	}
+}
+
+CacheDevice::~CacheDevice()
+{
+	flush();
+}
+
+String CacheDevice::getName() const
+{
+	return F("cache_") + device.getName();
+}
+
+Partition CacheDevice::createPartition(const Partition& part)
+{
+	return createPartition(part.name(), part.type(), part.subType(), part.address(), part.size(), part.flags());
+}
+
+bool CacheDevice::flush()
+{
+	bool ok{true};
+	for(unsigned i = 0; i < slotCount; ++i) {
+		auto& slot = slots[i];
+		if(slot.valid) {
+			ok &= writeBack(slot);
+		}
+	}
+	return ok;
+}
+
+void CacheDevice::invalidate()
+{
+	for(unsigned i = 0; i < slotCount; ++i) {
+		slots[i].valid = false;
+	}
+	haveLastMiss = false;
+}
+
+/*
+ * The final block may be truncated if device size isn't a whole number of blocks
+ */
+size_t CacheDevice::getBlockLength(uint32_t block) const
+{
+	return std::min(blockSize, getSize() - block * blockSize);
+}
+
+CacheDevice::Slot* CacheDevice::find(uint32_t block)
+{
+	for(unsigned i = 0; i < slotCount; ++i) {
+		auto& slot = slots[i];
+		if(slot.valid && slot.block == block) {
+			return &slot;
+		}
+	}
+	return nullptr;
+}
+
+/*
+ * Obtain a slot for a block, evicting the least-recently used one if necessary
+ */
+CacheDevice::Slot* CacheDevice::allocate(uint32_t block)
+{
+	Slot* slot{nullptr};
+	for(unsigned i = 0; i < slotCount; ++i) {
+		auto& s = slots[i];
+		if(!s.valid) {
+			slot = &s;
+			break;
+		}
+		if(slot == nullptr || s.lastUsed < slot->lastUsed) {
+			slot = &s;
+		}
+	}
+
+	if(slot->valid && !writeBack(*slot)) {
+		return nullptr;
+	}
+
+	*slot = Slot{block, ++useCounter, 0, 0, true};
+	return slot;
+}
+
+bool CacheDevice::load(Slot& slot)
+{
+	if(device.read(slot.block * blockSize, getData(slot), getBlockLength(slot.block))) {
+		return true;
+	}
+
+	debug_e("[CACHE] Read failed for block #%u of '%s'", slot.block, device.getName().c_str());
+	slot.valid = false;
+	return false;
+}
+
+/*
+ * Locate a block in the cache, adding it if necessary
+ * If `load` is false then the caller is going to overwrite the entire block so it isn't read from the device
+ */
+CacheDevice::Slot* CacheDevice::get(uint32_t block, bool load)
+{
+	auto slot = find(block);
+	if(slot != nullptr) {
+		++stats.hits;
+		slot->lastUsed = ++useCounter;
+		return slot;
+	}
+
+	++stats.misses;
+	slot = allocate(block);
+	if(slot == nullptr) {
+		return nullptr;
+	}
+	if(!load) {
+		return slot;
+	}
+	if(!this->load(*slot)) {
+		return nullptr;
+	}
+
+	// Sequential access, so read the next block as well
+	auto next = block + 1;
+	if(haveLastMiss && block == lastMiss + 1 && slotCount > 1 && next * blockSize < getSize() &&
+	   find(next) == nullptr) {
+		auto ra = allocate(next);
+		if(ra != nullptr && this->load(*ra)) {
+			++stats.readAheads;
+			block = next;
+		}
+	}
+	lastMiss = block;
+	haveLastMiss = true;
+
+	return slot;
+}
+
+bool CacheDevice::writeBack(Slot& slot)
+{
+	if(slot.dirtyEnd == 0) {
+		return true;
+	}
+
+	auto length = slot.dirtyEnd - slot.dirtyStart;
+	if(!device.write(slot.block * blockSize + slot.dirtyStart, getData(slot) + slot.dirtyStart, length)) {
+		debug_e("[CACHE] Write failed for block #%u of '%s'", slot.block, device.getName().c_str());
+		return false;
+	}
+
+	++stats.writeBacks;
+	slot.dirtyEnd = 0;
+	return true;
+}
+
+bool CacheDevice::read(uint32_t address, void* dst, size_t size)
+{
+	if(slotCount == 0) {
+		return device.read(address, dst, size);
+	}
+
+	if(address + size > getSize()) {
+		return false;
+	}
+
+	auto buf = static_cast<uint8_t*>(dst);
+	while(size != 0) {
+		uint32_t block = address / blockSize;
+		size_t offset = address % blockSize;
+		size_t count = std::min(size, blockSize - offset);
+		auto slot = get(block, true);
+		if(slot == nullptr) {
+			return false;
+		}
+		memcpy(buf, getData(*slot) + offset, count);
+		buf += count;
+		address += count;
+		size -= count;
+	}
+
+	return true;
+}
+
+bool CacheDevice::write(uint32_t address, const void* src, size_t size)
+{
+	if(slotCount == 0) {
+		return device.write(address, src, size);
+	}
+
+	if(address + size > getSize()) {
+		return false;
+	}
+
+	// Programming flash can only clear bits
+	bool isFlash = (device.getType() == Type::flash);
+
+	auto buf = static_cast<const uint8_t*>(src);
+	while(size != 0) {
+		uint32_t block = address / blockSize;
+		size_t offset = address % blockSize;
+		size_t count = std::min(size, blockSize - offset);
+		bool wholeBlock = (offset == 0 && count == getBlockLength(block));
+		auto slot = get(block, isFlash || !wholeBlock);
+		if(slot == nullptr) {
+			return false;
+		}
+
+		auto data = getData(*slot) + offset;
+		if(isFlash) {
+			for(unsigned i = 0; i < count; ++i) {
+				data[i] &= buf[i];
+			}
+		} else {
+			memcpy(data, buf, count);
+		}
+
+		if(slot->dirtyEnd == 0) {
+			slot->dirtyStart = offset;
+			slot->dirtyEnd = offset + count;
+		} else {
+			slot->dirtyStart = std::min(slot->dirtyStart, offset);
+			slot->dirtyEnd = std::max(slot->dirtyEnd, offset + count);
+		}
+
+		buf += count;
+		address += count;
+		size -= count;
+	}
+
+	return true;
+}
+
+bool CacheDevice::erase_range(uint32_t address, size_t size)
+{
+	if(slotCount == 0) {
+		return device.erase_range(address, size);
+	}
+
+	auto endAddress = address + size;
+	auto isCovered = [&](const Slot& slot) {
+		auto start = slot.block * blockSize;
+		return start >= address && start + getBlockLength(slot.block) <= endAddress;
+	};
+
+	// Partially erased blocks must be written out first and re-read later
+	for(unsigned i = 0; i < slotCount; ++i) {
+		auto& slot = slots[i];
+		if(!slot.valid || isCovered(slot)) {
+			continue;
+		}
+		auto start = slot.block * blockSize;
+		if(start >= endAddress || start + getBlockLength(slot.block) <= address) {
+			continue;
+		}
+		if(!writeBack(slot)) {
+			return false;
+		}
+		slot.valid = false;
+	}
+
+	++stats.erases;
+	bool ok = device.erase_range(address, size);
+
+	// Erased flash reads as 0xFF, other devices are undefined
+	bool isFlash = (device.getType() == Type::flash);
+	for(unsigned i = 0; i < slotCount; ++i) {
+		auto& slot = slots[i];
+		if(!slot.valid || !isCovered(slot)) {
+			continue;
+		}
+		if(ok && isFlash) {
+			memset(getData(slot), 0xFF, getBlockLength(slot.block));
+			slot.dirtyEnd = 0;
+		} else {
+			slot.valid = false;
+		}
+	}
+
+	return ok;
+}
+
+} // namespace Storage
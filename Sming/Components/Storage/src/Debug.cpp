@@ -65,5 +65,74 @@ void listDevices(Print& out, bool fullPartitionInfo)
 	out.println();
 }
 
+#if ENABLE_STORAGE_WEAR_STATS
+void printWearMap(Print& out)
+{
+	auto flash = Storage::spiFlash;
+	if(flash == nullptr) {
+		return;
+	}
+
+	auto& stats = flash->getWearStats();
+	out.println();
+	out.print(_F("Flash wear: "));
+	out.print(stats.erases);
+	out.print(_F(" erases, "));
+	out.print(stats.writes);
+	out.print(_F(" writes, "));
+	out.print(stats.redundantWrites);
+	out.print(_F(" redundant writes, "));
+	out.print(stats.redundantErases);
+	out.println(_F(" redundant erases"));
+
+	auto sectorSize = flash->getBlockSize();
+	auto sectorCount = flash->getSize() / sectorSize;
+	uint32_t maxCount{0};
+	for(unsigned i = 0; i < sectorCount; ++i) {
+		maxCount = std::max(maxCount, flash->getEraseCount(i));
+	}
+
+	// One character per sector, in order of increasing erase count
+	const char scale[]{".:-=+*#%@"};
+	constexpr unsigned scaleMax{sizeof(scale) - 2};
+	constexpr unsigned sectorsPerLine{64};
+	out.print(_F("Each character represents one sector: '.' = not erased, '@' = "));
+	out.print(maxCount);
+	out.println(_F(" erases"));
+
+	for(auto part : flash->partitions()) {
+		auto firstSector = part.address() / sectorSize;
+		auto partSectors = (part.size() + sectorSize - 1) / sectorSize;
+		uint32_t total{0};
+		uint32_t partMax{0};
+		for(unsigned i = 0; i < partSectors; ++i) {
+			auto count = flash->getEraseCount(firstSector + i);
+			total += count;
+			partMax = std::max(partMax, count);
+		}
+
+		out.println();
+		printPartition(out, part, false);
+		out.print(_F("  total erases "));
+		out.print(total);
+		out.print(_F(", max "));
+		out.print(partMax);
+		for(unsigned i = 0; i < partSectors; ++i) {
+			if(i % sectorsPerLine == 0) {
+				out.println();
+				out.print(_F("  0x"));
+				out.print(part.address() + i * sectorSize, HEX);
+				out.print(' ');
+			}
+			auto count = flash->getEraseCount(firstSector + i);
+			unsigned level = (count == 0) ? 0 : 1 + (uint64_t(count) * (scaleMax - 1) / maxCount);
+			out.print(scale[level]);
+		}
+		out.println();
+	}
+	out.println();
+}
+#endif
+
 } // namespace Debug
 } // namespace Storage
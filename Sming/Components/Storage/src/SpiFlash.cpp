@@ -12,6 +12,7 @@
 #include "include/Storage/partition_info.h"
 #include <esp_spi_flash.h>
 #include <debug_progmem.h>
+#include <algorithm>
 
 namespace Storage
 {
@@ -46,6 +47,16 @@ bool SpiFlash::read(uint32_t address, void* dst, size_t size)
 
 bool SpiFlash::write(uint32_t address, const void* src, size_t size)
 {
+#if ENABLE_STORAGE_WEAR_STATS
+	++wearStats.writes;
+	if(compare(address, static_cast<const uint8_t*>(src), size)) {
+		++wearStats.redundantWrites;
+		if(skipRedundantWrites) {
+			return true;
+		}
+	}
+#endif
+
 	size_t writeCount = flashmem_write(src, address, size);
 	return writeCount == size;
 }
@@ -59,14 +70,131 @@ bool SpiFlash::erase_range(uint32_t address, size_t size)
 
 	auto sec = address / SPI_FLASH_SEC_SIZE;
 	auto end = (address + size) / SPI_FLASH_SEC_SIZE;
-	while(sec < end) {
+	for(; sec < end; ++sec) {
+#if ENABLE_STORAGE_WEAR_STATS
+		++wearStats.erases;
+		if(compare(sec * SPI_FLASH_SEC_SIZE, nullptr, SPI_FLASH_SEC_SIZE)) {
+			++wearStats.redundantErases;
+			if(skipRedundantErases) {
+				continue;
+			}
+		}
+#endif
 		if(!flashmem_erase_sector(sec)) {
 			return false;
 		}
-		++sec;
+#if ENABLE_STORAGE_WEAR_STATS
+		if(allocateEraseCounts()) {
+			++eraseCounts[sec];
+		}
+#endif
+	}
+
+	return true;
+}
+
+#if ENABLE_STORAGE_WEAR_STATS
+
+namespace
+{
+constexpr uint32_t wearStatsMagic{0x32414557}; // "WEA2"
+
+struct WearStatsHeader {
+	uint32_t magic;
+	uint32_t sectorCount;
+	SpiFlash::WearStats stats;
+};
+
+} // namespace
+
+bool SpiFlash::allocateEraseCounts()
+{
+	if(!eraseCounts) {
+		auto sectorCount = getSize() / SPI_FLASH_SEC_SIZE;
+		eraseCounts.reset(new uint32_t[sectorCount]{});
 	}
+	return bool(eraseCounts);
+}
 
+/*
+ * Compare data with existing flash content in small chunks to limit stack usage
+ * If `data` is null, check for blank (erased) flash instead
+ */
+bool SpiFlash::compare(uint32_t address, const uint8_t* data, size_t size)
+{
+	uint32_t buffer[16];
+	auto bytes = reinterpret_cast<const uint8_t*>(buffer);
+	while(size != 0) {
+		auto count = std::min(size, sizeof(buffer));
+		if(flashmem_read(buffer, address, count) != count) {
+			return false;
+		}
+		if(data == nullptr) {
+			if(std::find_if(bytes, bytes + count, [](uint8_t c) { return c != 0xFF; }) != bytes + count) {
+				return false;
+			}
+		} else {
+			if(memcmp(buffer, data, count) != 0) {
+				return false;
+			}
+			data += count;
+		}
+		address += count;
+		size -= count;
+	}
 	return true;
 }
 
+uint32_t SpiFlash::getEraseCount(uint32_t sector) const
+{
+	if(!eraseCounts || sector >= getSize() / SPI_FLASH_SEC_SIZE) {
+		return 0;
+	}
+	return eraseCounts[sector];
+}
+
+void SpiFlash::resetWearStats()
+{
+	wearStats = {};
+	eraseCounts.reset();
+}
+
+bool SpiFlash::saveWearStats(Print& out) const
+{
+	WearStatsHeader hdr{wearStatsMagic, getSize() / SPI_FLASH_SEC_SIZE, wearStats};
+	if(out.write(reinterpret_cast<const uint8_t*>(&hdr), sizeof(hdr)) != sizeof(hdr)) {
+		return false;
+	}
+	for(unsigned i = 0; i < hdr.sectorCount; ++i) {
+		uint32_t count = getEraseCount(i);
+		if(out.write(reinterpret_cast<const uint8_t*>(&count), sizeof(count)) != sizeof(count)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool SpiFlash::loadWearStats(Stream& in)
+{
+	WearStatsHeader hdr;
+	if(in.readBytes(reinterpret_cast<char*>(&hdr), sizeof(hdr)) != sizeof(hdr)) {
+		return false;
+	}
+	if(hdr.magic != wearStatsMagic || hdr.sectorCount != getSize() / SPI_FLASH_SEC_SIZE) {
+		return false;
+	}
+
+	std::unique_ptr<uint32_t[]> counts(new uint32_t[hdr.sectorCount]);
+	size_t length = hdr.sectorCount * sizeof(uint32_t);
+	if(!counts || in.readBytes(reinterpret_cast<char*>(counts.get()), length) != length) {
+		return false;
+	}
+
+	wearStats = hdr.stats;
+	eraseCounts = std::move(counts);
+	return true;
+}
+
+#endif // ENABLE_STORAGE_WEAR_STATS
+
 } // namespace Storage
@@ -0,0 +1,170 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CacheDevice.h
+ *
+ ****/
+
+#pragma once
+
+#include "CustomDevice.h"
+#include <memory>
+
+/**
+ * @brief Default number of blocks cached by a CacheDevice
+ */
+#ifndef STORAGE_CACHE_SLOTS
+#define STORAGE_CACHE_SLOTS 4
+#endif
+
+namespace Storage
+{
+/**
+ * @brief Write-back block cache for another storage device
+ *
+ * Data is held in a number of slots, each of which contains one erase block of the underlying device.
+ * Slots are replaced on a least-recently-used basis.
+ *
+ * - Reads are served from cached blocks where possible.
+ *   When two consecutive blocks miss the cache the following block is also read in anticipation.
+ * - Writes are applied to cached blocks and only programmed to the device when a block is evicted,
+ *   or when `flush()` is called. Adjacent writes to a block are therefore combined into a single operation.
+ *   For flash devices, writes can only clear bits so cached data is updated accordingly.
+ * - Erase operations are passed through immediately. Cached blocks within the erased region
+ *   are updated rather than discarded.
+ *
+ * Partitions may be mirrored from the underlying device, so any filesystem mounted on them
+ * is cached without further changes:
+ *
+ * ```
+ * auto part = Storage::findPartition(F("spiffs0"));
+ * auto cache = new Storage::CacheDevice(*part.getDevice());
+ * auto fs = IFS::createSpiffsFilesystem(cache->createPartition(part));
+ * ```
+ *
+ * @note Call `flush()` before power is removed or the underlying device is accessed directly.
+ * Cache content is also flushed when the device is destroyed.
+ */
+class CacheDevice : public CustomDevice
+{
+public:
+	/**
+	 * @brief Cache performance counters
+	 */
+	struct Stats {
+		uint32_t hits;		 ///< Blocks found in the cache
+		uint32_t misses;	 ///< Blocks not found in the cache
+		uint32_t readAheads; ///< Blocks read speculatively
+		uint32_t writeBacks; ///< Program operations issued to the device
+		uint32_t erases;	 ///< Erase operations issued to the device
+	};
+
+	/**
+	 * @brief Constructor
+	 * @param device The device to cache
+	 * @param slotCount Number of blocks to cache
+	 */
+	CacheDevice(Device& device, uint8_t slotCount = STORAGE_CACHE_SLOTS);
+
+	~CacheDevice();
+
+	using CustomDevice::createPartition;
+
+	/**
+	 * @brief Create a partition with the same layout as one on the underlying device
+	 * @param part Partition on underlying device
+	 * @retval Partition Accesses the same storage area via this cache
+	 */
+	Partition createPartition(const Partition& part);
+
+	/**
+	 * @brief Write all modified blocks to the underlying device
+	 * @retval bool true on success, false if any block could not be written
+	 */
+	bool flush();
+
+	/**
+	 * @brief Discard all cached data without writing it
+	 */
+	void invalidate();
+
+	/**
+	 * @brief Get the device being cached
+	 */
+	Device& getDevice() const
+	{
+		return device;
+	}
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+
+	void resetStats()
+	{
+		stats = {};
+	}
+
+	String getName() const override;
+
+	uint32_t getId() const override
+	{
+		return device.getId();
+	}
+
+	size_t getBlockSize() const override
+	{
+		return blockSize;
+	}
+
+	size_t getSize() const override
+	{
+		return device.getSize();
+	}
+
+	Type getType() const override
+	{
+		return device.getType();
+	}
+
+	bool read(uint32_t address, void* dst, size_t size) override;
+	bool write(uint32_t address, const void* src, size_t size) override;
+	bool erase_range(uint32_t address, size_t size) override;
+
+private:
+	struct Slot {
+		uint32_t block;
+		uint32_t lastUsed;
+		size_t dirtyStart; ///< Offset of first modified byte
+		size_t dirtyEnd;   ///< Offset after last modified byte, 0 if clean
+		bool valid;
+	};
+
+	uint8_t* getData(const Slot& slot)
+	{
+		return &buffer[(&slot - slots.get()) * blockSize];
+	}
+
+	size_t getBlockLength(uint32_t block) const;
+	Slot* find(uint32_t block);
+	Slot* allocate(uint32_t block);
+	Slot* get(uint32_t block, bool load);
+	bool load(Slot& slot);
+	bool writeBack(Slot& slot);
+
+	Device& device;
+	std::unique_ptr<Slot[]> slots;
+	std::unique_ptr<uint8_t[]> buffer;
+	size_t blockSize;
+	uint32_t lastMiss{0};
+	uint32_t useCounter{0};
+	uint8_t slotCount;
+	bool haveLastMiss{false}; ///< Set when lastMiss is valid
+	Stats stats{};
+};
+
+} // namespace Storage
@@ -11,5 +11,12 @@ void printPartition(Print& out, Partition part, bool includeDevice = true);
 void listPartitions(Print& out);
 void listDevices(Print& out, bool fullPartitionInfo = true);
 
+#if ENABLE_STORAGE_WEAR_STATS
+/**
+ * @brief Print flash wear statistics with a heatmap of sector erase counts for each partition
+ */
+void printWearMap(Print& out);
+#endif
+
 } // namespace Debug
 } // namespace Storage
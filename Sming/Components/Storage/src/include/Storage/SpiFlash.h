@@ -10,6 +10,10 @@
 #pragma once
 
 #include "Device.h"
+#if ENABLE_STORAGE_WEAR_STATS
+#include <Stream.h>
+#include <memory>
+#endif
 
 namespace Storage
 {
@@ -35,6 +39,72 @@ public:
 	bool read(uint32_t address, void* dst, size_t size) override;
 	bool write(uint32_t address, const void* src, size_t size) override;
 	bool erase_range(uint32_t address, size_t size) override;
+
+#if ENABLE_STORAGE_WEAR_STATS
+	/**
+	 * @brief Flash wear statistics
+	 */
+	struct WearStats {
+		uint32_t erases;		  ///< Sector erase operations
+		uint32_t writes;		  ///< Write operations
+		uint32_t redundantWrites; ///< Writes which matched existing flash content
+		uint32_t redundantErases; ///< Sector erases where flash was already blank
+	};
+
+	const WearStats& getWearStats() const
+	{
+		return wearStats;
+	}
+
+	/**
+	 * @brief Get number of times a sector has been erased
+	 */
+	uint32_t getEraseCount(uint32_t sector) const;
+
+	/**
+	 * @brief Clear all counters
+	 */
+	void resetWearStats();
+
+	/**
+	 * @brief Choose whether to skip writes which match existing flash content
+	 * @note Redundant writes are always counted, this determines if they're actually performed
+	 */
+	void setSkipRedundantWrites(bool enable)
+	{
+		skipRedundantWrites = enable;
+	}
+
+	/**
+	 * @brief Choose whether to skip erasing sectors which are already blank
+	 * @note Redundant erases are always counted, this determines if they're actually performed
+	 */
+	void setSkipRedundantErases(bool enable)
+	{
+		skipRedundantErases = enable;
+	}
+
+	/**
+	 * @brief Write statistics in binary form, e.g. to a file
+	 * @retval bool true on success
+	 */
+	bool saveWearStats(Print& out) const;
+
+	/**
+	 * @brief Restore statistics previously written using `saveWearStats()`
+	 * @retval bool false if data is invalid or for a different flash size
+	 */
+	bool loadWearStats(Stream& in);
+
+private:
+	bool allocateEraseCounts();
+	bool compare(uint32_t address, const uint8_t* data, size_t size);
+
+	WearStats wearStats{};
+	std::unique_ptr<uint32_t[]> eraseCounts;
+	bool skipRedundantWrites{false};
+	bool skipRedundantErases{false};
+#endif
 };
 
 } // namespace Storage
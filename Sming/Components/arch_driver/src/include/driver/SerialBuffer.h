@@ -14,15 +14,44 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <sming_attr.h>
 
 /** @brief FIFO buffer used for both receive and transmit data
  *  @note For receive operations, data is written via ISR and read via task
  *  	  For transmit operations, data is written via task and read via ISR
  *  Only routines marked with __forceinline or IRAM_ATTR may be called from interrupt context.
+ *
+ *  The buffer is safe for use by a single producer and a single consumer without disabling interrupts.
+ *  The producer only modifies `writePos` and the consumer only modifies `readPos`:
+ *  each side publishes its position after the data has been transferred.
+ *  This also holds where producer and consumer run on separate cores or threads (e.g. Host UART server).
+ *
+ *  `clear()` and `resize()` modify both positions so must not run concurrently with the other side.
  */
 struct SerialBuffer {
 public:
+	/**
+	 * @brief A contiguous region within the buffer
+	 */
+	struct Span {
+		char* data;
+		size_t length;
+	};
+
+	/**
+	 * @brief Up to two contiguous regions, the second present when the region wraps
+	 */
+	struct SpanPair {
+		Span first;
+		Span second;
+
+		size_t length() const
+		{
+			return first.length + second.length;
+		}
+	};
+
 	~SerialBuffer()
 	{
 		delete[] buffer;
@@ -38,7 +67,7 @@ public:
 	 */
 	__forceinline size_t available()
 	{
-		int ret = writePos - readPos;
+		int ret = load(writePos) - load(readPos);
 		if(ret < 0) {
 			ret += size;
 		}
@@ -53,7 +82,7 @@ public:
 		if(buffer == nullptr) {
 			return 0;
 		}
-		int ret = readPos - writePos - 1;
+		int ret = load(readPos) - load(writePos) - 1;
 		if(ret < 0) {
 			ret += size;
 		}
@@ -62,7 +91,7 @@ public:
 
 	__forceinline bool isEmpty()
 	{
-		return (buffer == nullptr) || (writePos == readPos);
+		return (buffer == nullptr) || (load(writePos) == load(readPos));
 	}
 
 	__forceinline bool isFull()
@@ -93,22 +122,91 @@ public:
 		}
 
 		uint8_t c = buffer[readPos];
-		readPos = getNextPos(readPos);
+		store(readPos, getNextPos(readPos));
 		return c;
 	}
 
 	__forceinline size_t writeChar(uint8_t c)
 	{
 		size_t nextPos = getNextPos(writePos);
-		if(nextPos == readPos) {
+		if(nextPos == load(readPos)) {
 			return 0;
 		}
 
 		buffer[writePos] = c;
-		writePos = nextPos;
+		store(writePos, nextPos);
 		return 1;
 	}
 
+	/** @brief Get view of data available for reading
+	 *  @retval SpanPair Call `skipRead()` to consume data once it has been used
+	 */
+	__forceinline SpanPair readSpan()
+	{
+		size_t rp = readPos;
+		size_t wp = load(writePos);
+		if(wp >= rp) {
+			return SpanPair{{buffer + rp, wp - rp}, {buffer, 0}};
+		}
+		return SpanPair{{buffer + rp, size - rp}, {buffer, wp}};
+	}
+
+	/** @brief Get view of free space available for writing
+	 *  @retval SpanPair Call `commitWrite()` to make data available to the reader
+	 */
+	__forceinline SpanPair writeSpan()
+	{
+		if(buffer == nullptr) {
+			return SpanPair{};
+		}
+		size_t rp = load(readPos);
+		size_t wp = writePos;
+		if(rp > wp) {
+			return SpanPair{{buffer + wp, rp - wp - 1}, {buffer, 0}};
+		}
+		// Slot before read position must remain free
+		if(rp == 0) {
+			return SpanPair{{buffer + wp, size - wp - 1}, {buffer, 0}};
+		}
+		return SpanPair{{buffer + wp, size - wp}, {buffer, rp - 1}};
+	}
+
+	/** @brief Publish data placed into regions obtained via `writeSpan()`
+	 *  @param length MUST be <= value returned from writeSpan().length()
+	 */
+	__forceinline void commitWrite(size_t length)
+	{
+		size_t pos = writePos + length;
+		if(pos >= size) {
+			pos -= size;
+		}
+		store(writePos, pos);
+	}
+
+	/** @brief Copy data out of the buffer
+	 *  @param data
+	 *  @param length Maximum number of bytes to read
+	 *  @retval size_t Number of bytes read
+	 */
+	__forceinline size_t read(void* data, size_t length)
+	{
+		auto count = copyOut(readSpan(), static_cast<char*>(data), length);
+		skipRead(count);
+		return count;
+	}
+
+	/** @brief Copy data into the buffer
+	 *  @param data
+	 *  @param length Number of bytes to write
+	 *  @retval size_t Number of bytes written, may be less than requested if buffer is full
+	 */
+	__forceinline size_t write(const void* data, size_t length)
+	{
+		auto count = copyIn(writeSpan(), static_cast<const char*>(data), length);
+		commitWrite(count);
+		return count;
+	}
+
 	/** @brief find a character in the buffer
 	 *  @param c
 	 *  @retval int position relative to current read pointer, -1 if character not found
@@ -126,43 +224,101 @@ public:
 	/** @brief Access data directly within buffer
 	 *  @param void*& OUT: the data
 	 *  @retval size_t number of chars available
+	 *  @note Only the first contiguous region is returned: use `readSpan()` to obtain both
 	 */
 	__forceinline size_t getReadData(void*& data)
 	{
-		data = buffer + readPos;
-		auto wp = writePos; // Guard against ISR changing value
-		return (wp < readPos) ? size - readPos : wp - readPos;
+		auto span = readSpan();
+		data = span.first.data;
+		return span.first.length;
 	}
 
 	/** @brief Skip a number of chars starting at the given read position
-	 *  @param length MUST be <= value returned from peek()
+	 *  @param length MUST be <= value returned from readSpan().length()
 	 *  @note Provided for efficient buffer access
 	 */
 	__forceinline void skipRead(size_t length)
 	{
-		readPos += length;
-		if(readPos == size) {
-			readPos = 0;
+		size_t pos = readPos + length;
+		if(pos >= size) {
+			pos -= size;
 		}
+		store(readPos, pos);
 	}
 
 private:
-	/** @brief Get the offset for the position before the current one */
+	/** @brief Get the offset for the position after the current one */
 	__forceinline size_t getNextPos(size_t pos)
 	{
 		size_t n = pos + 1;
 		return (n == size) ? 0 : n;
 	}
 
-	/** @brief Get the offset for the position after the current one */
+	/** @brief Get the offset for the position before the current one */
 	__forceinline size_t getPrevPos(size_t pos)
 	{
 		return (pos != 0 ? pos : size) - 1;
 	}
 
+	/*
+	 * Read position owned by the other side, ensuring buffer content is accessed afterwards.
+	 * The Esp8266 has a single core so only the compiler needs restraining.
+	 */
+	__forceinline static size_t load(const size_t& pos)
+	{
+#ifdef ARCH_ESP8266
+		size_t value = *static_cast<const volatile size_t*>(&pos);
+		__asm__ __volatile__("" ::: "memory");
+		return value;
+#else
+		return __atomic_load_n(&pos, __ATOMIC_ACQUIRE);
+#endif
+	}
+
+	/*
+	 * Publish our position once buffer content has been accessed
+	 */
+	__forceinline static void store(size_t& pos, size_t value)
+	{
+#ifdef ARCH_ESP8266
+		__asm__ __volatile__("" ::: "memory");
+		*static_cast<volatile size_t*>(&pos) = value;
+#else
+		__atomic_store_n(&pos, value, __ATOMIC_RELEASE);
+#endif
+	}
+
+	__forceinline static size_t copyOut(const SpanPair& span, char* data, size_t length)
+	{
+		size_t n1 = (span.first.length < length) ? span.first.length : length;
+		if(n1 == 0) {
+			return 0;
+		}
+		memcpy(data, span.first.data, n1);
+		size_t n2 = (span.second.length < length - n1) ? span.second.length : length - n1;
+		if(n2 != 0) {
+			memcpy(data + n1, span.second.data, n2);
+		}
+		return n1 + n2;
+	}
+
+	__forceinline static size_t copyIn(const SpanPair& span, const char* data, size_t length)
+	{
+		size_t n1 = (span.first.length < length) ? span.first.length : length;
+		if(n1 == 0) {
+			return 0;
+		}
+		memcpy(span.first.data, data, n1);
+		size_t n2 = (span.second.length < length - n1) ? span.second.length : length - n1;
+		if(n2 != 0) {
+			memcpy(span.second.data, data + n1, n2);
+		}
+		return n1 + n2;
+	}
+
 private:
 	size_t size = 0;
-	size_t readPos = 0;
-	size_t writePos = 0;
+	size_t readPos = 0;  ///< Modified only by consumer
+	size_t writePos = 0; ///< Modified only by producer
 	char* buffer = nullptr;
 };
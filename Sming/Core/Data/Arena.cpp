@@ -0,0 +1,136 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Arena.cpp
+ *
+ ****/
+
+#include "Arena.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+constexpr size_t alignment{sizeof(void*)};
+
+constexpr size_t align(size_t size)
+{
+	return (size + alignment - 1) & ~(alignment - 1);
+}
+
+} // namespace
+
+struct Arena::Block {
+	Block* next;
+	size_t size;
+	size_t used;
+
+	char* data()
+	{
+		return reinterpret_cast<char*>(this + 1);
+	}
+};
+
+Arena::Block* Arena::addBlock(size_t size)
+{
+	auto block = static_cast<Block*>(malloc(sizeof(Block) + size));
+	if(block == nullptr) {
+		return nullptr;
+	}
+	block->next = head;
+	block->size = size;
+	block->used = 0;
+	head = block;
+	return block;
+}
+
+void* Arena::allocate(size_t size)
+{
+	auto block = head;
+	if(block != nullptr) {
+		size_t offset = align(block->used);
+		if(offset + size <= block->size) {
+			block->used = offset + size;
+			return block->data() + offset;
+		}
+		++overflowCount;
+	}
+
+	// Leave room for growth when extending an allocation which doesn't fit
+	size_t newSize = align(size);
+	if(block != nullptr) {
+		newSize *= 2;
+	}
+	if(newSize < blockSize) {
+		newSize = align(blockSize);
+	}
+	block = addBlock(newSize);
+	if(block == nullptr) {
+		return nullptr;
+	}
+	block->used = size;
+	return block->data();
+}
+
+char* Arena::append(char* ptr, size_t length, const char* data, size_t dataLength)
+{
+	auto block = head;
+	if(ptr != nullptr && block != nullptr && ptr + length == block->data() + block->used &&
+	   block->used + dataLength <= block->size) {
+		memcpy(ptr + length, data, dataLength);
+		block->used += dataLength;
+		return ptr;
+	}
+
+	auto newPtr = static_cast<char*>(allocate(length + dataLength));
+	if(newPtr == nullptr) {
+		return nullptr;
+	}
+	if(length != 0) {
+		memcpy(newPtr, ptr, length);
+	}
+	memcpy(newPtr + length, data, dataLength);
+	return newPtr;
+}
+
+void Arena::reset()
+{
+	if(head == nullptr) {
+		return;
+	}
+
+	if(head->next == nullptr) {
+		head->used = 0;
+		return;
+	}
+
+	// Replace all blocks with a single one big enough for everything
+	size_t total{0};
+	for(auto block = head; block != nullptr; block = block->next) {
+		total += block->size;
+	}
+	release();
+	blockSize = total;
+	addBlock(total);
+}
+
+void Arena::release()
+{
+	while(head != nullptr) {
+		auto next = head->next;
+		free(head);
+		head = next;
+	}
+}
+
+size_t Arena::used() const
+{
+	size_t total{0};
+	for(auto block = head; block != nullptr; block = block->next) {
+		total += block->used;
+	}
+	return total;
+}
@@ -0,0 +1,103 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Arena.h - Bump allocator for short-lived data
+ *
+ ****/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Allocates memory sequentially from a block, releasing everything in a single `reset()` call
+ *
+ * Intended for data with a well-defined lifetime, such as the fields of a single HTTP request.
+ * Individual allocations cannot be freed.
+ *
+ * The initial block is allocated on first use. If it fills up, additional blocks are taken
+ * from the heap. On `reset()` these are released and the initial block is enlarged to cover the
+ * total size, so an arena used repeatedly for similar data stops allocating after the first pass.
+ */
+class Arena
+{
+public:
+	/**
+	 * @brief Constructor
+	 * @param blockSize Size of initial block
+	 */
+	Arena(size_t blockSize) : blockSize(blockSize)
+	{
+	}
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	~Arena()
+	{
+		release();
+	}
+
+	/**
+	 * @brief Allocate memory
+	 * @param size Number of bytes required
+	 * @retval void* Pointer to memory, aligned to word boundary. nullptr if out of memory.
+	 */
+	void* allocate(size_t size);
+
+	/**
+	 * @brief Append data to an existing allocation
+	 * @param ptr Existing allocation, may be null
+	 * @param length Current size of allocation
+	 * @param data Data to append
+	 * @param dataLength Number of bytes to append
+	 * @retval char* Location of combined data, which may have moved. nullptr if out of memory.
+	 * @note If `ptr` is the most recent allocation it is extended in place where possible.
+	 * This allows text received in fragments to be assembled without copying.
+	 */
+	char* append(char* ptr, size_t length, const char* data, size_t dataLength);
+
+	/**
+	 * @brief Release all allocations
+	 */
+	void reset();
+
+	/**
+	 * @brief Release all allocations and memory blocks
+	 */
+	void release();
+
+	/**
+	 * @brief Get number of bytes in use, including alignment padding
+	 */
+	size_t used() const;
+
+	/**
+	 * @brief Get size of initial block
+	 */
+	size_t getBlockSize() const
+	{
+		return blockSize;
+	}
+
+	/**
+	 * @brief Get number of times an additional block has been required
+	 */
+	unsigned getOverflowCount() const
+	{
+		return overflowCount;
+	}
+
+private:
+	struct Block;
+
+	Block* addBlock(size_t size);
+
+	Block* head{nullptr}; ///< Most recently added block, linked to previous ones
+	size_t blockSize;
+	unsigned overflowCount{0};
+};
@@ -13,6 +13,7 @@
 #pragma once
 
 #include "WVector.h"
+#include "WMapIndex.h"
 
 /**
  * @brief Implementation of a HashMap for owned objects, i.e. anything created with new().
@@ -43,8 +44,11 @@
  *	}
  * 	```
  *
+ * @tparam K Key type
+ * @tparam V Object type
+ * @tparam Index Lookup strategy, see `MapIndex`
  */
-template <typename K, typename V> class ObjectMap
+template <typename K, typename V, class Index = MapIndex::Linear> class ObjectMap
 {
 public:
 	ObjectMap()
@@ -63,7 +67,7 @@ public:
 	class Value
 	{
 	public:
-		Value(ObjectMap<K, V>& map, const K& key) : map(map), key(key)
+		Value(ObjectMap& map, const K& key) : map(map), key(key)
 		{
 		}
 
@@ -113,7 +117,7 @@ public:
 		}
 
 	private:
-		ObjectMap<K, V>& map;
+		ObjectMap& map;
 		K key;
 	};
 
@@ -211,8 +215,8 @@ public:
 		if(i >= 0) {
 			delete entries[i].value;
 			entries[i].value = value;
-		} else {
-			entries.addElement(new Entry(key, value));
+		} else if(entries.addElement(new Entry(key, value))) {
+			index.added(entries.count(), keyGetter());
 		}
 	}
 
@@ -235,12 +239,7 @@ public:
 	 */
 	int indexOf(const K& key) const
 	{
-		for(unsigned i = 0; i < entries.count(); i++) {
-			if(entries[i].key == key) {
-				return i;
-			}
-		}
-		return -1;
+		return index.find(key, entries.count(), keyGetter());
 	}
 
 	/**
@@ -260,6 +259,7 @@ public:
 	void removeAt(unsigned index)
 	{
 		entries.remove(index);
+		this->index.changed(entries.count(), keyGetter());
 	}
 
 	/**
@@ -302,7 +302,7 @@ public:
 		if(index < entries.count()) {
 			value = entries[index].value;
 			entries[index].value = nullptr;
-			entries.remove(index);
+			removeAt(index);
 		}
 		return value;
 	}
@@ -313,6 +313,7 @@ public:
 	void clear()
 	{
 		entries.clear();
+		index.clear();
 	}
 
 protected:
@@ -334,8 +335,14 @@ protected:
 	};
 
 	Vector<Entry> entries;
+	Index index;
+
+	auto keyGetter() const
+	{
+		return [this](unsigned i) -> const K& { return entries[i].key; };
+	}
 
 private:
 	// Copy constructor unsafe, so prevent access
-	ObjectMap(ObjectMap<K, V>& that);
+	ObjectMap(ObjectMap& that);
 };
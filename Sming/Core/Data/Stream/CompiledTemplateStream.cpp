@@ -0,0 +1,226 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CompiledTemplateStream.cpp
+ *
+ ****/
+
+#include "CompiledTemplateStream.h"
+#include <debug_progmem.h>
+
+using Opcode = TemplateProgram::Opcode;
+
+CompiledTemplateStream::CompiledTemplateStream(const TemplateProgram& program, IDataSourceStream* source, bool owned)
+	: program(program), source(source), values(new String[program.variableCount()]), sourceOwned(owned)
+{
+	reset();
+}
+
+void CompiledTemplateStream::reset()
+{
+	value = nullptr;
+	streamPos = 0;
+	pc = 0;
+	opPos = 0;
+	readPos = 0;
+	writePos = 0;
+	valueFetched = false;
+	outputEnabled = true;
+	enableNextState = true;
+}
+
+bool CompiledTemplateStream::setVar(const String& name, const String& value)
+{
+	int i = program.indexOf(name);
+	if(i < 0) {
+		return false;
+	}
+	values[i] = value;
+	return true;
+}
+
+void CompiledTemplateStream::setVars(const Variables& vars)
+{
+	for(unsigned i = 0; i < vars.count(); ++i) {
+		setVar(vars.keyAt(i), vars.valueAt(i));
+	}
+}
+
+String CompiledTemplateStream::getValue(const char* name)
+{
+	String s;
+	if(getValueCallback) {
+		s = getValueCallback(name);
+	}
+	debug_d("[TMPL] value '%s' %sfound: \"%s\"", name, s ? "" : "NOT ", s.c_str());
+	return s;
+}
+
+String CompiledTemplateStream::getOperand(uint16_t operand)
+{
+	if(operand & TemplateProgram::constantFlag) {
+		return program.getConstant(operand);
+	}
+	auto& s = values[operand];
+	return s ? s : getValue(program.getVariableName(operand));
+}
+
+/*
+ * Same rules as SectionTemplate: numeric if A looks like a number, otherwise string comparison
+ */
+int CompiledTemplateStream::compare(uint16_t a, uint16_t b)
+{
+	String s1 = getOperand(a);
+	String s2 = getOperand(b);
+	char c = s1.length() ? s1[0] : '\0';
+	if(c == '-' || c == '+' || isdigit(c)) {
+		return s1.toInt() - s2.toInt();
+	}
+	return s1.compareTo(s2);
+}
+
+void CompiledTemplateStream::nextOp()
+{
+	++pc;
+	opPos = 0;
+	value = nullptr;
+	valueFetched = false;
+}
+
+/*
+ * Copy text from source into buffer for current instruction
+ */
+bool CompiledTemplateStream::readSource(uint32_t offset, uint16_t length)
+{
+	if(source->seekFrom(offset + opPos, SeekOrigin::Start) != int(offset + opPos)) {
+		return false;
+	}
+	size_t count = std::min(size_t(length - opPos), size_t(bufferSize - writePos));
+	count = source->readMemoryBlock(&buffer[writePos], count);
+	if(count == 0) {
+		return false;
+	}
+	opPos += count;
+	writePos += count;
+	return true;
+}
+
+/*
+ * Execute instructions until buffer is full or program completes
+ */
+void CompiledTemplateStream::fill()
+{
+	if(!buffer) {
+		buffer.reset(new char[bufferSize]);
+	}
+	readPos = 0;
+	writePos = 0;
+
+	while(writePos < bufferSize && pc < program.count()) {
+		auto& op = program[pc];
+		switch(op.code) {
+		case Opcode::literal:
+			if(!outputEnabled) {
+				nextOp();
+				break;
+			}
+			if(!readSource(op.offset, op.length)) {
+				debug_e("[TMPL] Source read failed at %u", unsigned(op.offset + opPos));
+				pc = program.count();
+				break;
+			}
+			if(opPos == op.length) {
+				nextOp();
+			}
+			break;
+
+		case Opcode::variable: {
+			if(!valueFetched) {
+				value = getOperand(op.arg);
+				valueFetched = true;
+			}
+			if(!value) {
+				// Not handled, emit tag unchanged
+				if(outputEnabled && opPos < op.length) {
+					if(!readSource(op.offset, op.length)) {
+						pc = program.count();
+						break;
+					}
+					if(opPos < op.length) {
+						break;
+					}
+				}
+				nextOp();
+				break;
+			}
+			if(outputEnabled) {
+				auto count = std::min(value.length() - opPos, size_t(bufferSize - writePos));
+				memcpy(&buffer[writePos], value.c_str() + opPos, count);
+				opPos += count;
+				writePos += count;
+				if(opPos < value.length()) {
+					break;
+				}
+			}
+			outputEnabled = enableNextState;
+			nextOp();
+			break;
+		}
+
+		case Opcode::jump:
+			pc = op.offset;
+			break;
+
+		case Opcode::ifdef:
+			pc = (getOperand(op.arg).length() != 0) ? pc + 1 : op.offset;
+			break;
+
+		case Opcode::ifndef:
+			pc = (getOperand(op.arg).length() == 0) ? pc + 1 : op.offset;
+			break;
+
+		case Opcode::ifeq:
+			pc = (compare(op.arg, op.length) == 0) ? pc + 1 : op.offset;
+			break;
+
+		case Opcode::ifneq:
+			pc = (compare(op.arg, op.length) != 0) ? pc + 1 : op.offset;
+			break;
+		}
+	}
+}
+
+uint16_t CompiledTemplateStream::readMemoryBlock(char* data, int bufSize)
+{
+	if(data == nullptr || bufSize <= 0 || source == nullptr) {
+		return 0;
+	}
+
+	if(readPos == writePos) {
+		fill();
+	}
+
+	size_t count = std::min(size_t(bufSize), size_t(writePos - readPos));
+	memcpy(data, &buffer[readPos], count);
+	return count;
+}
+
+int CompiledTemplateStream::seekFrom(int offset, SeekOrigin origin)
+{
+	if(origin == SeekOrigin::Start && offset == 0) {
+		reset();
+		return 0;
+	}
+
+	// Forward-only seeks within data already returned by readMemoryBlock
+	if(origin != SeekOrigin::Current || offset < 0 || offset > writePos - readPos) {
+		return -1;
+	}
+
+	readPos += offset;
+	streamPos += offset;
+	return streamPos;
+}
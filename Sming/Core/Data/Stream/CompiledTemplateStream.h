@@ -0,0 +1,147 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CompiledTemplateStream.h
+ *
+ ****/
+
+#pragma once
+
+#include "TemplateProgram.h"
+#include <memory>
+
+/**
+ * @brief Stream which renders a pre-compiled template
+ *
+ * Output is identical to `TemplateStream`, but as the template has already been parsed
+ * rendering is a linear walk through the program: literal text is copied directly from
+ * the source and variables are looked up by index.
+ *
+ * Example:
+ *
+ * ```
+ * static TemplateProgram program;
+ * if(!program.isValid()) {
+ *     FlashMemoryStream source(indexHtml);
+ *     program.compile(source);
+ * }
+ * auto tmpl = new CompiledTemplateStream(program, new FlashMemoryStream(indexHtml));
+ * tmpl->setVar("title", "Hello");
+ * ```
+ *
+ * @ingroup stream
+ */
+class CompiledTemplateStream : public IDataSourceStream
+{
+public:
+	using Variables = TemplateStream::Variables;
+	using GetValueDelegate = TemplateStream::GetValueDelegate;
+
+	/**
+	 * @brief Size of internal buffer used for rendering output
+	 */
+	static constexpr size_t bufferSize{512};
+
+	/**
+	 * @brief Create a compiled template stream
+	 * @param program Compiled template, must remain valid for the lifetime of this stream
+	 * @param source The template content used to compile the program
+	 * @param owned If true (default) then source will be destroyed when complete
+	 */
+	CompiledTemplateStream(const TemplateProgram& program, IDataSourceStream* source, bool owned = true);
+
+	~CompiledTemplateStream()
+	{
+		if(sourceOwned) {
+			delete source;
+		}
+	}
+
+	StreamType getStreamType() const override
+	{
+		return (source != nullptr && program.isValid()) ? eSST_Template : eSST_Invalid;
+	}
+
+	uint16_t readMemoryBlock(char* data, int bufSize) override;
+
+	int seekFrom(int offset, SeekOrigin origin) override;
+
+	bool isFinished() override
+	{
+		return readPos == writePos && pc >= program.count();
+	}
+
+	String getName() const override
+	{
+		return source ? source->getName() : nullptr;
+	}
+
+	/**
+	 * @brief Set value of a variable
+	 * @retval bool false if template does not use the variable
+	 */
+	bool setVar(const String& name, const String& value);
+
+	/**
+	 * @brief Set multiple variables
+	 */
+	void setVars(const Variables& vars);
+
+	/**
+	 * @brief Set a callback to obtain variable values
+	 * @param callback Invoked only if variable has not been set
+	 */
+	void onGetValue(GetValueDelegate callback)
+	{
+		getValueCallback = callback;
+	}
+
+	/**
+	 * @brief Suppress output following the current tag
+	 * @see `TemplateStream::enableOutput()`
+	 */
+	void enableOutput(bool enable)
+	{
+		enableNextState = enable;
+	}
+
+	bool isOutputEnabled() const
+	{
+		return outputEnabled;
+	}
+
+	/**
+	 * @brief Fetch a templated value
+	 * @param name The variable name
+	 * @retval String value, invalid to emit tag unprocessed
+	 * @note Called only for variables which have not been set
+	 */
+	virtual String getValue(const char* name);
+
+private:
+	void reset();
+	void fill();
+	void nextOp();
+	String getOperand(uint16_t operand);
+	int compare(uint16_t a, uint16_t b);
+	bool readSource(uint32_t offset, uint16_t length);
+
+	const TemplateProgram& program;
+	IDataSourceStream* source;
+	std::unique_ptr<String[]> values;
+	std::unique_ptr<char[]> buffer;
+	GetValueDelegate getValueCallback;
+	String value;		///< Value for current variable instruction
+	uint32_t streamPos; ///< Position in output stream
+	unsigned pc;		///< Current instruction
+	size_t opPos;		///< How much of current instruction output has been rendered
+	uint16_t readPos;	///< Read position in buffer
+	uint16_t writePos;	///< Amount of data in buffer
+	bool sourceOwned : 1;
+	bool valueFetched : 1;
+	bool outputEnabled : 1;
+	bool enableNextState : 1;
+};
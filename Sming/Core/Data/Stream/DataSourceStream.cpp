@@ -30,6 +30,42 @@ int IDataSourceStream::peek()
 	return -1;
 }
 
+unsigned IDataSourceStream::peekSpans(StreamSpan* spans, unsigned maxSpans, size_t offset)
+{
+	unsigned count = 0;
+	while(count < maxSpans) {
+		auto& span = spans[count];
+		span.length = peekMemoryBlock(offset, span.data);
+		if(span.length == 0) {
+			break;
+		}
+		offset += span.length;
+		++count;
+	}
+
+	return count;
+}
+
+unsigned IDataSourceStream::getSpans(StreamSpan* spans, unsigned maxSpans, char* buffer, size_t bufSize)
+{
+	if(maxSpans == 0) {
+		return 0;
+	}
+
+	auto count = peekSpans(spans, maxSpans);
+	if(count != 0) {
+		return count;
+	}
+
+	auto len = readMemoryBlock(buffer, bufSize);
+	if(len == 0) {
+		return 0;
+	}
+
+	spans[0] = {buffer, len};
+	return 1;
+}
+
 size_t IDataSourceStream::readBytes(char* buffer, size_t length)
 {
 	auto count = readMemoryBlock(buffer, length);
@@ -38,6 +38,15 @@ enum StreamType {
 	eSST_Unknown		 ///< Unknown data stream type
 };
 
+/**
+ * @brief Describes a contiguous block of stream content
+ * @ingroup stream
+ */
+struct StreamSpan {
+	const char* data;
+	size_t length;
+};
+
 /**
  * @brief Base class for read-only stream
  * @ingroup stream
@@ -75,6 +84,48 @@ public:
      */
 	virtual uint16_t readMemoryBlock(char* data, int bufSize) = 0;
 
+	/**
+	 * @brief Obtain direct access to stream content without copying
+	 * @param offset Position relative to the current read position
+	 * @param data On success, points to stream content
+	 * @retval size_t Number of contiguous bytes available at `data`, 0 if not supported
+	 *
+	 * Memory-based streams override this so their content may be referenced directly,
+	 * for example by `TcpConnection` when operating in zero-copy mode.
+	 *
+	 * Returned data remains valid and unchanged until the stream is written to or destroyed.
+	 * The read position is not affected; use `seek()` to consume data.
+	 */
+	virtual size_t peekMemoryBlock(size_t offset, const char*& data)
+	{
+		(void)offset;
+		(void)data;
+		return 0;
+	}
+
+	/**
+	 * @brief Obtain a list of regions describing stream content without copying
+	 * @param spans Array to receive the region descriptors
+	 * @param maxSpans Number of entries available in `spans`
+	 * @param offset Position relative to the current read position
+	 * @retval unsigned Number of spans obtained, 0 if direct access is not supported
+	 *
+	 * The default implementation makes successive calls to `peekMemoryBlock()`,
+	 * so the same validity rules apply.
+	 */
+	virtual unsigned peekSpans(StreamSpan* spans, unsigned maxSpans, size_t offset = 0);
+
+	/**
+	 * @brief Obtain stream content as a list of regions, copying only if direct access is not supported
+	 * @param spans Array to receive the region descriptors
+	 * @param maxSpans Number of entries available in `spans`
+	 * @param buffer Used to store stream content if it cannot be accessed directly
+	 * @param bufSize Size of `buffer`
+	 * @retval unsigned Number of spans obtained, 0 if no data is available
+	 * @note The read position is not affected; use `seek()` to consume data
+	 */
+	unsigned getSpans(StreamSpan* spans, unsigned maxSpans, char* buffer, size_t bufSize);
+
 	/**
 	 * @brief Read one character and moves the stream pointer
 	 * @retval The character that was read or -1 if none is available
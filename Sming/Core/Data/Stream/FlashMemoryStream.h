@@ -18,4 +18,40 @@
  * @brief Provides a read-only stream buffer on flash storage
  * @ingroup stream
  */
-using FlashMemoryStream = FSTR::Stream;
+class FlashMemoryStream : public FSTR::Stream
+{
+public:
+	FlashMemoryStream(const FSTR::ObjectBase& object, bool flashRead = true)
+		: FSTR::Stream(object, flashRead), object(object)
+	{
+	}
+
+	/**
+	 * @brief Flash content may be referenced directly where it is byte-addressable
+	 * @note The Esp8266 requires aligned 32-bit access for flash memory, so returns 0 to force copying
+	 */
+	size_t peekMemoryBlock(size_t offset, const char*& data) override
+	{
+#ifdef ARCH_ESP8266
+		(void)offset;
+		(void)data;
+		return 0;
+#else
+		int pos = seekFrom(0, SeekOrigin::Current);
+		if(pos < 0) {
+			return 0;
+		}
+		size_t size = object.size();
+		offset += size_t(pos);
+		if(offset >= size) {
+			return 0;
+		}
+
+		data = reinterpret_cast<const char*>(object.data()) + offset;
+		return size - offset;
+#endif
+	}
+
+private:
+	const FSTR::ObjectBase& object;
+};
@@ -27,6 +27,7 @@ void FileStream::attach(FileHandle file, size_t size)
 	this->size = size;
 	fs->lseek(handle, 0, SeekOrigin::Start);
 	pos = 0;
+	bytesRead = 0;
 
 	debug_d("attached file: '%s' (%u bytes) #0x%08X", fileName().c_str(), size, this);
 }
@@ -65,6 +66,7 @@ void FileStream::close()
 	size = 0;
 	pos = 0;
 	lastError = FS_OK;
+	invalidateReadAhead();
 }
 
 size_t FileStream::readBytes(char* buffer, size_t length)
@@ -75,14 +77,76 @@ size_t FileStream::readBytes(char* buffer, size_t length)
 
 	GET_FS(0)
 
-	int available = fs->read(handle, buffer, std::min(size - pos, length));
+	length = std::min(size - pos, length);
+
+	// Use any buffered content first
+	size_t count{0};
+	if(pos >= readAheadPos && pos < readAheadPos + readAheadLength) {
+		count = std::min(length, readAheadPos + readAheadLength - pos);
+		memcpy(buffer, &readAhead[pos - readAheadPos], count);
+		pos += count;
+		(void)fs->lseek(handle, pos, SeekOrigin::Start);
+		if(count == length) {
+			return count;
+		}
+	}
+
+	int available = fs->read(handle, buffer + count, length - count);
 	if(!check(available)) {
-		return 0;
+		return count;
 	}
 
+	bytesRead += size_t(available);
 	pos += size_t(available);
 
-	return available;
+	return count + available;
+}
+
+/*
+ * Ensure read-ahead buffer contains data from current position.
+ * Content already buffered is retained. File position is left unchanged.
+ */
+size_t FileStream::fillReadAhead(size_t length)
+{
+	GET_FS(0)
+
+	if(!readAhead) {
+		readAhead.reset(new char[readAheadSize]);
+		if(!readAhead) {
+			readAheadSize = 0;
+			return 0;
+		}
+		readAheadLength = 0;
+	}
+
+	size_t offset = pos - readAheadPos;
+	if(pos >= readAheadPos && offset < readAheadLength) {
+		if(readAheadLength - offset >= length) {
+			return readAheadLength - offset;
+		}
+		// Keep what we have and top up
+		memmove(&readAhead[0], &readAhead[offset], readAheadLength - offset);
+		readAheadLength -= offset;
+	} else {
+		readAheadLength = 0;
+	}
+	readAheadPos = pos;
+
+	size_t readPos = pos + readAheadLength;
+	size_t count = std::min(size_t(readAheadSize - readAheadLength), size - readPos);
+	if(count != 0) {
+		if(readAheadLength != 0) {
+			(void)fs->lseek(handle, readPos, SeekOrigin::Start);
+		}
+		int res = fs->read(handle, &readAhead[readAheadLength], count);
+		if(check(res)) {
+			bytesRead += size_t(res);
+			readAheadLength += res;
+		}
+		(void)fs->lseek(handle, pos, SeekOrigin::Start);
+	}
+
+	return readAheadLength;
 }
 
 uint16_t FileStream::readMemoryBlock(char* data, int bufSize)
@@ -90,13 +154,25 @@ uint16_t FileStream::readMemoryBlock(char* data, int bufSize)
 	GET_FS(0)
 
 	assert(bufSize >= 0);
-	size_t startPos = pos;
-	size_t count = readBytes(data, bufSize);
 
-	// Move cursor back to start position
-	(void)fs->lseek(handle, startPos, SeekOrigin::Start);
-	pos = startPos;
+	if(readAheadSize == 0) {
+		size_t startPos = pos;
+		size_t count = readBytes(data, bufSize);
+
+		// Move cursor back to start position
+		(void)fs->lseek(handle, startPos, SeekOrigin::Start);
+		pos = startPos;
 
+		return count;
+	}
+
+	if(data == nullptr || bufSize == 0 || pos >= size) {
+		return 0;
+	}
+
+	size_t length = std::min(size - pos, std::min(size_t(bufSize), size_t(readAheadSize)));
+	size_t count = std::min(length, fillReadAhead(length));
+	memcpy(data, &readAhead[pos - readAheadPos], count);
 	return count;
 }
 
@@ -113,6 +189,8 @@ size_t FileStream::write(const uint8_t* buffer, size_t size)
 		pos = size_t(writePos);
 	}
 
+	invalidateReadAhead();
+
 	int written = fs->write(handle, buffer, size);
 	if(check(written)) {
 		pos += size_t(written);
@@ -185,6 +263,8 @@ bool FileStream::truncate(size_t newSize)
 		return 0;
 	}
 
+	invalidateReadAhead();
+
 	bool res = check(fs->ftruncate(handle, newSize));
 	if(res) {
 		size = newSize;
@@ -12,12 +12,26 @@
 
 #include "../ReadWriteStream.h"
 #include <IFS/FsBase.h>
+#include <memory>
+
+/**
+ * @brief Default size of FileStream read-ahead buffer
+ *
+ * Set to 0 to disable read-ahead by default.
+ */
+#ifndef FILESTREAM_READ_AHEAD_SIZE
+#define FILESTREAM_READ_AHEAD_SIZE 1024
+#endif
 
 namespace IFS
 {
 /**
  * @brief    File stream class
  * @ingroup  stream data
+ *
+ * Content obtained via `readMemoryBlock()` is retained in a read-ahead buffer.
+ * Callers such as `TcpConnection` often consume only part of each block before reading again,
+ * so the remainder is then served from RAM instead of being read from the device a second time.
  */
 class FileStream : public FsBase, public ReadWriteStream
 {
@@ -146,10 +160,42 @@ public:
 		return check(fs->fstat(handle, &s));
 	}
 
+	/** @brief Set size of read-ahead buffer
+	 *  @param size Size in bytes, 0 to disable
+	 *  @note Buffer is allocated on first call to `readMemoryBlock()`.
+	 *  This also limits the amount of data returned by each call.
+	 */
+	void setReadAhead(uint16_t size)
+	{
+		readAheadSize = size;
+		readAhead.reset();
+		readAheadLength = 0;
+	}
+
+	/** @brief Get number of bytes read from the filesystem
+	 *  @note Use to evaluate effectiveness of read-ahead buffering
+	 */
+	size_t getBytesRead() const
+	{
+		return bytesRead;
+	}
+
 private:
+	size_t fillReadAhead(size_t length);
+
+	void invalidateReadAhead()
+	{
+		readAheadLength = 0;
+	}
+
 	FileHandle handle{-1};
 	size_t pos{0};
 	size_t size{0};
+	size_t bytesRead{0};
+	std::unique_ptr<char[]> readAhead;
+	size_t readAheadPos{0};		 ///< File offset of buffered content
+	uint16_t readAheadLength{0}; ///< Number of bytes in buffer
+	uint16_t readAheadSize{FILESTREAM_READ_AHEAD_SIZE};
 };
 
 } // namespace IFS
@@ -22,6 +22,17 @@ uint16_t LimitedMemoryStream::readMemoryBlock(char* data, int bufSize)
 	return written;
 }
 
+size_t LimitedMemoryStream::peekMemoryBlock(size_t offset, const char*& data)
+{
+	size_t pos = readPos + offset;
+	if(buffer == nullptr || pos >= writePos) {
+		return 0;
+	}
+
+	data = buffer + pos;
+	return writePos - pos;
+}
+
 int LimitedMemoryStream::seekFrom(int offset, SeekOrigin origin)
 {
 	size_t newPos;
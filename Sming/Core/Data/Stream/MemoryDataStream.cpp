@@ -72,6 +72,17 @@ uint16_t MemoryDataStream::readMemoryBlock(char* data, int bufSize)
 	return available;
 }
 
+size_t MemoryDataStream::peekMemoryBlock(size_t offset, const char*& data)
+{
+	size_t pos = readPos + offset;
+	if(buffer == nullptr || pos >= size) {
+		return 0;
+	}
+
+	data = buffer + pos;
+	return size - pos;
+}
+
 int MemoryDataStream::seekFrom(int offset, SeekOrigin origin)
 {
 	size_t newPos;
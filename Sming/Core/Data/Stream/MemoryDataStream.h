@@ -73,6 +73,8 @@ public:
 
 	uint16_t readMemoryBlock(char* data, int bufSize) override;
 
+	size_t peekMemoryBlock(size_t offset, const char*& data) override;
+
 	int seekFrom(int offset, SeekOrigin origin) override;
 
 	bool isFinished() override
@@ -12,7 +12,7 @@
 
 #include "MultiStream.h"
 
-uint16_t MultiStream::readMemoryBlock(char* data, int bufSize)
+bool MultiStream::nextStream()
 {
 	if(stream && stream->isFinished()) {
 		stream.reset();
@@ -22,11 +22,26 @@ uint16_t MultiStream::readMemoryBlock(char* data, int bufSize)
 		stream.reset(getNextStream());
 		if(!stream) {
 			finished = true;
-			return 0;
+			return false;
 		}
 	}
 
-	return stream->readMemoryBlock(data, bufSize);
+	return true;
+}
+
+uint16_t MultiStream::readMemoryBlock(char* data, int bufSize)
+{
+	return nextStream() ? stream->readMemoryBlock(data, bufSize) : 0;
+}
+
+size_t MultiStream::peekMemoryBlock(size_t offset, const char*& data)
+{
+	return nextStream() ? stream->peekMemoryBlock(offset, data) : 0;
+}
+
+unsigned MultiStream::peekSpans(StreamSpan* spans, unsigned maxSpans, size_t offset)
+{
+	return nextStream() ? stream->peekSpans(spans, maxSpans, offset) : 0;
 }
 
 bool MultiStream::seek(int len)
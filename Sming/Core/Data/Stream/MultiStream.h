@@ -25,6 +25,13 @@ class MultiStream : public IDataSourceStream
 public:
 	uint16_t readMemoryBlock(char* data, int bufSize) override;
 
+	/**
+	 * @brief Content is only available from the current stream
+	 */
+	size_t peekMemoryBlock(size_t offset, const char*& data) override;
+
+	unsigned peekSpans(StreamSpan* spans, unsigned maxSpans, size_t offset = 0) override;
+
 	bool seek(int len) override;
 
 	bool isFinished() override
@@ -41,6 +48,8 @@ protected:
 	virtual IDataSourceStream* getNextStream() = 0;
 
 private:
+	bool nextStream();
+
 	std::unique_ptr<IDataSourceStream> stream;
 	bool finished{false};
 };
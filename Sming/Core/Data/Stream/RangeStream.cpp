@@ -0,0 +1,61 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * RangeStream.cpp
+ *
+ ****/
+
+#include "RangeStream.h"
+
+uint16_t RangeStream::readMemoryBlock(char* data, int bufSize)
+{
+	if(source == nullptr || data == nullptr || bufSize <= 0 || pos >= length) {
+		return 0;
+	}
+
+	if(!positioned) {
+		int newPos = start + pos;
+		if(source->seekFrom(newPos, SeekOrigin::Start) != newPos) {
+			return 0;
+		}
+		positioned = true;
+	}
+
+	size_t count = std::min(size_t(bufSize), length - pos);
+	return source->readMemoryBlock(data, count);
+}
+
+int RangeStream::seekFrom(int offset, SeekOrigin origin)
+{
+	size_t newPos;
+	switch(origin) {
+	case SeekOrigin::Start:
+		newPos = offset;
+		break;
+	case SeekOrigin::Current:
+		newPos = pos + offset;
+		break;
+	case SeekOrigin::End:
+		newPos = length + offset;
+		break;
+	default:
+		return -1;
+	}
+
+	if(newPos > length) {
+		return -1;
+	}
+
+	// Keep source in step for sequential reads, otherwise re-position on next read
+	if(positioned && origin == SeekOrigin::Current) {
+		positioned = source->seek(offset);
+	} else {
+		positioned = false;
+	}
+
+	pos = newPos;
+	return pos;
+}
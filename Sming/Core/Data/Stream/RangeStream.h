@@ -0,0 +1,94 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * RangeStream.h
+ *
+ ****/
+
+#pragma once
+
+#include "DataSourceStream.h"
+
+/**
+ * @brief Presents a region of another stream
+ * @ingroup stream
+ *
+ * The source must support `seekFrom()`, such as a `FileStream`, `FlashMemoryStream` or `Storage::PartitionStream`.
+ * The source is positioned at the start of the region when content is first read,
+ * so several non-owning instances may share a source provided they are read one after another.
+ */
+class RangeStream : public IDataSourceStream
+{
+public:
+	/**
+	 * @brief Constructor
+	 * @param source Stream to read from
+	 * @param start Offset of region within source
+	 * @param length Size of region
+	 * @param owned If true, source will be destroyed along with this stream
+	 */
+	RangeStream(IDataSourceStream* source, size_t start, size_t length, bool owned = true)
+		: source(source), start(start), length(length), owned(owned)
+	{
+	}
+
+	~RangeStream()
+	{
+		if(owned) {
+			delete source;
+		}
+	}
+
+	/*
+	 * Must not report the source type, as callers use this to downcast the stream
+	 */
+	StreamType getStreamType() const override
+	{
+		return source ? eSST_Unknown : eSST_Invalid;
+	}
+
+	int available() override
+	{
+		return length - pos;
+	}
+
+	uint16_t readMemoryBlock(char* data, int bufSize) override;
+
+	int seekFrom(int offset, SeekOrigin origin) override;
+
+	bool isFinished() override
+	{
+		return pos >= length;
+	}
+
+	String id() const override
+	{
+		return source ? source->id() : nullptr;
+	}
+
+	String getName() const override
+	{
+		return source ? source->getName() : nullptr;
+	}
+
+	MimeType getMimeType() const override
+	{
+		return source ? source->getMimeType() : MIME_UNKNOWN;
+	}
+
+	IDataSourceStream* getSource() const
+	{
+		return source;
+	}
+
+private:
+	IDataSourceStream* source;
+	size_t start;
+	size_t length;
+	size_t pos{0};
+	bool owned;
+	bool positioned{false}; ///< Set once source is at start + pos
+};
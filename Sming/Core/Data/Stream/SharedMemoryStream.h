@@ -56,6 +56,17 @@ public:
 		return written;
 	}
 
+	size_t peekMemoryBlock(size_t offset, const char*& data) override
+	{
+		size_t pos = readPos + offset;
+		if(pos >= capacity) {
+			return 0;
+		}
+
+		data = reinterpret_cast<const char*>(buffer.get()) + pos;
+		return capacity - pos;
+	}
+
 	bool seek(int len) override
 	{
 		if(readPos + len > capacity) {
@@ -0,0 +1,344 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * TemplateProgram.cpp
+ *
+ ****/
+
+#include "TemplateProgram.h"
+#include <debug_progmem.h>
+
+namespace
+{
+constexpr uint8_t maxNestingLevel{16};
+constexpr uint16_t maxLiteralLength{0xffff};
+
+bool isNumber(const char* s)
+{
+	return (*s == '-') || (*s == '+') || isdigit(*s);
+}
+
+} // namespace
+
+class TemplateProgram::Compiler
+{
+public:
+	Compiler(TemplateProgram& program, bool doubleBraces) : program(program), doubleBraces(doubleBraces)
+	{
+	}
+
+	bool parse(IDataSourceStream& source);
+
+private:
+	enum class State {
+		text,
+		openBrace,	///< Seen first '{'
+		openBrace2, ///< Seen "{{" in double-brace mode
+		name,
+		closeBrace, ///< Seen '}' in double-brace mode
+	};
+
+	struct Conditional {
+		unsigned op; ///< Instruction to patch with jump target
+		bool hasElse;
+	};
+
+	void process(char c);
+	void addLiteral(uint32_t end);
+	void addTag();
+	bool addConditional(Opcode code, char* args);
+	bool addOperand(char*& args, uint16_t& operand);
+
+	uint16_t addVariable(const char* name)
+	{
+		int i = program.indexOf(name);
+		if(i < 0) {
+			program.variables.add(name);
+			i = program.variables.count() - 1;
+		}
+		return i;
+	}
+
+	bool addOp(Opcode code, uint32_t offset, uint16_t length, uint16_t arg)
+	{
+		if(!program.ops.add(Op{offset, length, arg, code})) {
+			error = true;
+			return false;
+		}
+		return true;
+	}
+
+	TemplateProgram& program;
+	Conditional conditionals[maxNestingLevel];
+	char name[TEMPLATE_MAX_VAR_NAME_LEN + 1];
+	uint32_t pos{0};		  ///< Current source offset
+	uint32_t literalStart{0}; ///< Start of text not yet emitted
+	uint32_t tagStart{0};
+	uint8_t nameLength{0};
+	uint8_t level{0};
+	State state{State::text};
+	bool doubleBraces;
+	bool error{false};
+};
+
+bool TemplateProgram::Compiler::parse(IDataSourceStream& source)
+{
+	char buffer[128];
+	size_t len;
+	while((len = source.readBytes(buffer, sizeof(buffer))) != 0) {
+		for(unsigned i = 0; i < len; ++i) {
+			process(buffer[i]);
+		}
+		if(error) {
+			return false;
+		}
+	}
+
+	if(state == State::closeBrace) {
+		addTag();
+	}
+
+	// Incomplete tags are emitted as-is
+	addLiteral(pos);
+
+	// Unterminated conditionals end with the template
+	while(level != 0) {
+		--level;
+		program.ops[conditionals[level].op].offset = program.ops.count();
+	}
+
+	program.sourceLength = pos;
+	return !error;
+}
+
+void TemplateProgram::Compiler::process(char c)
+{
+	switch(state) {
+	case State::text:
+		break;
+
+	case State::openBrace:
+		if(doubleBraces) {
+			if(c == '{') {
+				state = State::openBrace2;
+				++pos;
+				return;
+			}
+			state = State::text;
+			break;
+		}
+		// Same rule as TemplateStream: whitespace or quote after the brace isn't a tag
+		if(c <= ' ' || c == '"') {
+			state = State::text;
+			break;
+		}
+		[[fallthrough]];
+
+	case State::openBrace2:
+		state = State::name;
+		nameLength = 0;
+		[[fallthrough]];
+
+	case State::name:
+		if(c == '}') {
+			++pos;
+			name[nameLength] = '\0';
+			if(doubleBraces) {
+				state = State::closeBrace;
+				return;
+			}
+			addTag();
+			state = State::text;
+			return;
+		}
+		if(nameLength < TEMPLATE_MAX_VAR_NAME_LEN) {
+			name[nameLength++] = c;
+			++pos;
+			return;
+		}
+		// Name too long, so not a tag
+		state = State::text;
+		break;
+
+	case State::closeBrace:
+		// Second closing brace is optional
+		if(c == '}') {
+			++pos;
+			addTag();
+			state = State::text;
+			return;
+		}
+		addTag();
+		state = State::text;
+		break;
+	}
+
+	if(c == '{') {
+		tagStart = pos;
+		state = State::openBrace;
+	}
+	++pos;
+}
+
+void TemplateProgram::Compiler::addLiteral(uint32_t end)
+{
+	while(literalStart < end) {
+		auto len = std::min(end - literalStart, uint32_t(maxLiteralLength));
+		if(!addOp(Opcode::literal, literalStart, len, 0)) {
+			return;
+		}
+		literalStart += len;
+	}
+}
+
+void TemplateProgram::Compiler::addTag()
+{
+	addLiteral(tagStart);
+	literalStart = pos;
+
+	if(name[0] == '!' && strchr(name, '{') == nullptr) {
+		// Parsing modifies the text, so work on a copy
+		char expr[sizeof(name)];
+		strcpy(expr, &name[1]);
+		char* cmd = expr;
+		char* args = strchr(cmd, ':');
+		if(args != nullptr) {
+			*args++ = '\0';
+		}
+
+		if(strcmp(cmd, "ifdef") == 0) {
+			if(addConditional(Opcode::ifdef, args)) {
+				return;
+			}
+		} else if(strcmp(cmd, "ifndef") == 0) {
+			if(addConditional(Opcode::ifndef, args)) {
+				return;
+			}
+		} else if(strcmp(cmd, "ifeq") == 0) {
+			if(addConditional(Opcode::ifeq, args)) {
+				return;
+			}
+		} else if(strcmp(cmd, "ifneq") == 0) {
+			if(addConditional(Opcode::ifneq, args)) {
+				return;
+			}
+		} else if(args == nullptr && level != 0) {
+			auto& cond = conditionals[level - 1];
+			if(strcmp(cmd, "else") == 0 && !cond.hasElse) {
+				// Jump over the 'else' block, false condition continues after this jump
+				unsigned jumpOp = program.ops.count();
+				addOp(Opcode::jump, 0, 0, 0);
+				program.ops[cond.op].offset = program.ops.count();
+				cond.op = jumpOp;
+				cond.hasElse = true;
+				return;
+			}
+			if(strcmp(cmd, "endif") == 0) {
+				program.ops[cond.op].offset = program.ops.count();
+				--level;
+				return;
+			}
+		}
+	}
+
+	addOp(Opcode::variable, tagStart, pos - tagStart, addVariable(name));
+}
+
+bool TemplateProgram::Compiler::addConditional(Opcode code, char* args)
+{
+	if(args == nullptr || level >= maxNestingLevel) {
+		return false;
+	}
+
+	uint16_t a;
+	uint16_t b{0};
+	if(!addOperand(args, a)) {
+		return false;
+	}
+	if(code == Opcode::ifeq || code == Opcode::ifneq) {
+		if(args == nullptr || !addOperand(args, b)) {
+			return false;
+		}
+	}
+	if(args != nullptr) {
+		return false;
+	}
+
+	conditionals[level++] = {program.ops.count(), false};
+	addOp(code, 0, b, a);
+	return true;
+}
+
+/*
+ * Parse an argument, leaving `args` at start of next argument or nullptr if there are no more
+ */
+bool TemplateProgram::Compiler::addOperand(char*& args, uint16_t& operand)
+{
+	char* value = args;
+	char* end;
+	bool isConstant;
+	if(*value == '"') {
+		++value;
+		end = strchr(value, '"');
+		if(end == nullptr) {
+			return false;
+		}
+		*end++ = '\0';
+		if(*end != '\0' && *end != ':') {
+			return false;
+		}
+		isConstant = true;
+	} else {
+		end = value + strcspn(value, ":");
+		isConstant = isNumber(value);
+	}
+
+	if(*end == ':') {
+		*end++ = '\0';
+		args = end;
+	} else {
+		args = nullptr;
+	}
+
+	if(isConstant) {
+		program.constants.add(value);
+		operand = (program.constants.count() - 1) | constantFlag;
+	} else {
+		operand = addVariable(value);
+	}
+	return true;
+}
+
+bool TemplateProgram::compile(IDataSourceStream& source, bool doubleBraces)
+{
+	clear();
+
+	if(source.seekFrom(0, SeekOrigin::Start) != 0) {
+		debug_e("[TMPL] Source must be seekable");
+		return false;
+	}
+
+	Compiler compiler(*this, doubleBraces);
+	if(!compiler.parse(source)) {
+		debug_e("[TMPL] Compile failed");
+		clear();
+		return false;
+	}
+
+	ops.trimToSize();
+	valid = true;
+	debug_d("[TMPL] Compiled %u bytes into %u ops, %u variables", sourceLength, ops.count(), variables.count());
+	return true;
+}
+
+void TemplateProgram::clear()
+{
+	ops.clear();
+	variables.clear();
+	constants.clear();
+	sourceLength = 0;
+	valid = false;
+}
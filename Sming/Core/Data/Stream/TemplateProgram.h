@@ -0,0 +1,147 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * TemplateProgram.h
+ *
+ ****/
+
+#pragma once
+
+#include "DataSourceStream.h"
+#include "TemplateStream.h"
+#include <Data/CStringArray.h>
+#include <WVector.h>
+
+/**
+ * @brief Pre-compiled form of a template
+ *
+ * Parsing a template for tags is done once, producing a list of instructions which
+ * can then be rendered any number of times by `CompiledTemplateStream` without scanning
+ * the source text again.
+ *
+ * The program does not contain any template text. Literal content is stored as offsets
+ * into the source, so the same content (typically a flash string or file) must be provided
+ * when rendering.
+ *
+ * Tags follow the same rules as `TemplateStream`. In addition, the `SectionTemplate` conditional
+ * commands `{!ifdef:A}`, `{!ifndef:A}`, `{!ifeq:A:B}`, `{!ifneq:A:B}`, `{!else}` and `{!endif}` are
+ * compiled into jumps. Arguments may be variable names, numbers or quoted strings.
+ * Any other tag, including other `SectionTemplate` commands, is treated as a variable name.
+ *
+ * @ingroup stream
+ */
+class TemplateProgram
+{
+public:
+	enum class Opcode : uint8_t {
+		literal,  ///< Emit source text
+		variable, ///< Emit variable value, or the source text of the tag if it has no value
+		jump,	  ///< Continue at another instruction
+		ifdef,	  ///< Continue with next instruction if A is not zero-length, otherwise jump
+		ifndef,	  ///< Continue with next instruction if A is zero-length, otherwise jump
+		ifeq,	  ///< Continue with next instruction if A == B, otherwise jump
+		ifneq,	  ///< Continue with next instruction if A != B, otherwise jump
+	};
+
+	/**
+	 * @brief A single program instruction
+	 */
+	struct Op {
+		uint32_t offset; ///< Source offset for text, target instruction for jumps
+		uint16_t length; ///< Length of text, or operand B for comparisons
+		uint16_t arg;	 ///< Variable index, or operand A for conditionals
+		Opcode code;
+	};
+
+	/**
+	 * @brief Operands with this bit set refer to constants, otherwise to variables
+	 */
+	static constexpr uint16_t constantFlag{0x8000};
+
+	/**
+	 * @brief Compile a template
+	 * @param source Template content, read from the start
+	 * @param doubleBraces true if template uses `{{X}}` to mark tags
+	 * @retval bool false on failure
+	 * @note A program may be shared by any number of `CompiledTemplateStream` instances
+	 */
+	bool compile(IDataSourceStream& source, bool doubleBraces = false);
+
+	/**
+	 * @brief Discard compiled program
+	 */
+	void clear();
+
+	/**
+	 * @brief Determine if program has been successfully compiled
+	 */
+	bool isValid() const
+	{
+		return valid;
+	}
+
+	/**
+	 * @brief Get number of instructions
+	 */
+	unsigned count() const
+	{
+		return ops.count();
+	}
+
+	const Op& operator[](unsigned index) const
+	{
+		return ops[index];
+	}
+
+	/**
+	 * @brief Get number of distinct variables referenced by the template
+	 */
+	unsigned variableCount() const
+	{
+		return variables.count();
+	}
+
+	const char* getVariableName(unsigned index) const
+	{
+		return variables[index];
+	}
+
+	/**
+	 * @brief Find index of a variable
+	 * @retval int -1 if template does not use the variable
+	 */
+	int indexOf(const char* name) const
+	{
+		return variables.indexOf(name, false);
+	}
+
+	int indexOf(const String& name) const
+	{
+		return indexOf(name.c_str());
+	}
+
+	const char* getConstant(unsigned index) const
+	{
+		return constants[index & ~constantFlag];
+	}
+
+	/**
+	 * @brief Get length of source the program was compiled from
+	 */
+	size_t getSourceLength() const
+	{
+		return sourceLength;
+	}
+
+private:
+	class Compiler;
+
+	Vector<Op> ops;
+	CStringArray variables;
+	CStringArray constants;
+	size_t sourceLength{0};
+	bool valid{false};
+};
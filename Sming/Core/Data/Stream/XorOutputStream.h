@@ -13,10 +13,15 @@
 #pragma once
 
 #include <Data/Stream/DataSourceStream.h>
+#include <stringutil.h>
+#include <memory>
 
 /**
  * @brief Xors original stream content with the specified mask
  * @ingroup stream
+ *
+ * Masks whose length is a factor of 4, such as those used for WebSocket frames,
+ * are processed a word at a time using `memxor_mask()`.
  */
 class XorOutputStream : public IDataSourceStream
 {
@@ -24,12 +29,25 @@ public:
 	/**
 	 * @brief Constructor
 	 * @param stream pointer to the original stream. Will be deleted after use
-	 * @param mask
-	 * @param maskLenth
+	 * @param mask Mask content is copied
+	 * @param maskLength
 	 */
-	XorOutputStream(IDataSourceStream* stream, uint8_t* mask, size_t maskLength)
-		: stream(stream), mask(mask), maskLength(maskLength)
+	XorOutputStream(IDataSourceStream* stream, const uint8_t* mask, size_t maskLength)
+		: stream(stream), maskLength(maskLength)
 	{
+		if(maskLength != 0 && sizeof(maskBytes) % maskLength == 0) {
+			// Repeat short masks so they can be processed word-wise
+			for(unsigned i = 0; i < sizeof(maskBytes); ++i) {
+				maskBytes[i] = mask[i % maskLength];
+			}
+			this->maskLength = sizeof(maskBytes);
+			this->mask = maskBytes;
+		} else {
+			auto buf = new uint8_t[maskLength];
+			memcpy(buf, mask, maskLength);
+			longMask.reset(buf);
+			this->mask = buf;
+		}
 	}
 
 	StreamType getStreamType() const override
@@ -44,15 +62,21 @@ public:
 
 	uint16_t readMemoryBlock(char* data, int bufSize) override
 	{
-		uint16_t max = stream->readMemoryBlock(data, bufSize);
+		uint16_t count = stream->readMemoryBlock(data, bufSize);
+		if(mask == maskBytes) {
+			memxor_mask(data, count, maskBytes, maskPos);
+			return count;
+		}
+
 		size_t pos = maskPos;
-		for(unsigned i = 0; i < max; i++) {
-			pos = pos % maskLength;
-			data[i] = (data[i] ^ mask[pos]);
-			pos++;
+		for(unsigned i = 0; i < count; i++) {
+			data[i] ^= mask[pos++];
+			if(pos == maskLength) {
+				pos = 0;
+			}
 		}
 
-		return max;
+		return count;
 	}
 
 	bool seek(int len) override
@@ -72,7 +96,9 @@ public:
 
 private:
 	std::unique_ptr<IDataSourceStream> stream;
-	uint8_t* mask;
+	uint8_t maskBytes[4];				///< Used for masks of 1, 2 or 4 bytes
+	std::unique_ptr<uint8_t[]> longMask; ///< Used for other mask lengths
+	const uint8_t* mask;
 	size_t maskLength;
 	size_t maskPos = 0;
 };
@@ -86,6 +86,19 @@ protected:
 	 */
 	virtual size_t transform(const uint8_t* in, size_t inLength, uint8_t* out, size_t outLength) = 0;
 
+	IDataSourceStream* getSourceStream() const
+	{
+		return sourceStream;
+	}
+
+	/**
+	 * @brief Determine whether any transformed output remains to be read
+	 */
+	bool isOutputPending()
+	{
+		return tempStream != nullptr && !tempStream->isFinished();
+	}
+
 private:
 	void fillTempStream(char* buffer, size_t bufSize);
 
@@ -67,6 +67,10 @@ MultipartParser::MultipartParser(HttpRequest& request, const String& boundaryArg
 	// Note: Storing the request by reference makes this object noncopyable and as a result the underlying memory of the boundary string does not change throughout the lifetime of this object.
 	multipart_parser_init(&parserEngine, boundary.c_str(), boundary.length(), &settings);
 	parserEngine.data = this;
+
+	if(request.formFields != nullptr) {
+		fieldWriter.reset(new HttpFormFields::Writer(*request.formFields, request));
+	}
 }
 
 MultipartParser* MultipartParser::create(HttpRequest& request)
@@ -140,6 +144,9 @@ int MultipartParser::partHeadersComplete(multipart_parser_t* p)
 	}
 	// get stream corresponding to field name
 	parser->stream = parser->request.files[name];
+	if(parser->stream == nullptr && parser->fieldWriter) {
+		return parser->fieldWriter->begin(name) ? 0 : -1;
+	}
 
 	// inject file name, if any
 	startPos = headerValue.indexOf(F("filename="));
@@ -209,6 +216,8 @@ int MultipartParser::partData(multipart_parser_t* p, const char* at, size_t leng
 		if(written != length) {
 			return 1;
 		}
+	} else if(parser->fieldWriter && !parser->fieldWriter->write(at, length)) {
+		return 1;
 	}
 
 	return 0;
@@ -218,6 +227,10 @@ int MultipartParser::partEnd(multipart_parser_t* p)
 {
 	GET_PARSER();
 
+	if(parser->fieldWriter && !parser->fieldWriter->end()) {
+		return 1;
+	}
+
 	parser->resetHeaders();
 
 	return 0;
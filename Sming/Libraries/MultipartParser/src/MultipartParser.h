@@ -54,12 +54,16 @@ private:
 	String boundary;
 	multipart_parser_t parserEngine;
 	ReadWriteStream* stream = nullptr;
+	std::unique_ptr<HttpFormFields::Writer> fieldWriter; ///< Set if request has form field handlers
 
 	MultipartParser(HttpRequest& request, const String& boundaryArg);
 	void resetHeaders();
 };
 
 /** Body parser for content-type `form-data/multipart`
+ *
+ * Parts are written to the matching stream in `HttpRequest::files`.
+ * If the request has form fields set, other parts are passed to those handlers. See `HttpFormFields`.
  * 
  * Must be added to the web server's list of body parsers explicitly:
  * \code{.cpp}
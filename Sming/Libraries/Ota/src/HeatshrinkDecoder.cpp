@@ -0,0 +1,150 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HeatshrinkDecoder.cpp
+ *
+ ****/
+
+#include "include/Ota/HeatshrinkDecoder.h"
+#include <debug_progmem.h>
+
+namespace Ota
+{
+HeatshrinkDecoder::HeatshrinkDecoder(Output output, uint8_t windowBits, uint8_t lookaheadBits)
+	: output(output), windowBits(windowBits), lookaheadBits(lookaheadBits)
+{
+	if(windowBits < 4 || windowBits > 15 || lookaheadBits < 3 || lookaheadBits >= windowBits) {
+		debug_e("[OTA] Invalid heatshrink parameters: w = %u, l = %u", windowBits, lookaheadBits);
+		return;
+	}
+
+	// Back-references to data before the start of the stream read zeroes
+	window.reset(new uint8_t[1U << windowBits]{});
+}
+
+bool HeatshrinkDecoder::getBits(uint8_t count, uint16_t& value)
+{
+	while(bitCount < count) {
+		if(inputSize == 0) {
+			return false;
+		}
+		bitBuffer = (bitBuffer << 8) | *input++;
+		--inputSize;
+		++inputLength;
+		bitCount += 8;
+	}
+
+	bitCount -= count;
+	value = (bitBuffer >> bitCount) & ((1U << count) - 1);
+	return true;
+}
+
+/*
+ * Add a decoded byte to the window, passing content to output when the window wraps
+ * so that each output block is contiguous
+ */
+bool HeatshrinkDecoder::put(uint8_t c)
+{
+	window[head] = c;
+	head = (head + 1) & ((1U << windowBits) - 1);
+	++pending;
+	++outputLength;
+	return (head == 0) ? flush() : true;
+}
+
+bool HeatshrinkDecoder::flush()
+{
+	if(pending == 0) {
+		return true;
+	}
+
+	unsigned end = (head == 0) ? (1U << windowBits) : head;
+	bool ok = output(&window[end - pending], pending);
+	pending = 0;
+	return ok;
+}
+
+/*
+ * The final byte is padded with zero bits, which may have been read as the start of a back-reference.
+ * That's fine provided all bits read for the incomplete item are zero and fit within a byte.
+ */
+bool HeatshrinkDecoder::isComplete() const
+{
+	unsigned paddingBits = bitCount;
+	switch(state) {
+	case State::tag:
+		return true;
+	case State::offset:
+		paddingBits += 1;
+		break;
+	case State::count:
+		if(backrefOffset != 1) {
+			return false;
+		}
+		paddingBits += 1 + windowBits;
+		break;
+	default:
+		return false;
+	}
+
+	return paddingBits < 8 && (bitBuffer & ((1U << bitCount) - 1)) == 0;
+}
+
+bool HeatshrinkDecoder::decode(const uint8_t* data, size_t size)
+{
+	if(!window || !output) {
+		return false;
+	}
+
+	input = data;
+	inputSize = size;
+
+	uint16_t value;
+	for(;;) {
+		switch(state) {
+		case State::tag:
+			if(!getBits(1, value)) {
+				return flush();
+			}
+			state = value ? State::literal : State::offset;
+			break;
+
+		case State::literal:
+			if(!getBits(8, value)) {
+				return flush();
+			}
+			if(!put(value)) {
+				return false;
+			}
+			state = State::tag;
+			break;
+
+		case State::offset:
+			if(!getBits(windowBits, value)) {
+				return flush();
+			}
+			backrefOffset = value + 1;
+			state = State::count;
+			break;
+
+		case State::count: {
+			if(!getBits(lookaheadBits, value)) {
+				return flush();
+			}
+			auto mask = (1U << windowBits) - 1;
+			for(unsigned count = value + 1; count != 0; --count) {
+				if(!put(window[(head - backrefOffset) & mask])) {
+					return false;
+				}
+			}
+			state = State::tag;
+			break;
+		}
+		}
+	}
+}
+
+} // namespace Ota
@@ -32,25 +32,41 @@ size_t UpgradeOutputStream::write(const uint8_t* data, size_t size)
 		initialized = true;
 	}
 
+	if(decoder) {
+		return decoder->decode(data, size) ? size : 0;
+	}
+
+	return writeImage(data, size) ? size : 0;
+}
+
+bool UpgradeOutputStream::writeImage(const uint8_t* data, size_t size)
+{
 	if(written + size > maxLength) {
 		debug_e("The ROM size is bigger than the maximum allowed");
-		return 0;
+		return false;
 	}
 
 	if(!ota.write(data, size)) {
 		debug_e("ota_write_flash: Failed. Size: %d", size);
-		return 0;
+		return false;
 	}
 
 	written += size;
 
 	debug_d("ota_write_flash: item.size: %d", written);
 
-	return size;
+	return true;
 }
 
 bool UpgradeOutputStream::close()
 {
+	if(initialized && decoder && !decoder->isComplete()) {
+		debug_e("[OTA] Compressed image is truncated");
+		ota.abort();
+		initialized = false;
+		return false;
+	}
+
 	if(initialized) {
 		return ota.end();
 	}
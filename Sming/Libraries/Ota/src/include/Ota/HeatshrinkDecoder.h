@@ -0,0 +1,123 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HeatshrinkDecoder.h
+ *
+ ****/
+
+#pragma once
+
+#include <Delegate.h>
+#include <memory>
+
+/**
+ * @brief Default window size for compressed images, as a power of 2
+ */
+#ifndef OTA_HEATSHRINK_WINDOW_BITS
+#define OTA_HEATSHRINK_WINDOW_BITS 10
+#endif
+
+/**
+ * @brief Default maximum back-reference length for compressed images, as a power of 2
+ */
+#ifndef OTA_HEATSHRINK_LOOKAHEAD_BITS
+#define OTA_HEATSHRINK_LOOKAHEAD_BITS 5
+#endif
+
+namespace Ota
+{
+/**
+ * @brief Streaming decoder for heatshrink-compressed data
+ *
+ * Heatshrink is an LZSS variant designed for embedded systems. Each item in the bitstream is either:
+ *
+ * - `1` followed by an 8-bit literal byte, or
+ * - `0` followed by a back-reference: window offset (`windowBits`) then length (`lookaheadBits`), both stored minus 1.
+ *
+ * Decoding requires only the window buffer, 2^windowBits bytes. Decoded data is passed to the output
+ * callback directly from the window, without further copying.
+ *
+ * The encoding parameters are not stored in the data so must match those used for compression,
+ * for example `heatshrink -e -w 10 -l 5 input output`.
+ */
+class HeatshrinkDecoder
+{
+public:
+	/**
+	 * @brief Callback to receive decoded data
+	 * @retval bool Return false to abort decoding
+	 */
+	using Output = Delegate<bool(const uint8_t* data, size_t length)>;
+
+	/**
+	 * @brief Constructor
+	 * @param output Callback to receive decoded data
+	 * @param windowBits Window size as power of 2, 4 - 15
+	 * @param lookaheadBits Maximum back-reference length as power of 2, 3 - windowBits-1
+	 */
+	HeatshrinkDecoder(Output output, uint8_t windowBits = OTA_HEATSHRINK_WINDOW_BITS,
+					  uint8_t lookaheadBits = OTA_HEATSHRINK_LOOKAHEAD_BITS);
+
+	/**
+	 * @brief Decode a block of compressed data
+	 * @param data
+	 * @param size
+	 * @retval bool false if parameters are invalid or output callback failed
+	 */
+	bool decode(const uint8_t* data, size_t size);
+
+	/**
+	 * @brief Determine whether decoding stopped at the end of an item
+	 * @retval bool false if the compressed data is truncated
+	 * @note Data truncated exactly on an item boundary cannot be detected
+	 */
+	bool isComplete() const;
+
+	/**
+	 * @brief Get number of compressed bytes processed
+	 */
+	size_t getInputLength() const
+	{
+		return inputLength;
+	}
+
+	/**
+	 * @brief Get number of decoded bytes produced
+	 */
+	size_t getOutputLength() const
+	{
+		return outputLength;
+	}
+
+private:
+	enum class State {
+		tag,
+		literal,
+		offset,
+		count,
+	};
+
+	bool getBits(uint8_t count, uint16_t& value);
+	bool put(uint8_t c);
+	bool flush();
+
+	Output output;
+	std::unique_ptr<uint8_t[]> window;
+	const uint8_t* input{nullptr};
+	size_t inputSize{0};
+	size_t inputLength{0};
+	size_t outputLength{0};
+	uint32_t bitBuffer{0};
+	uint16_t head{0};	 ///< Next write position in window
+	uint16_t pending{0}; ///< Bytes in window not yet passed to output
+	uint16_t backrefOffset{0};
+	uint8_t bitCount{0};
+	uint8_t windowBits;
+	uint8_t lookaheadBits;
+	State state{State::tag};
+};
+
+} // namespace Ota
@@ -12,6 +12,7 @@
 #pragma once
 
 #include <Ota/Upgrader.h>
+#include <Ota/HeatshrinkDecoder.h>
 #include <Storage/Partition.h>
 #include <Data/Stream/ReadWriteStream.h>
 
@@ -19,19 +20,35 @@ namespace Ota
 {
 /**
  * @brief Write-only stream type used during firmware upgrade
+ *
+ * Images may be compressed to reduce transfer time. These are decoded as data arrives,
+ * so only the decoded image is written to flash.
  */
 class UpgradeOutputStream : public ReadWriteStream
 {
 public:
 	using Partition = Storage::Partition;
 
+	/**
+	 * @brief Format of image data written to the stream
+	 */
+	enum class Compression {
+		none,		///< Raw image
+		heatshrink, ///< Compressed using default HeatshrinkDecoder parameters
+	};
+
 	/**
 	 * @brief Construct a stream for the given partition
 	 * @param partition
+	 * @param maxLength Maximum size of decoded image
+	 * @param compression Format of incoming data
 	 */
-	UpgradeOutputStream(Partition partition, size_t maxLength = 0)
+	UpgradeOutputStream(Partition partition, size_t maxLength = 0, Compression compression = Compression::none)
 		: partition(partition), maxLength(maxLength != 0 ? std::min(maxLength, partition.size()) : partition.size())
 	{
+		if(compression == Compression::heatshrink) {
+			decoder.reset(new HeatshrinkDecoder(HeatshrinkDecoder::Output(&UpgradeOutputStream::writeImage, this)));
+		}
 	}
 
 	virtual ~UpgradeOutputStream()
@@ -78,6 +95,14 @@ public:
 		return maxLength;
 	}
 
+	/**
+	 * @brief Get number of bytes received, which may be compressed
+	 */
+	size_t getInputLength() const
+	{
+		return decoder ? decoder->getInputLength() : written;
+	}
+
 protected:
 	OtaUpgrader ota;
 	Partition partition;
@@ -87,6 +112,11 @@ protected:
 
 protected:
 	virtual bool init();
+
+private:
+	bool writeImage(const uint8_t* data, size_t size);
+
+	std::unique_ptr<HeatshrinkDecoder> decoder;
 };
 
 } // namespace Ota
@@ -37,6 +37,11 @@ ReadWriteStream* StandardPayloadParser::getStorageStream(size_t storageSize)
 		return nullptr;
 	}
 
+	// Size of compressed payload doesn't limit size of decoded image
+	if(compression != Compression::none) {
+		return new Ota::UpgradeOutputStream(part, 0, compression);
+	}
+
 	return new Ota::UpgradeOutputStream(part, storageSize);
 }
 
@@ -14,6 +14,7 @@
 
 #include "PayloadParser.h"
 #include <Storage/Partition.h>
+#include <Ota/UpgradeOutputStream.h>
 
 namespace OtaUpgrade
 {
@@ -26,8 +27,18 @@ namespace Mqtt
 class StandardPayloadParser : public PayloadParser
 {
 public:
-	StandardPayloadParser(Storage::Partition part, size_t currentVersion, size_t allowedVersionBytes = 24)
-		: PayloadParser(currentVersion, allowedVersionBytes), part(part)
+	using Compression = Ota::UpgradeOutputStream::Compression;
+
+	/**
+	 * @brief Constructor
+	 * @param part Partition to write firmware to
+	 * @param currentVersion
+	 * @param allowedVersionBytes
+	 * @param compression Format of firmware data in payload
+	 */
+	StandardPayloadParser(Storage::Partition part, size_t currentVersion, size_t allowedVersionBytes = 24,
+						  Compression compression = Compression::none)
+		: PayloadParser(currentVersion, allowedVersionBytes), part(part), compression(compression)
 	{
 	}
 
@@ -37,6 +48,7 @@ public:
 
 private:
 	Storage::Partition part;
+	Compression compression;
 };
 
 } // namespace Mqtt
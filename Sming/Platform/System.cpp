@@ -32,8 +32,9 @@ os_event_t SystemClass::taskQueue[TASK_QUEUE_LENGTH];
 #endif
 
 #ifdef ENABLE_TASK_COUNT
-volatile uint8_t SystemClass::taskCount;
-volatile uint8_t SystemClass::maxTaskCount;
+volatile uint16_t SystemClass::taskCount;
+volatile uint16_t SystemClass::maxTaskCount;
+volatile uint16_t SystemClass::droppedTaskCount;
 #endif
 
 /** @brief OS calls this function which invokes user-defined callback
@@ -89,7 +90,42 @@ bool SystemClass::queueCallback(TaskCallback32 callback, uint32_t param)
 	restoreInterrupts(level);
 #endif
 
-	return system_os_post(USER_TASK_PRIO_1, reinterpret_cast<os_signal_t>(callback), param);
+	if(system_os_post(USER_TASK_PRIO_1, reinterpret_cast<os_signal_t>(callback), param)) {
+		return true;
+	}
+
+#ifdef ENABLE_TASK_COUNT
+	level = noInterrupts();
+	--taskCount;
+	++droppedTaskCount;
+	restoreInterrupts(level);
+#endif
+
+	return false;
+}
+
+bool SystemClass::getTaskQueueStats(TaskQueueStats& stats)
+{
+#ifdef ARCH_HOST
+	host_task_queue_stats info;
+	if(!host_get_task_queue_stats(USER_TASK_PRIO_1, &info)) {
+		return false;
+	}
+	stats.count = info.count;
+	stats.highWater = info.high_water;
+	stats.dropped = info.dropped;
+	return true;
+#elif defined(ENABLE_TASK_COUNT)
+	auto level = noInterrupts();
+	stats.count = taskCount;
+	stats.highWater = maxTaskCount;
+	stats.dropped = droppedTaskCount;
+	restoreInterrupts(level);
+	return true;
+#else
+	(void)stats;
+	return false;
+#endif
 }
 
 bool SystemClass::queueCallback(TaskDelegate callback)
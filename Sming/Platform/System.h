@@ -245,6 +245,23 @@ public:
 #endif
 	}
 
+	/**
+	 * @brief Task queue statistics
+	 */
+	struct TaskQueueStats {
+		unsigned count;		///< Tasks currently queued
+		unsigned highWater; ///< Maximum number of tasks queued at any one time
+		unsigned dropped;   ///< Tasks which could not be queued because the queue was full
+	};
+
+	/**
+	 * @brief Get statistics for the task queue used by `queueCallback()`
+	 * @param stats
+	 * @retval bool false if not available
+	 * @note Always available for Host, otherwise requires ENABLE_TASK_COUNT=1
+	 */
+	static bool getTaskQueueStats(TaskQueueStats& stats);
+
 private:
 	static void taskHandler(os_event_t* event);
 
@@ -252,8 +269,9 @@ private:
 	static SystemState state;
 	static os_event_t taskQueue[]; ///< OS task queue
 #ifdef ENABLE_TASK_COUNT
-	static volatile uint8_t taskCount;	///< Number of tasks on queue
-	static volatile uint8_t maxTaskCount; ///< Profiling to establish appropriate queue size
+	static volatile uint16_t taskCount;		   ///< Number of tasks on queue
+	static volatile uint16_t maxTaskCount;	   ///< Profiling to establish appropriate queue size
+	static volatile uint16_t droppedTaskCount; ///< Tasks lost due to queue overflow
 #endif
 };
 
@@ -11,6 +11,10 @@
 #include <debug_progmem.h>
 #include <esp_system.h>
 
+#if ENABLE_STORAGE_WEAR_STATS
+#include <Storage/Debug.h>
+#endif
+
 #ifndef DISABLE_NETWORK
 #include <lwip/init.h>
 #endif
@@ -45,6 +49,10 @@ void CommandHandler::registerSystemCommands()
 									CommandFunctionDelegate(&CommandHandler::procesDebugOffCommand, this)));
 	registerCommand(CommandDelegate(F("command"), F("Use verbose/silent/prompt as command options"), system,
 									CommandFunctionDelegate(&CommandHandler::processCommandOptions, this)));
+#if ENABLE_STORAGE_WEAR_STATS
+	registerCommand(CommandDelegate(F("wear"), F("Displays flash erase counts for each partition"), system,
+									CommandFunctionDelegate(&CommandHandler::procesWearCommand, this)));
+#endif
 }
 
 CommandDelegate CommandHandler::getCommandDelegate(const String& commandString)
@@ -135,6 +143,13 @@ void CommandHandler::procesDebugOffCommand(String commandLine, CommandOutput* co
 	commandOutput->println(_F("Debug set to : Off"));
 }
 
+#if ENABLE_STORAGE_WEAR_STATS
+void CommandHandler::procesWearCommand(String commandLine, CommandOutput* commandOutput)
+{
+	Storage::Debug::printWearMap(*commandOutput);
+}
+#endif
+
 void CommandHandler::processCommandOptions(String commandLine, CommandOutput* commandOutput)
 {
 	Vector<String> commandToken;
@@ -158,6 +158,9 @@ private:
 	void procesEchoCommand(String commandLine, CommandOutput* commandOutput);
 	void procesDebugOnCommand(String commandLine, CommandOutput* commandOutput);
 	void procesDebugOffCommand(String commandLine, CommandOutput* commandOutput);
+#if ENABLE_STORAGE_WEAR_STATS
+	void procesWearCommand(String commandLine, CommandOutput* commandOutput);
+#endif
 	void processCommandOptions(String commandLine, CommandOutput* commandOutput);
 
 	VerboseMode verboseMode = VERBOSE;
@@ -50,6 +50,16 @@ void *memrchr(const void *s, int c, size_t n);
 
 int memicmp(const void* buf1, const void* buf2, size_t len);
 
+/** @brief XOR a buffer in-place with a repeating 4-byte mask, as used for WebSocket payloads
+ *  @param buf Data to modify, may have any alignment
+ *  @param len Number of bytes to process
+ *  @param mask The 4-byte mask
+ *  @param maskPos Index into `mask` for first byte of `buf` (0-3)
+ *  @retval unsigned Index into `mask` for the byte following `buf`, so data may be processed in pieces
+ *  @note Data is processed a machine word at a time
+ */
+unsigned memxor_mask(void* buf, size_t len, const unsigned char mask[4], unsigned maskPos);
+
 static inline char hexchar(unsigned char c)
 {
 	if(c < 10)
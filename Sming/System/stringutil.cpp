@@ -17,6 +17,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdint.h>
 
 const char* strstri(const char* pString, const char* pToken)
 {
@@ -68,3 +69,49 @@ int memicmp(const void* buf1, const void* buf2, size_t len)
 
 	return result;
 }
+
+unsigned memxor_mask(void* buf, size_t len, const unsigned char mask[4], unsigned maskPos)
+{
+	using word_t = uintptr_t __attribute__((__may_alias__));
+
+	auto p = static_cast<uint8_t*>(buf);
+	maskPos &= 3;
+
+	// Leading bytes up to word boundary
+	while(len != 0 && (uintptr_t(p) & (sizeof(word_t) - 1)) != 0) {
+		*p++ ^= mask[maskPos];
+		maskPos = (maskPos + 1) & 3;
+		--len;
+	}
+
+	if(len >= sizeof(word_t)) {
+		// Mask bytes in memory order starting at current position; word size is a multiple of 4
+		uint8_t maskBytes[sizeof(word_t)];
+		for(unsigned i = 0; i < sizeof(word_t); ++i) {
+			maskBytes[i] = mask[(maskPos + i) & 3];
+		}
+		word_t maskWord;
+		memcpy(&maskWord, maskBytes, sizeof(maskWord));
+
+		auto wp = reinterpret_cast<word_t*>(p);
+		for(; len >= 4 * sizeof(word_t); len -= 4 * sizeof(word_t)) {
+			wp[0] ^= maskWord;
+			wp[1] ^= maskWord;
+			wp[2] ^= maskWord;
+			wp[3] ^= maskWord;
+			wp += 4;
+		}
+		for(; len >= sizeof(word_t); len -= sizeof(word_t)) {
+			*wp++ ^= maskWord;
+		}
+		p = reinterpret_cast<uint8_t*>(wp);
+	}
+
+	// Trailing bytes
+	while(len-- != 0) {
+		*p++ ^= mask[maskPos];
+		maskPos = (maskPos + 1) & 3;
+	}
+
+	return maskPos;
+}
@@ -31,12 +31,16 @@
 #include <cstdint>
 #include <iterator>
 #include <cstdlib>
+#include "WMapIndex.h"
 
 /**
  * @brief HashMap class template
+ * @tparam K Key type
+ * @tparam V Value type
+ * @tparam Index Lookup strategy, see `MapIndex`
  * @ingroup wiring
  */
-template <typename K, typename V> class HashMap
+template <typename K, typename V, class Index = MapIndex::Linear> class HashMap
 {
 public:
 	using Comparator = bool (*)(const K&, const K&);
@@ -171,6 +175,7 @@ public:
     || #
     ||
     || @parameter compare optional function for comparing a key against another (for complex types)
+    || A hashed index is not used with a custom comparator, keys are compared in turn.
     */
 	HashMap(Comparator compare) : cb_comparator(compare)
 	{
@@ -332,7 +337,7 @@ public:
 
 	void clear();
 
-	void setMultiple(const HashMap<K, V>& map);
+	template <class OtherIndex> void setMultiple(const HashMap<K, V, OtherIndex>& map);
 
 	void setNullValue(const V& nullv)
 	{
@@ -366,12 +371,18 @@ protected:
 	uint16_t currentIndex = 0;
 	uint16_t size = 0;
 	Comparator cb_comparator = nullptr;
+	Index index;
 
 private:
-	HashMap(const HashMap<K, V>& that);
+	HashMap(const HashMap& that);
+
+	auto keyGetter() const
+	{
+		return [this](unsigned i) -> const K& { return *keys[i]; };
+	}
 };
 
-template <typename K, typename V> V& HashMap<K, V>::operator[](const K& key)
+template <typename K, typename V, class Index> V& HashMap<K, V, Index>::operator[](const K& key)
 {
 	int i = indexOf(key);
 	if(i >= 0) {
@@ -383,10 +394,13 @@ template <typename K, typename V> V& HashMap<K, V>::operator[](const K& key)
 	*keys[currentIndex] = key;
 	*values[currentIndex] = nil;
 	currentIndex++;
+	if(!cb_comparator) {
+		index.added(currentIndex, keyGetter());
+	}
 	return *values[currentIndex - 1];
 }
 
-template <typename K, typename V> void HashMap<K, V>::allocate(unsigned int newSize)
+template <typename K, typename V, class Index> void HashMap<K, V, Index>::allocate(unsigned int newSize)
 {
 	if(newSize <= size)
 		return;
@@ -413,23 +427,21 @@ template <typename K, typename V> void HashMap<K, V>::allocate(unsigned int newS
 	size = newSize;
 }
 
-template <typename K, typename V> int HashMap<K, V>::indexOf(const K& key) const
+template <typename K, typename V, class Index> int HashMap<K, V, Index>::indexOf(const K& key) const
 {
+	if(!cb_comparator) {
+		return index.find(key, currentIndex, keyGetter());
+	}
+
 	for(unsigned i = 0; i < currentIndex; i++) {
-		if(cb_comparator) {
-			if(cb_comparator(key, *keys[i])) {
-				return i;
-			}
-		} else {
-			if(key == *keys[i]) {
-				return i;
-			}
+		if(cb_comparator(key, *keys[i])) {
+			return i;
 		}
 	}
 	return -1;
 }
 
-template <typename K, typename V> void HashMap<K, V>::removeAt(unsigned index)
+template <typename K, typename V, class Index> void HashMap<K, V, Index>::removeAt(unsigned index)
 {
 	if(index >= currentIndex)
 		return;
@@ -440,9 +452,12 @@ template <typename K, typename V> void HashMap<K, V>::removeAt(unsigned index)
 	}
 
 	currentIndex--;
+	if(!cb_comparator) {
+		this->index.changed(currentIndex, keyGetter());
+	}
 }
 
-template <typename K, typename V> void HashMap<K, V>::clear()
+template <typename K, typename V, class Index> void HashMap<K, V, Index>::clear()
 {
 	if(keys != nullptr) {
 		for(unsigned i = 0; i < size; i++) {
@@ -456,11 +471,14 @@ template <typename K, typename V> void HashMap<K, V>::clear()
 	}
 	currentIndex = 0;
 	size = 0;
+	index.clear();
 }
 
-template <typename K, typename V> void HashMap<K, V>::setMultiple(const HashMap<K, V>& map)
+template <typename K, typename V, class Index>
+template <class OtherIndex>
+void HashMap<K, V, Index>::setMultiple(const HashMap<K, V, OtherIndex>& map)
 {
 	for(unsigned i = 0; i < map.count(); i++) {
-		(*this)[map.keyAt(i)] = *(map.values)[i];
+		(*this)[map.keyAt(i)] = map.valueAt(i);
 	}
 }
@@ -0,0 +1,235 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * WMapIndex.h - Key lookup strategies for HashMap and ObjectMap
+ *
+ ****/
+
+#pragma once
+
+#include "WString.h"
+#include <type_traits>
+
+/**
+ * @brief Key lookup strategies for map classes
+ * @ingroup wiring
+ *
+ * Maps store entries in a contiguous list, so they can be iterated and accessed by position.
+ * An index determines how `indexOf()` locates a key in that list:
+ *
+ * - `MapIndex::Linear` compares against every key in turn. This requires no additional memory.
+ * - `MapIndex::Hashed` maintains an open-addressing hash table of positions alongside the list.
+ *   Lookups take constant time regardless of the number of entries, at a cost of 2 bytes per slot.
+ *
+ * For example:
+ *
+ * ```
+ * HashMap<String, String, MapIndex::Hashed> map;
+ * ```
+ *
+ * Hashed indices require a `hash()` overload for the key type. These are provided
+ * for String, integral, enum and pointer types. For other types, define `uint32_t hash(const K&)`
+ * in the same namespace as the key type.
+ *
+ * @note Keys must not be modified directly (e.g. via `keyAt()`) when using a hashed index.
+ */
+namespace MapIndex
+{
+/**
+ * @brief FNV-1a hash
+ */
+inline uint32_t hash(const char* data, size_t length)
+{
+	uint32_t h = 2166136261U;
+	for(size_t i = 0; i < length; ++i) {
+		h = (h ^ uint8_t(data[i])) * 16777619U;
+	}
+	return h;
+}
+
+inline uint32_t hash(const String& key)
+{
+	return hash(key.c_str(), key.length());
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, uint32_t>::type hash(T key)
+{
+	uint64_t v = uint64_t(key);
+	uint32_t h = uint32_t(v ^ (v >> 32));
+	h = (h ^ (h >> 16)) * 0x45d9f3bU;
+	h = (h ^ (h >> 16)) * 0x45d9f3bU;
+	return h ^ (h >> 16);
+}
+
+template <typename T> uint32_t hash(T* key)
+{
+	return hash(uintptr_t(key));
+}
+
+/**
+ * @brief Locate keys by comparing against every entry
+ */
+class Linear
+{
+public:
+	/**
+	 * @brief Find position of a key
+	 * @param key
+	 * @param count Number of entries in map
+	 * @param getKey Function returning key at a given position
+	 * @retval int Position of key, -1 if not found
+	 */
+	template <typename K, typename GetKey> int find(const K& key, unsigned count, GetKey getKey) const
+	{
+		for(unsigned i = 0; i < count; ++i) {
+			if(key == getKey(i)) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	/**
+	 * @brief Called after an entry has been appended to the map
+	 */
+	template <typename GetKey> void added(unsigned count, GetKey getKey)
+	{
+		(void)count;
+		(void)getKey;
+	}
+
+	/**
+	 * @brief Called after entries have been removed or re-ordered
+	 */
+	template <typename GetKey> void changed(unsigned count, GetKey getKey)
+	{
+		(void)count;
+		(void)getKey;
+	}
+
+	void clear()
+	{
+	}
+};
+
+/**
+ * @brief Locate keys using an open-addressing hash table with linear probing
+ *
+ * Each slot holds the position of an entry plus one, or 0 if free.
+ * The table is kept at most 3/4 full, and is only created once the map has `minEntries` entries:
+ * below this a linear search is faster than hashing the key.
+ */
+class Hashed
+{
+public:
+	static constexpr unsigned minEntries{8};
+
+	Hashed() = default;
+	Hashed(const Hashed&) = delete;
+
+	~Hashed()
+	{
+		delete[] slots;
+	}
+
+	template <typename K, typename GetKey> int find(const K& key, unsigned count, GetKey getKey) const
+	{
+		if(slots == nullptr) {
+			return Linear().find(key, count, getKey);
+		}
+
+		auto mask = capacity - 1;
+		for(auto i = hash(key) & mask;; i = (i + 1) & mask) {
+			unsigned pos = slots[i];
+			if(pos == 0) {
+				return -1;
+			}
+			if(key == getKey(pos - 1)) {
+				return pos - 1;
+			}
+		}
+	}
+
+	template <typename GetKey> void added(unsigned count, GetKey getKey)
+	{
+		if(count < minEntries) {
+			return;
+		}
+		if(slots == nullptr || count * 4 > capacity * 3) {
+			rebuild(count, getKey);
+			return;
+		}
+		insert(hash(getKey(count - 1)), count - 1);
+	}
+
+	template <typename GetKey> void changed(unsigned count, GetKey getKey)
+	{
+		if(count < minEntries) {
+			clear();
+			return;
+		}
+		rebuild(count, getKey);
+	}
+
+	void clear()
+	{
+		delete[] slots;
+		slots = nullptr;
+		capacity = 0;
+	}
+
+	/**
+	 * @brief Get number of bytes used by the index
+	 */
+	size_t getMemoryUsage() const
+	{
+		return capacity * sizeof(*slots);
+	}
+
+private:
+	template <typename GetKey> void rebuild(unsigned count, GetKey getKey)
+	{
+		if(count > UINT16_MAX) {
+			clear();
+			return;
+		}
+		unsigned newCapacity = minEntries * 2;
+		while(count * 4 > newCapacity * 3) {
+			newCapacity *= 2;
+		}
+		if(newCapacity != capacity) {
+			auto newSlots = new uint16_t[newCapacity];
+			if(newSlots == nullptr) {
+				// Fall back to linear search
+				clear();
+				return;
+			}
+			delete[] slots;
+			slots = newSlots;
+			capacity = newCapacity;
+		}
+		memset(slots, 0, capacity * sizeof(*slots));
+		for(unsigned i = 0; i < count; ++i) {
+			insert(hash(getKey(i)), i);
+		}
+	}
+
+	void insert(uint32_t h, unsigned pos)
+	{
+		auto mask = capacity - 1;
+		auto i = h & mask;
+		while(slots[i] != 0) {
+			i = (i + 1) & mask;
+		}
+		slots[i] = pos + 1;
+	}
+
+	uint16_t* slots{nullptr};
+	unsigned capacity{0};
+};
+
+} // namespace MapIndex
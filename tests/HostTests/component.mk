@@ -13,6 +13,7 @@ COMPONENT_INCDIRS := include
 COMPONENT_SRCDIRS := \
 	app \
 	modules \
+	modules/Arch/$(SMING_ARCH) \
 	Arch/$(SMING_ARCH)
 
 ifneq ($(DISABLE_NETWORK),1)
@@ -27,7 +28,7 @@ ARDUINO_LIBRARIES := \
 	ArduinoJson6
 
 ifeq ($(SMING_ARCH),Host)
-	ARDUINO_LIBRARIES += Hosted
+	ARDUINO_LIBRARIES += Hosted Ota
 endif
 
 COMPONENT_DEPENDS := \
@@ -11,7 +11,13 @@
 #define ARCH_TEST_MAP(XX)                                                                                              \
 	XX_NET(Hosted)                                                                                                     \
 	XX_NET(HttpRequest)                                                                                                \
-	XX_NET(TcpClient)
+	XX_NET(MqttLoopback)                                                                                               \
+	XX_NET(TcpClient)                                                                                                  \
+	XX_NET(TcpZeroCopy)                                                                                                \
+	XX_NET(UdpLoopback)                                                                                                \
+	XX_NET(WebsocketBroadcast)                                                                                         \
+	XX(Flashmem)                                                                                                       \
+	XX(Ota)
 #else
 #define ARCH_TEST_MAP(XX)
 #endif
@@ -34,7 +40,9 @@
 	XX_NET(Base64)                                                                                                     \
 	XX(DateTime)                                                                                                       \
 	XX_NET(Http)                                                                                                       \
+	XX_NET(HttpRouter)                                                                                                 \
 	XX_NET(Url)                                                                                                        \
+	XX_NET(Mqtt)                                                                                                       \
 	XX(ArduinoJson5)                                                                                                   \
 	XX(ArduinoJson6)                                                                                                   \
 	XX(Storage)                                                                                                        \
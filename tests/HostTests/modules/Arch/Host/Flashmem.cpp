@@ -0,0 +1,72 @@
+#include <HostTests.h>
+
+#include <spi_flash/flashmem.h>
+#include <esp_spi_flash.h>
+#include <IFS/Host/FileSystem.h>
+
+/*
+ * Check flash emulation using a separate, newly created backing file.
+ *
+ * The main backing file is restored before any checks are made.
+ */
+class FlashmemTest : public TestGroup
+{
+public:
+	FlashmemTest() : TestGroup(_F("Flash emulation"))
+	{
+	}
+
+	void execute() override
+	{
+		TEST_CASE("Fresh image with NOR enforcement")
+		{
+			auto savedConfig = host_flashmem_get_config();
+			String savedFilename = savedConfig.filename;
+			savedConfig.filename = savedFilename.c_str();
+
+			auto& fs = IFS::Host::getFileSystem();
+			String filename = savedFilename + _F(".nortest");
+			fs.remove(filename);
+
+			host_flashmem_cleanup();
+			FlashmemConfig config{filename.c_str(), 0x10000, false, true};
+			bool opened = host_flashmem_init(config);
+
+			constexpr uint32_t addr{0x1000};
+			uint8_t blank[16]{};
+			uint8_t data[16];
+			uint8_t written[16]{};
+			uint8_t overwritten[16]{};
+			for(unsigned i = 0; i < sizeof(data); ++i) {
+				data[i] = 0x5A + i;
+			}
+			if(opened) {
+				flashmem_read(blank, addr, sizeof(blank));
+				flashmem_write(data, addr, sizeof(data));
+				flashmem_read(written, addr, sizeof(written));
+				// Bits can't be set without erasing first
+				uint8_t ones[16];
+				memset(ones, 0xFF, sizeof(ones));
+				flashmem_write(ones, addr, sizeof(ones));
+				flashmem_read(overwritten, addr, sizeof(overwritten));
+			}
+
+			host_flashmem_cleanup();
+			fs.remove(filename);
+			bool restored = host_flashmem_init(savedConfig);
+
+			REQUIRE(restored);
+			REQUIRE(opened);
+			for(unsigned i = 0; i < sizeof(blank); ++i) {
+				REQUIRE_EQ(blank[i], uint8_t(0xFF));
+			}
+			REQUIRE(memcmp(written, data, sizeof(data)) == 0);
+			REQUIRE(memcmp(overwritten, data, sizeof(data)) == 0);
+		}
+	}
+};
+
+void REGISTER_TEST(Flashmem)
+{
+	registerGroup<FlashmemTest>();
+}
@@ -0,0 +1,247 @@
+#include <HostTests.h>
+
+#include <Ota/UpgradeOutputStream.h>
+#include <Storage.h>
+#include <malloc_count.h>
+
+namespace
+{
+/*
+ * Heatshrink-compatible encoder using greedy matching with hash chains
+ */
+class HeatshrinkEncoder
+{
+public:
+	HeatshrinkEncoder(uint8_t windowBits, uint8_t lookaheadBits)
+		: windowBits(windowBits), lookaheadBits(lookaheadBits)
+	{
+	}
+
+	String encode(const uint8_t* data, size_t size)
+	{
+		constexpr unsigned hashSize{0x10000};
+		constexpr unsigned maxChain{64};
+		std::unique_ptr<int32_t[]> head(new int32_t[hashSize]);
+		std::unique_ptr<int32_t[]> prev(new int32_t[size]);
+		std::fill_n(head.get(), hashSize, -1);
+
+		auto insert = [&](size_t pos) {
+			if(pos + 1 < size) {
+				auto h = data[pos] | (data[pos + 1] << 8);
+				prev[pos] = head[h];
+				head[h] = pos;
+			}
+		};
+
+		unsigned windowSize = 1U << windowBits;
+		unsigned maxLength = 1U << lookaheadBits;
+		output = "";
+		bitCount = 0;
+		size_t pos{0};
+		while(pos < size) {
+			unsigned bestLength{0};
+			unsigned bestOffset{0};
+			if(pos + 1 < size) {
+				auto h = data[pos] | (data[pos + 1] << 8);
+				unsigned chain{0};
+				for(int32_t cand = head[h]; cand >= 0 && pos - cand <= windowSize && chain < maxChain;
+					cand = prev[cand], ++chain) {
+					unsigned len{0};
+					while(len < maxLength && pos + len < size && data[cand + len] == data[pos + len]) {
+						++len;
+					}
+					if(len > bestLength) {
+						bestLength = len;
+						bestOffset = pos - cand;
+					}
+				}
+			}
+
+			if(bestLength * 9 > 1U + windowBits + lookaheadBits) {
+				putBits(0, 1);
+				putBits(bestOffset - 1, windowBits);
+				putBits(bestLength - 1, lookaheadBits);
+				for(unsigned i = 0; i < bestLength; ++i) {
+					insert(pos++);
+				}
+			} else {
+				putBits(1, 1);
+				putBits(data[pos], 8);
+				insert(pos++);
+			}
+		}
+
+		if(bitCount != 0) {
+			putBits(0, 8 - bitCount);
+		}
+		return output;
+	}
+
+private:
+	void putBits(unsigned value, uint8_t count)
+	{
+		while(count-- != 0) {
+			bitBuffer = (bitBuffer << 1) | ((value >> count) & 1);
+			if(++bitCount == 8) {
+				output += char(bitBuffer);
+				bitCount = 0;
+			}
+		}
+	}
+
+	String output;
+	uint8_t windowBits;
+	uint8_t lookaheadBits;
+	uint8_t bitBuffer{0};
+	uint8_t bitCount{0};
+};
+
+/*
+ * Generate content resembling a firmware image: repeated code sequences,
+ * text strings, zero padding and some incompressible data
+ */
+void createImage(uint8_t* image, size_t size)
+{
+	uint32_t seed{12345};
+	auto random = [&]() {
+		seed = seed * 1103515245 + 12345;
+		return seed >> 16;
+	};
+
+	size_t pos{0};
+	while(pos < size) {
+		size_t len;
+		switch(random() % 4) {
+		case 0:
+			len = std::min(size_t(16 + random() % 200), size - pos);
+			if(pos > len) {
+				memcpy(&image[pos], &image[random() % (pos - len)], len);
+				image[pos + random() % len] ^= 0x01;
+				break;
+			}
+			// fall-through
+		case 1: {
+			static const char text[] = "Sming Framework: HTTP/1.1 Content-Type Content-Length application/json ";
+			len = std::min(size_t(8 + random() % 40), size - pos);
+			for(unsigned i = 0; i < len; ++i) {
+				image[pos + i] = text[(random() % 8 + i) % (sizeof(text) - 1)];
+			}
+			break;
+		}
+		case 2:
+			len = std::min(size_t(8 + random() % 56), size - pos);
+			for(unsigned i = 0; i < len; ++i) {
+				image[pos + i] = random();
+			}
+			break;
+		default:
+			len = std::min(size_t(random() % 64), size - pos);
+			memset(&image[pos], 0, len);
+		}
+		pos += len;
+	}
+}
+
+} // namespace
+
+/*
+ * Stream compressed images through Ota::UpgradeOutputStream and verify flash content
+ */
+class OtaTest : public TestGroup
+{
+public:
+	OtaTest() : TestGroup(_F("OTA"))
+	{
+	}
+
+	void execute() override
+	{
+		part = *Storage::findPartition(Storage::Partition::Type::app);
+		CHECK(part);
+		Serial.print(_F("Using partition "));
+		Serial.println(part.name());
+
+		constexpr size_t imageSize{256 * 1024};
+		image.reset(new uint8_t[imageSize]);
+		createImage(image.get(), imageSize);
+
+		TEST_CASE("Uncompressed")
+		{
+			upgrade(String(reinterpret_cast<const char*>(image.get()), imageSize), imageSize,
+					Ota::UpgradeOutputStream::Compression::none);
+		}
+
+		TEST_CASE("Heatshrink")
+		{
+			HeatshrinkEncoder encoder(OTA_HEATSHRINK_WINDOW_BITS, OTA_HEATSHRINK_LOOKAHEAD_BITS);
+			auto data = encoder.encode(image.get(), imageSize);
+			Serial.print(_F("Compressed "));
+			Serial.print(imageSize);
+			Serial.print(_F(" bytes to "));
+			Serial.print(data.length());
+			Serial.print(_F(", "));
+			Serial.print(data.length() * 100 / imageSize);
+			Serial.println('%');
+			REQUIRE(data.length() < imageSize);
+			upgrade(data, imageSize, Ota::UpgradeOutputStream::Compression::heatshrink);
+
+			// Final item incomplete
+			Ota::UpgradeOutputStream stream(part, 0, Ota::UpgradeOutputStream::Compression::heatshrink);
+			auto len = data.length() - 1;
+			REQUIRE_EQ(stream.write(reinterpret_cast<const uint8_t*>(data.c_str()), len), len);
+			REQUIRE(!stream.close());
+		}
+
+		image.reset();
+	}
+
+	void upgrade(const String& data, size_t imageSize, Ota::UpgradeOutputStream::Compression compression)
+	{
+		// Erase the image area so results can't come from a previous run
+		REQUIRE(part.erase_range(0, (imageSize + 0xFFF) & ~0xFFF));
+
+		auto heapStart = MallocCount::getCurrent();
+		MallocCount::resetPeak();
+		ElapseTimer timer;
+		{
+			// Typical TCP segment size
+			constexpr size_t chunkSize{1460};
+			Ota::UpgradeOutputStream stream(part, 0, compression);
+			for(size_t pos = 0; pos < data.length(); pos += chunkSize) {
+				auto len = std::min(chunkSize, data.length() - pos);
+				REQUIRE_EQ(stream.write(reinterpret_cast<const uint8_t*>(data.c_str() + pos), len), len);
+			}
+			REQUIRE_EQ(stream.getInputLength(), data.length());
+			REQUIRE_EQ(size_t(stream.available()), imageSize);
+			REQUIRE(stream.close());
+		}
+		auto elapsed = timer.elapsedTime();
+		auto peakHeap = MallocCount::getPeak() - heapStart;
+
+		Serial.print(_F("  "));
+		Serial.print(data.length());
+		Serial.print(_F(" bytes received in "));
+		Serial.print(elapsed.toString());
+		Serial.print(_F(", "));
+		Serial.print(elapsed.time == 0 ? 0 : unsigned(uint64_t(data.length()) * 1000000U / elapsed.time));
+		Serial.print(_F(" bytes/sec, peak heap "));
+		Serial.println(peakHeap);
+
+		// Compare flash content
+		uint8_t buffer[1024];
+		for(size_t pos = 0; pos < imageSize; pos += sizeof(buffer)) {
+			auto len = std::min(sizeof(buffer), imageSize - pos);
+			REQUIRE(part.read(pos, buffer, len));
+			REQUIRE(memcmp(buffer, &image[pos], len) == 0);
+		}
+	}
+
+private:
+	Storage::Partition part;
+	std::unique_ptr<uint8_t[]> image;
+};
+
+void REGISTER_TEST(Ota)
+{
+	registerGroup<OtaTest>();
+}
@@ -55,6 +55,7 @@ public:
 			debug_i("Request from '%s' for '%s': %s", request.uri.Host.c_str(), path.c_str(), ok ? "OK" : "FAIL");
 		});
 
+		HttpClient::resetStats();
 		requestNextFile();
 		pending();
 	}
@@ -94,6 +95,17 @@ public:
 
 	void shutdown()
 	{
+		TEST_CASE("Connection pool statistics")
+		{
+			auto& stats = HttpClient::getStats();
+			Serial.printf(_F("Requests %u, connections %u, reuse ratio %.2f, max queue depth %u\r\n"), stats.requests,
+						  stats.connections, stats.reuseRatio(), stats.maxQueueDepth);
+			Serial.printf(_F("TTFB average %u ms, max %u ms\r\n"), stats.averageTtfb(), stats.ttfbMax);
+			REQUIRE(stats.requests == ARRAY_SIZE(testFiles));
+			REQUIRE(stats.responses == ARRAY_SIZE(testFiles));
+			REQUIRE(stats.connections == 1);
+		}
+
 		server->shutdown();
 		server = nullptr;
 		timer.initializeMs<1000>([this]() { complete(); });
@@ -0,0 +1,355 @@
+#include <HostTests.h>
+
+#include <Network/MqttClient.h>
+#include <Network/TcpServer.h>
+#include <Platform/Station.h>
+#include <Platform/Timers.h>
+#include <Timer.h>
+
+/*
+ * Compare MqttClient publishing throughput with and without batch mode,
+ * then check session behaviour when reconnecting with messages unacknowledged.
+ *
+ * A minimal broker replies to CONNECT, QoS 1 PUBLISH and PINGREQ, and counts incoming messages.
+ */
+class MqttLoopbackTest : public TestGroup
+{
+public:
+	MqttLoopbackTest() : TestGroup(_F("MQTT loopback"))
+	{
+	}
+
+	void execute() override
+	{
+		if(!WifiStation.isConnected()) {
+			Serial.println("No network, skipping tests");
+			return;
+		}
+
+		server = new TcpServer(
+			[this](TcpClient& client, char* data, int size) -> bool {
+				++segments;
+				buffer.concat(data, size);
+				return brokerReceive(client);
+			},
+			nullptr);
+		server->listen(port);
+		server->setTimeOut(USHRT_MAX);
+		server->setKeepAlive(USHRT_MAX);
+
+		startRun();
+		pending();
+	}
+
+	/*
+	 * Process complete packets in the receive buffer
+	 */
+	bool brokerReceive(TcpClient& client)
+	{
+		unsigned offset{0};
+		while(offset < buffer.length()) {
+			auto p = reinterpret_cast<const uint8_t*>(buffer.c_str()) + offset;
+			unsigned available = buffer.length() - offset;
+
+			// Fixed header: type/flags, then variable-length remaining length
+			unsigned length{0};
+			unsigned headerLength{1};
+			for(unsigned shift = 0;; shift += 7) {
+				if(headerLength >= available) {
+					available = 0;
+					break;
+				}
+				auto c = p[headerLength++];
+				length |= (c & 0x7f) << shift;
+				if((c & 0x80) == 0) {
+					break;
+				}
+			}
+			if(available < headerLength + length) {
+				break;
+			}
+
+			auto type = p[0] >> 4;
+			auto body = p + headerLength;
+			if(sessionStep != SessionStep::none) {
+				sessionReceive(client, p[0], body, length);
+			} else if(type == MQTT_TYPE_CONNECT) {
+				const uint8_t connack[]{MQTT_TYPE_CONNACK << 4, 2, 0, 0};
+				client.send(reinterpret_cast<const char*>(connack), sizeof(connack));
+			} else if(type == MQTT_TYPE_PUBLISH) {
+				auto qos = (p[0] >> 1) & 0x03;
+				if(qos != 0) {
+					unsigned topicLength = (body[0] << 8) | body[1];
+					auto id = body + 2 + topicLength;
+					const uint8_t puback[]{MQTT_TYPE_PUBACK << 4, 2, id[0], id[1]};
+					client.send(reinterpret_cast<const char*>(puback), sizeof(puback));
+				}
+				if(++received == messageCount) {
+					System.queueCallback([this]() { runComplete(); });
+				}
+			} else if(type == MQTT_TYPE_PINGREQ) {
+				const uint8_t pingresp[]{MQTT_TYPE_PINGRESP << 4, 0};
+				client.send(reinterpret_cast<const char*>(pingresp), sizeof(pingresp));
+			}
+			offset += headerLength + length;
+		}
+
+		buffer.remove(0, offset);
+		client.commit();
+		return true;
+	}
+
+	void startRun()
+	{
+		batchMode = (runIndex & 1) != 0;
+		qos = (runIndex < 2) ? MQTT_QOS_AT_MOST_ONCE : MQTT_QOS_AT_LEAST_ONCE;
+		Serial.print(batchMode ? _F("Batched") : _F("Unbatched"));
+		Serial.print(_F(" publish of "));
+		Serial.print(messageCount);
+		Serial.print(_F(" messages, QoS "));
+		Serial.println(int(qos));
+
+		received = 0;
+		segments = 0;
+		published = 0;
+		buffer.setLength(0);
+
+		client.reset(new MqttClient);
+		client->setBatchMode(batchMode);
+		Url url;
+		url.Scheme = URI_SCHEME_MQTT;
+		url.Host = WifiStation.getIP().toString();
+		url.Port = port;
+		client->connect(url, F("loopback"));
+		timer.start();
+		publishMore();
+	}
+
+	/*
+	 * Keep the client's request queue full until all messages have been published
+	 */
+	void publishMore()
+	{
+		while(published < messageCount) {
+			String message;
+			message += _F("Message #");
+			message += published;
+			if(!client->publish(F("test/loopback"), message, MqttClient::getFlags(qos))) {
+				System.queueCallback([this]() { publishMore(); });
+				return;
+			}
+			++published;
+		}
+	}
+
+	void runComplete()
+	{
+		auto elapsed = timer.elapsedTime();
+		auto& stats = client->getStats();
+		Serial.print(_F("  elapsed "));
+		Serial.print(elapsed.toString());
+		Serial.print(_F(", "));
+		Serial.print(elapsed.time == 0 ? 0 : unsigned(uint64_t(messageCount) * 1000000U / elapsed.time));
+		Serial.print(_F(" messages/sec, "));
+		Serial.print(stats.writes);
+		Serial.print(_F(" writes, "));
+		Serial.print(segments);
+		Serial.println(_F(" segments received"));
+
+		TEST_CASE("Loopback publish")
+		{
+			REQUIRE_EQ(received, messageCount);
+			REQUIRE(stats.published == messageCount);
+			if(batchMode) {
+				REQUIRE(stats.writes < lastWrites);
+			}
+		}
+		lastWrites = stats.writes;
+
+		client.reset();
+		if(++runIndex < 4) {
+			startRun();
+			return;
+		}
+
+		startSession();
+	}
+
+	void connect()
+	{
+		Url url;
+		url.Scheme = URI_SCHEME_MQTT;
+		url.Host = WifiStation.getIP().toString();
+		url.Port = port;
+		client->connect(url, F("loopback"));
+	}
+
+	/*
+	 * Messages m1 (QoS 1) and m2 (QoS 2) are not acknowledged before reconnecting, so must be re-sent
+	 * with DUP set and the same identifiers. The QoS 2 exchange is then completed.
+	 * m3 (QoS 1) is left unacknowledged and the client reconnects with a clean session, so it's discarded.
+	 */
+	void startSession()
+	{
+		Serial.println(_F("Session resend"));
+		buffer.setLength(0);
+		trace = "";
+		sessionStep = SessionStep::initial;
+		client.reset(new MqttClient);
+		connect();
+		client->publish(F("test/session"), F("m1"), MqttClient::getFlags(MQTT_QOS_AT_LEAST_ONCE));
+		client->publish(F("test/session"), F("m2"), MqttClient::getFlags(MQTT_QOS_EXACTLY_ONCE));
+	}
+
+	void sessionReceive(TcpClient& connection, uint8_t header, const uint8_t* body, unsigned length)
+	{
+		auto reply = [&](mqtt_type_t type, uint16_t id) {
+			const uint8_t packet[]{uint8_t(type << 4), 2, uint8_t(id >> 8), uint8_t(id)};
+			connection.send(reinterpret_cast<const char*>(packet), sizeof(packet));
+		};
+
+		switch(header >> 4) {
+		case MQTT_TYPE_CONNECT: {
+			unsigned nameLength = (body[0] << 8) | body[1];
+			bool clean = (body[2 + nameLength + 1] & 0x02) != 0;
+			trace += clean ? _F("CONNECT/clean ") : _F("CONNECT ");
+			const uint8_t connack[]{MQTT_TYPE_CONNACK << 4, 2, 0, 0};
+			connection.send(reinterpret_cast<const char*>(connack), sizeof(connack));
+			break;
+		}
+
+		case MQTT_TYPE_PUBLISH: {
+			unsigned qos = (header >> 1) & 0x03;
+			bool dup = (header & 0x08) != 0;
+			unsigned pos = 2 + ((body[0] << 8) | body[1]);
+			uint16_t id{0};
+			if(qos != 0) {
+				id = (body[pos] << 8) | body[pos + 1];
+				pos += 2;
+			}
+			String payload(reinterpret_cast<const char*>(body + pos), length - pos);
+			trace += payload;
+			trace += '/';
+			trace += qos;
+			if(dup) {
+				trace += _F("/dup");
+			}
+			trace += ' ';
+			onSessionPublish(payload, qos, dup, id, reply);
+			break;
+		}
+
+		case MQTT_TYPE_PUBREL: {
+			// Fixed header flags required by protocol
+			trace += ((header & 0x0f) == 0x02) ? _F("PUBREL ") : _F("PUBREL/badflags ");
+			uint16_t id = (body[0] << 8) | body[1];
+			reply(MQTT_TYPE_PUBCOMP, id);
+			// Wait for client to process PUBCOMP
+			pollTimer.initializeMs<10>([this]() {
+				if(client->getInflightCount() == 0) {
+					pollTimer.stop();
+					sessionStep = SessionStep::discard;
+					client->publish(F("test/session"), F("m3"), MqttClient::getFlags(MQTT_QOS_AT_LEAST_ONCE));
+				}
+			});
+			pollTimer.start();
+			break;
+		}
+
+		default:
+			break;
+		}
+	}
+
+	template <typename Reply>
+	void onSessionPublish(const String& payload, unsigned qos, bool dup, uint16_t id, Reply reply)
+	{
+		switch(sessionStep) {
+		case SessionStep::initial:
+			ids[payload == "m1" ? 0 : 1] = id;
+			if(payload == "m2") {
+				System.queueCallback([this]() {
+					sessionStep = SessionStep::resend;
+					connect();
+				});
+			}
+			break;
+
+		case SessionStep::resend:
+			if(id != ids[payload == "m1" ? 0 : 1]) {
+				trace += _F("badid ");
+			}
+			reply((qos == MQTT_QOS_AT_LEAST_ONCE) ? MQTT_TYPE_PUBACK : MQTT_TYPE_PUBREC, id);
+			break;
+
+		case SessionStep::discard:
+			System.queueCallback([this]() {
+				sessionStep = SessionStep::clean;
+				client->setCleanSession(true);
+				connect();
+				client->publish(F("test/session"), F("m4"));
+			});
+			break;
+
+		case SessionStep::clean:
+			System.queueCallback([this]() { sessionComplete(); });
+			break;
+
+		case SessionStep::none:
+			break;
+		}
+	}
+
+	void sessionComplete()
+	{
+		TEST_CASE("Session resend")
+		{
+			Serial.print(_F("  "));
+			Serial.println(trace);
+			REQUIRE_EQ(trace, F("CONNECT m1/1 m2/2 CONNECT m1/1/dup m2/2/dup PUBREL m3/1 CONNECT/clean m4/0 "));
+			auto& stats = client->getStats();
+			REQUIRE_EQ(stats.retransmitted, 2U);
+			REQUIRE_EQ(stats.acknowledged, 2U);
+			REQUIRE_EQ(stats.dropped, 1U);
+			REQUIRE_EQ(client->getInflightCount(), 0U);
+		}
+
+		sessionStep = SessionStep::none;
+		client.reset();
+		server->shutdown();
+		server = nullptr;
+		complete();
+	}
+
+private:
+	enum class SessionStep {
+		none,
+		initial, ///< Publish m1 and m2, no acknowledgement
+		resend,	 ///< Reconnected, acknowledge re-sent messages
+		discard, ///< Publish m3, no acknowledgement
+		clean,	 ///< Reconnected with clean session
+	};
+
+	static constexpr int port = 9879;
+	static constexpr unsigned messageCount = 1000;
+	std::unique_ptr<MqttClient> client;
+	TcpServer* server{nullptr};
+	String buffer;
+	ElapseTimer timer;
+	Timer pollTimer;
+	String trace;
+	uint16_t ids[2]{};
+	SessionStep sessionStep{SessionStep::none};
+	mqtt_qos_t qos{};
+	unsigned received{0};
+	unsigned segments{0};
+	unsigned published{0};
+	unsigned lastWrites{0};
+	unsigned runIndex{0};
+	bool batchMode{false};
+};
+
+void REGISTER_TEST(MqttLoopback)
+{
+	registerGroup<MqttLoopbackTest>();
+}
@@ -0,0 +1,144 @@
+#include <HostTests.h>
+
+#include <Network/TcpClient.h>
+#include <Network/TcpServer.h>
+#include <Data/Stream/SharedMemoryStream.h>
+#include <Platform/Station.h>
+#include <Platform/Timers.h>
+#include <malloc_count.h>
+#include <Timer.h>
+
+/*
+ * Compare throughput of TcpConnection::write(IDataSourceStream*) with and without zero-copy.
+ *
+ * A final run sends the data as two streams, the second being queued whilst content
+ * from the first is still referenced by the send queue.
+ */
+class TcpZeroCopyTest : public TestGroup
+{
+public:
+	TcpZeroCopyTest() : TestGroup(_F("TCP zero-copy"))
+	{
+	}
+
+	void execute() override
+	{
+		if(!WifiStation.isConnected()) {
+			Serial.println("No network, skipping tests");
+			return;
+		}
+
+		buffer.reset(new char[dataSize], std::default_delete<char[]>());
+		for(unsigned i = 0; i < dataSize; ++i) {
+			buffer.get()[i] = char(i);
+		}
+
+		server = new TcpServer(
+			[this](TcpClient& client, char* data, int size) -> bool {
+				for(int i = 0; i < size; ++i) {
+					if(data[i] != char(receivedBytes + i)) {
+						dataError = true;
+						break;
+					}
+				}
+				receivedBytes += size;
+				return true;
+			},
+			[this](TcpClient& client, bool successful) { System.queueCallback([this]() { runComplete(); }); });
+		server->listen(port);
+		server->setTimeOut(USHRT_MAX);
+		server->setKeepAlive(USHRT_MAX);
+
+		startRun();
+		pending();
+	}
+
+	void startRun()
+	{
+		bool zeroCopy = (runIndex != 0);
+		bool split = (runIndex == 2);
+		Serial.print(zeroCopy ? _F("Zero-copy") : _F("Copy"));
+		Serial.print(_F(" sending "));
+		Serial.print(dataSize);
+		Serial.println(split ? _F(" bytes in two streams") : _F(" bytes"));
+
+		receivedBytes = 0;
+		dataError = false;
+		MallocCount::resetPeak();
+		allocCount = MallocCount::getAllocCount();
+
+		secondSent = false;
+		client.reset(new TcpClient(false));
+		client->setZeroCopy(zeroCopy);
+		client->connect(WifiStation.getIP(), port);
+		timer.start();
+		if(!split) {
+			client->send(new SharedMemoryStream<char>(buffer, dataSize), true);
+			return;
+		}
+
+		constexpr size_t half{dataSize / 2};
+		client->send(new SharedMemoryStream<char>(buffer, half));
+		pollTimer.initializeMs<1>([this]() {
+			if(client && !secondSent && client->isZeroCopyPending()) {
+				std::shared_ptr<char> tail(buffer, buffer.get() + half);
+				client->send(new SharedMemoryStream<char>(tail, dataSize - half), true);
+				secondSent = true;
+				pollTimer.stop();
+			}
+		});
+		pollTimer.start();
+	}
+
+	void runComplete()
+	{
+		auto elapsed = timer.elapsedTime();
+		auto allocs = MallocCount::getAllocCount() - allocCount;
+		Serial.print(_F("  elapsed "));
+		Serial.print(elapsed.toString());
+		Serial.print(_F(", "));
+		Serial.print(elapsed.time == 0 ? 0 : receivedBytes / elapsed.time);
+		Serial.print(_F(" MB/s, "));
+		Serial.print(allocs);
+		Serial.print(_F(" allocations, peak heap "));
+		Serial.println(MallocCount::getPeak());
+
+		TEST_CASE("Content verify")
+		{
+			REQUIRE(receivedBytes == dataSize);
+			REQUIRE(!dataError);
+			if(runIndex == 2) {
+				REQUIRE(secondSent);
+			}
+		}
+
+		client.reset();
+		if(++runIndex < 3) {
+			startRun();
+			return;
+		}
+
+		server->shutdown();
+		server = nullptr;
+		complete();
+	}
+
+private:
+	static constexpr int port = 9877;
+	static constexpr size_t dataSize = 1024 * 1024;
+	std::shared_ptr<char> buffer;
+	std::unique_ptr<TcpClient> client;
+	TcpServer* server{nullptr};
+	ElapseTimer timer;
+	Timer pollTimer;
+	size_t receivedBytes{0};
+	size_t allocCount{0};
+	unsigned runIndex{0};
+	bool dataError{false};
+	bool secondSent{false};
+};
+
+void REGISTER_TEST(TcpZeroCopy)
+{
+	registerGroup<TcpZeroCopyTest>();
+}
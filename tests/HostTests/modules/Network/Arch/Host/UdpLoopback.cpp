@@ -0,0 +1,97 @@
+#include <HostTests.h>
+
+#include <Network/UdpConnection.h>
+#include <Platform/Station.h>
+
+/*
+ * Send datagrams to ourselves using scatter lists and receive them without copying
+ */
+class UdpLoopbackTest : public TestGroup
+{
+public:
+	UdpLoopbackTest() : TestGroup(_F("UDP loopback"))
+	{
+	}
+
+	void execute() override
+	{
+		if(!WifiStation.isConnected()) {
+			Serial.println("No network, skipping tests");
+			return;
+		}
+
+		receiver.setDatagramDelegate(
+			[this](UdpConnection&, const UdpDatagram& datagram, IpAddress, uint16_t) { receive(datagram); });
+		receiver.listen(port);
+
+		String header = F("HDR:");
+		String body = F("Content in a separate buffer");
+		const StreamSpan spans[]{
+			{header.c_str(), header.length()},
+			{body.c_str(), body.length()},
+		};
+		expected.add(header + body);
+
+		TEST_CASE("Scatter send")
+		{
+			REQUIRE(sender.sendTo(WifiStation.getIP(), port, spans, ARRAY_SIZE(spans)));
+		}
+
+		String messages[]{F("First"), F("Second"), F("Third")};
+		StreamSpan datagrams[ARRAY_SIZE(messages)];
+		for(unsigned i = 0; i < ARRAY_SIZE(messages); ++i) {
+			datagrams[i] = StreamSpan{messages[i].c_str(), messages[i].length()};
+			expected.add(messages[i]);
+		}
+
+		TEST_CASE("Batch send")
+		{
+			REQUIRE(sender.sendBatchTo(WifiStation.getIP(), port, datagrams, ARRAY_SIZE(datagrams)) ==
+					ARRAY_SIZE(datagrams));
+		}
+
+		pending();
+	}
+
+	void receive(const UdpDatagram& datagram)
+	{
+		Serial.print(_F("Received "));
+		Serial.print(datagram.length());
+		Serial.print(_F(" bytes, contiguous: "));
+		Serial.println(datagram.isContiguous());
+
+		TEST_CASE("Receive datagram")
+		{
+			REQUIRE(received < expected.count());
+			String s = datagram.toString();
+			REQUIRE_EQ(s, expected[received]);
+
+			// Compare scatter list with content
+			StreamSpan spans[8];
+			auto count = datagram.getSpans(spans, ARRAY_SIZE(spans));
+			size_t offset{0};
+			for(unsigned i = 0; i < count; ++i) {
+				REQUIRE(memcmp(spans[i].data, s.c_str() + offset, spans[i].length) == 0);
+				offset += spans[i].length;
+			}
+			REQUIRE_EQ(offset, s.length());
+			REQUIRE(datagram[0] == uint8_t(s[0]));
+		}
+
+		if(++received == expected.count()) {
+			System.queueCallback([this]() { complete(); });
+		}
+	}
+
+private:
+	static constexpr int port = 9880;
+	UdpConnection receiver;
+	UdpConnection sender;
+	Vector<String> expected;
+	unsigned received{0};
+};
+
+void REGISTER_TEST(UdpLoopback)
+{
+	registerGroup<UdpLoopbackTest>();
+}
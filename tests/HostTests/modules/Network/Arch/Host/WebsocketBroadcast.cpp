@@ -0,0 +1,183 @@
+#include <HostTests.h>
+
+#include <Network/HttpServer.h>
+#include <Network/WebsocketClient.h>
+#include <Network/Http/Websocket/WebsocketResource.h>
+#include <Platform/Station.h>
+#include <malloc_count.h>
+
+/*
+ * Broadcast to several clients, first without backpressure and then with a tiny coalescing queue.
+ */
+class WebsocketBroadcastTest : public TestGroup
+{
+public:
+	WebsocketBroadcastTest() : TestGroup(_F("Websocket broadcast"))
+	{
+	}
+
+	void execute() override
+	{
+		TEST_CASE("Frame header encoding")
+		{
+			uint8_t header[WEBSOCKET_MAX_HEADER_SIZE];
+			REQUIRE(WebsocketConnection::encodeFrameHeader(header, 5, WS_FRAME_TEXT) == 2U);
+			REQUIRE(header[0] == 0x81);
+			REQUIRE(header[1] == 5);
+
+			const uint8_t mask[]{1, 2, 3, 4};
+			REQUIRE(WebsocketConnection::encodeFrameHeader(header, 300, WS_FRAME_BINARY, mask, false) == 8U);
+			REQUIRE(header[0] == 0x02);
+			REQUIRE(header[1] == (0x80 | 126));
+			REQUIRE(header[2] == 0x01);
+			REQUIRE(header[3] == 0x2c);
+			REQUIRE(memcmp(&header[4], mask, 4) == 0);
+
+			REQUIRE(WebsocketConnection::encodeFrameHeader(header, 0x12345678, WS_FRAME_BINARY) == 10U);
+			REQUIRE(header[1] == 127);
+			const uint8_t len64[]{0, 0, 0, 0, 0x12, 0x34, 0x56, 0x78};
+			REQUIRE(memcmp(&header[2], len64, 8) == 0);
+		}
+
+		if(!WifiStation.isConnected()) {
+			Serial.println("No network, skipping tests");
+			return;
+		}
+
+		server = new HttpServer;
+		server->listen(port);
+		auto resource = new WebsocketResource;
+		resource->setConnectionHandler([this](WebsocketConnection& ws) {
+			serverConnections.add(&ws);
+			if(serverConnections.count() == clientCount) {
+				System.queueCallback([this]() { startRun(); });
+			}
+		});
+		resource->setDisconnectionHandler([this](WebsocketConnection& ws) { serverConnections.removeElement(&ws); });
+		server->paths.set("/ws", resource);
+
+		Url url;
+		url.Scheme = URI_SCHEME_WEBSOCKET;
+		url.Host = WifiStation.getIP().toString();
+		url.Port = port;
+		url.Path = "/ws";
+		for(unsigned i = 0; i < clientCount; ++i) {
+			auto& client = clients[i];
+			client.setMessageHandler([this, i](WebsocketConnection&, const String& message) {
+				onMessage(i, message);
+			});
+			client.connect(url);
+		}
+
+		pending();
+	}
+
+	void startRun()
+	{
+		bool coalesce = (runIndex != 0);
+		Serial.print(coalesce ? _F("Coalescing") : _F("Unlimited"));
+		Serial.print(_F(" broadcast of "));
+		Serial.print(messageCount);
+		Serial.print(_F(" messages to "));
+		Serial.print(clientCount);
+		Serial.println(_F(" clients"));
+
+		for(auto ws : serverConnections) {
+			if(coalesce) {
+				ws->setBroadcastLimit(1, WsBroadcastPolicy::Coalesce);
+			} else {
+				ws->setBroadcastLimit(0xffffffff);
+			}
+		}
+
+		for(auto& count : received) {
+			count = 0;
+		}
+		completed = 0;
+		WebsocketConnection::resetBroadcastStats();
+		auto allocCount = MallocCount::getAllocCount();
+
+		for(unsigned i = 0; i < messageCount; ++i) {
+			String msg;
+			msg += _F("Message #");
+			msg += i;
+			WebsocketConnection::broadcast(msg);
+		}
+
+		auto allocs = MallocCount::getAllocCount() - allocCount;
+		auto& stats = WebsocketConnection::getBroadcastStats();
+		Serial.print(_F("  "));
+		Serial.print(allocs);
+		Serial.print(_F(" allocations, frames "));
+		Serial.print(stats.frames);
+		Serial.print(_F(", queued "));
+		Serial.print(stats.queued);
+		Serial.print(_F(", coalesced "));
+		Serial.print(stats.coalesced);
+		Serial.print(_F(", dropped "));
+		Serial.println(stats.dropped);
+
+		TEST_CASE("Broadcast stats")
+		{
+			// Client connections are also in the active list but send individually masked frames, so are not counted
+			REQUIRE_EQ(stats.frames, messageCount);
+			REQUIRE_EQ(stats.queued + stats.coalesced + stats.dropped, messageCount * clientCount);
+			REQUIRE(stats.disconnected == 0);
+			if(coalesce) {
+				REQUIRE(stats.coalesced != 0);
+			} else {
+				REQUIRE_EQ(stats.queued, messageCount * clientCount);
+			}
+		}
+	}
+
+	void onMessage(unsigned clientIndex, const String& message)
+	{
+		++received[clientIndex];
+		String last;
+		last += _F("Message #");
+		last += messageCount - 1;
+		if(message != last) {
+			return;
+		}
+
+		if(runIndex == 0) {
+			REQUIRE_EQ(received[clientIndex], messageCount);
+		} else {
+			REQUIRE(received[clientIndex] <= messageCount);
+		}
+
+		if(++completed < clientCount) {
+			return;
+		}
+
+		System.queueCallback([this]() {
+			if(++runIndex < 2) {
+				startRun();
+				return;
+			}
+			for(auto& client : clients) {
+				client.close();
+			}
+			server->shutdown();
+			server = nullptr;
+			complete();
+		});
+	}
+
+private:
+	static constexpr int port = 9878;
+	static constexpr unsigned clientCount = 3;
+	static constexpr unsigned messageCount = 50;
+	HttpServer* server{nullptr};
+	WebsocketClient clients[clientCount];
+	Vector<WebsocketConnection*> serverConnections;
+	unsigned received[clientCount]{};
+	unsigned completed{0};
+	unsigned runIndex{0};
+};
+
+void REGISTER_TEST(WebsocketBroadcast)
+{
+	registerGroup<WebsocketBroadcastTest>();
+}
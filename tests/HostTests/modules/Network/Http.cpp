@@ -2,8 +2,15 @@
 
 #include "Network/Http/HttpCommon.h"
 #include "Network/Http/HttpHeaders.h"
+#include "Network/Http/HttpHeaderBuilder.h"
+#include "Network/Http/HttpBodyParser.h"
+#include "Network/Http/HttpRange.h"
+#include "Data/Stream/MultipartRangeStream.h"
+#include <Data/Stream/RangeStream.h>
+#include <Data/Stream/MemoryDataStream.h>
 #include <Data/WebConstants.h>
 #include <Platform/Timers.h>
+#include <malloc_count.h>
 
 class HttpTest : public TestGroup
 {
@@ -17,6 +24,9 @@ public:
 		testHttpCommon();
 		testHttpHeaders();
 		profileHttpHeaders();
+		testHeaderArena();
+		testFormFields();
+		testRanges();
 	}
 
 	void testHttpCommon()
@@ -214,6 +224,369 @@ public:
 			// But fail on actual append
 			REQUIRE(headers2.append(HTTP_HEADER_CONTENT_LENGTH, "1234") == false);
 		}
+
+		TEST_CASE("Standard field lookup")
+		{
+			for(unsigned i = 1; i < unsigned(HTTP_HEADER_CUSTOM); ++i) {
+				auto field = HttpHeaderFieldName(i);
+				String name = headers.toString(field);
+				REQUIRE(HttpHeaderFields::findStandardField(name) == field);
+				name.toUpperCase();
+				REQUIRE(HttpHeaderFields::findStandardField(name) == field);
+			}
+			REQUIRE(HttpHeaderFields::findStandardField("Content-Lengthx") == HTTP_HEADER_UNKNOWN);
+			REQUIRE(HttpHeaderFields::findStandardField("") == HTTP_HEADER_UNKNOWN);
+		}
+
+		TEST_CASE("Many fields")
+		{
+			auto fieldName = [](unsigned i) { return F("X-Field-") + String(i); };
+			HttpHeaders headers2;
+			for(unsigned i = 0; i < 50; ++i) {
+				headers2[fieldName(i)] = String(i);
+			}
+			headers2[HTTP_HEADER_CONTENT_LENGTH] = "0";
+			REQUIRE_EQ(headers2.count(), 51U);
+			for(unsigned i = 0; i < 50; i += 2) {
+				headers2.remove(fieldName(i));
+			}
+			REQUIRE_EQ(headers2.count(), 26U);
+			for(unsigned i = 0; i < 50; ++i) {
+				auto name = fieldName(i);
+				REQUIRE_EQ(headers2.contains(name), (i % 2) != 0);
+				if(i % 2) {
+					REQUIRE_EQ(headers2[name], String(i));
+				}
+			}
+			REQUIRE_EQ(headers2[HTTP_HEADER_CONTENT_LENGTH], "0");
+		}
+	}
+
+	/*
+	 * Feed a typical set of request headers through the builder, as the HTTP parser would.
+	 * Some are split across calls.
+	 */
+	static void parseHeaders(HttpHeaderBuilder& builder, HttpHeaders& headers)
+	{
+		static const char* const fields[][2]{
+			{"Host", "192.168.1.100"},
+			{"User-Agent", "Mozilla/5.0 (X11; Linux x86_64; rv:109.0) Gecko/20100101 Firefox/115.0"},
+			{"Accept", "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8"},
+			{"Accept-Language", "en-GB,en;q=0.5"},
+			{"Accept-Encoding", "gzip, deflate"},
+			{"Connection", "keep-alive"},
+			{"X-Requested-With", "XMLHttpRequest"},
+			{"Cache-Control", "max-age=0"},
+		};
+
+		builder.reset();
+		for(auto& field : fields) {
+			auto name = field[0];
+			auto value = field[1];
+			auto nameLen = strlen(name);
+			auto valueLen = strlen(value);
+			builder.onHeaderField(name, nameLen / 2);
+			builder.onHeaderField(name + nameLen / 2, nameLen - nameLen / 2);
+			builder.onHeaderValue(headers, value, valueLen / 2);
+			builder.onHeaderValue(headers, value + valueLen / 2, valueLen - valueLen / 2);
+		}
+	}
+
+	void testHeaderArena()
+	{
+		HttpHeaderBuilder builder;
+
+		TEST_CASE("Arena header values")
+		{
+			HttpHeaders headers;
+			headers.enableArena(128);
+			parseHeaders(builder, headers);
+			REQUIRE_EQ(headers.count(), 8U);
+			REQUIRE(headers.getArena()->used() != 0);
+			REQUIRE_EQ(headers[HTTP_HEADER_HOST], "192.168.1.100");
+			REQUIRE_EQ(headers["x-requested-with"], "XMLHttpRequest");
+			REQUIRE_EQ(headers[HTTP_HEADER_CONNECTION], "keep-alive");
+			REQUIRE(headers.getArena()->getOverflowCount() != 0);
+
+			HttpHeaders copy(headers);
+			REQUIRE_EQ(copy[HTTP_HEADER_USER_AGENT], headers[HTTP_HEADER_USER_AGENT]);
+
+			headers.remove(HTTP_HEADER_ACCEPT);
+			REQUIRE_EQ(headers[HTTP_HEADER_CACHE_CONTROL], "max-age=0");
+
+			headers.clear();
+			REQUIRE_EQ(headers.getArena()->used(), 0U);
+			REQUIRE(headers.getArena()->getBlockSize() > 128U);
+		}
+
+		TEST_CASE("Request header allocations")
+		{
+			constexpr unsigned requestCount{100};
+
+			// Previous server behaviour: each value in a String, then copied into the request
+			HttpHeaders incoming;
+			HttpHeaders request;
+			auto count = MallocCount::getAllocCount();
+			for(unsigned i = 0; i < requestCount; ++i) {
+				parseHeaders(builder, incoming);
+				request.setMultiple(incoming);
+				incoming.clear();
+				REQUIRE(request[HTTP_HEADER_CONNECTION] == "keep-alive");
+				request.clear();
+			}
+			auto stringAllocs = MallocCount::getAllocCount() - count;
+
+			// Parse directly into arena-backed request headers
+			request.enableArena(HTTP_REQUEST_ARENA_SIZE);
+			count = MallocCount::getAllocCount();
+			for(unsigned i = 0; i < requestCount; ++i) {
+				parseHeaders(builder, request);
+				REQUIRE(request[HTTP_HEADER_CONNECTION] == "keep-alive");
+				request.clear();
+			}
+			auto arenaAllocs = MallocCount::getAllocCount() - count;
+
+			Serial.print(_F("  Allocations per request: String "));
+			Serial.print(float(stringAllocs) / requestCount);
+			Serial.print(_F(", arena "));
+			Serial.println(float(arenaAllocs) / requestCount);
+
+			REQUIRE(arenaAllocs < stringAllocs);
+
+			// Arena is now large enough, so only the custom field name requires an allocation
+			count = MallocCount::getAllocCount();
+			parseHeaders(builder, request);
+			REQUIRE(request[HTTP_HEADER_CONNECTION] == "keep-alive");
+			REQUIRE_EQ(MallocCount::getAllocCount() - count, 1U);
+		}
+	}
+
+	/*
+	 * Pass content to parser in fragments, returning false if any are rejected
+	 */
+	static bool parseForm(HttpRequest& request, const char* const fragments[], unsigned count)
+	{
+		bool ok{true};
+		formUrlParser(request, nullptr, PARSE_DATASTART);
+		for(unsigned i = 0; i < count; ++i) {
+			auto len = strlen(fragments[i]);
+			if(formUrlParser(request, fragments[i], len) != len) {
+				ok = false;
+			}
+		}
+		if(formUrlParser(request, nullptr, PARSE_DATAEND) != 0) {
+			ok = false;
+		}
+		return ok;
+	}
+
+	void testFormFields()
+	{
+		// Split escape sequences, names and values across fragments
+		const char* const fragments[]{
+			"na%6De=Jo", "hn+Sm", "ith%2", "0Jr&com", "ment=a%2", "5b%", "3d%zz&flag&nothing=a+b", "c&email=x%40y",
+		};
+
+		TEST_CASE("Form parser (legacy)")
+		{
+			HttpRequest request;
+			REQUIRE(parseForm(request, fragments, ARRAY_SIZE(fragments)));
+			REQUIRE_EQ(request.postParams["name"], "John Smith Jr");
+			REQUIRE_EQ(request.postParams["comment"], "a%b=%zz");
+			REQUIRE_EQ(request.postParams["email"], "x@y");
+		}
+
+		TEST_CASE("Form parser (streaming)")
+		{
+			String log;
+			String comment;
+			auto callback = [&](HttpRequest&, const String& name, HttpFormFieldEvent event, const char* data,
+								size_t length) -> bool {
+				switch(event) {
+				case HttpFormFieldEvent::Start:
+					log += '<';
+					log += name;
+					log += '>';
+					break;
+				case HttpFormFieldEvent::Data:
+					if(name == "comment") {
+						comment.concat(data, length);
+					}
+					log += length;
+					break;
+				case HttpFormFieldEvent::End:
+					log += '.';
+					break;
+				}
+				return true;
+			};
+
+			HttpFormFields fields;
+			fields.onField("comment", callback);
+			fields.onField("flag", callback);
+			fields.bufferField("name", 16);
+			fields.bufferField("email", 16);
+
+			HttpRequest request;
+			request.formFields = &fields;
+			REQUIRE(parseForm(request, fragments, ARRAY_SIZE(fragments)));
+			REQUIRE_EQ(comment, "a%b=%zz");
+			// Fragments as received, less any incomplete escape sequences
+			REQUIRE_EQ(log, "<comment>124.<flag>.");
+			REQUIRE_EQ(request.postParams["name"], "John Smith Jr");
+			REQUIRE_EQ(request.postParams["email"], "x@y");
+			// Unhandled fields are discarded
+			REQUIRE(!request.postParams.contains("nothing"));
+
+			// Other fields
+			log = "";
+			fields.onOtherField(callback);
+			request.postParams.clear();
+			REQUIRE(parseForm(request, fragments, ARRAY_SIZE(fragments)));
+			REQUIRE_EQ(log, "<comment>124.<flag>.<nothing>31.");
+
+			// Exceed buffer limit
+			fields.bufferField("name", 8);
+			request.postParams.clear();
+			REQUIRE(!parseForm(request, fragments, ARRAY_SIZE(fragments)));
+			REQUIRE(!request.postParams.contains("email"));
+		}
+
+		TEST_CASE("Form parser final field errors")
+		{
+			HttpFormFields fields;
+			fields.bufferField("email", 3);
+			auto rejectEnd = [](HttpRequest&, const String&, HttpFormFieldEvent event, const char*, size_t) -> bool {
+				return event != HttpFormFieldEvent::End;
+			};
+			fields.onField("last", rejectEnd);
+
+			HttpRequest request;
+			request.formFields = &fields;
+			const char* const fits[]{"email=ab"};
+			REQUIRE(parseForm(request, fits, ARRAY_SIZE(fits)));
+			REQUIRE_EQ(request.postParams["email"], "ab");
+
+			// Incomplete escape sequence is flushed at the end, and exceeds the limit
+			const char* const overflow[]{"email=ab%4"};
+			REQUIRE(!parseForm(request, overflow, ARRAY_SIZE(overflow)));
+
+			// Callback rejects the end of the field
+			const char* const rejected[]{"email=a&last=1"};
+			REQUIRE(!parseForm(request, rejected, ARRAY_SIZE(rejected)));
+		}
+	}
+
+	static String readStream(IDataSourceStream& stream)
+	{
+		String s;
+		char buffer[16];
+		while(!stream.isFinished()) {
+			auto count = stream.readMemoryBlock(buffer, sizeof(buffer));
+			if(count == 0) {
+				break;
+			}
+			s.concat(buffer, count);
+			stream.seek(count);
+		}
+		return s;
+	}
+
+	void testRanges()
+	{
+		using Result = HttpRangeList::Result;
+		HttpRangeList ranges;
+
+		auto check = [&](const char* value, Result expected, const String& list) {
+			auto result = ranges.parse(value, 1000);
+			String s;
+			for(unsigned i = 0; i < ranges.count(); ++i) {
+				if(i != 0) {
+					s += ',';
+				}
+				s += ranges[i].start;
+				s += '+';
+				s += ranges[i].length;
+			}
+			debug_d("Range \"%s\": %u \"%s\"", value, unsigned(result), s.c_str());
+			REQUIRE(result == expected);
+			REQUIRE_EQ(s, list);
+		};
+
+		TEST_CASE("Parse Range header")
+		{
+			check("bytes=0-499", Result::ok, "0+500");
+			check("bytes=500-999", Result::ok, "500+500");
+			check("bytes=-100", Result::ok, "900+100");
+			check("bytes=900-", Result::ok, "900+100");
+			check("bytes=0-0, -1", Result::ok, "0+1,999+1");
+			check("Bytes=0-99,200-299 , 500-5000", Result::ok, "0+100,200+100,500+500");
+			check("bytes=-2000", Result::ok, "0+1000");
+			check("bytes=1000-", Result::unsatisfiable, "");
+			check("bytes=1000-1999,-0", Result::unsatisfiable, "");
+			check("bytes=1000-2000,0-9", Result::ok, "0+10");
+			check("bytes=500-400", Result::ignore, "");
+			check("bytes=abc", Result::ignore, "");
+			check("bytes=", Result::ignore, "");
+			check("items=0-1", Result::ignore, "");
+			check("bytes=0-999,0-999", Result::ignore, "");
+			check("bytes=0-0,1-1,2-2,3-3,4-4,5-5,6-6,7-7,8-8", Result::ignore, "");
+		}
+
+		TEST_CASE("Content-Range")
+		{
+			REQUIRE(ranges.parse("bytes=10-19", 1000) == Result::ok);
+			REQUIRE_EQ(HttpRangeList::getContentRange(ranges[0], 1000), "bytes 10-19/1000");
+			REQUIRE_EQ(HttpRangeList::getUnsatisfiedRange(1000), "bytes */1000");
+		}
+
+		String content;
+		for(unsigned i = 0; i < 100; ++i) {
+			content += char('A' + i % 26);
+		}
+
+		auto source = [&]() {
+			auto stream = new MemoryDataStream;
+			stream->print(content);
+			return stream;
+		};
+
+		TEST_CASE("RangeStream")
+		{
+			RangeStream stream(source(), 30, 40);
+			REQUIRE(stream.available() == 40);
+			REQUIRE_EQ(readStream(stream), content.substring(30, 70));
+			REQUIRE(stream.available() == 0);
+
+			REQUIRE(stream.seekFrom(-10, SeekOrigin::End) == 30);
+			REQUIRE_EQ(readStream(stream), content.substring(60, 70));
+			REQUIRE(stream.seekFrom(41, SeekOrigin::Start) < 0);
+		}
+
+		TEST_CASE("MultipartRangeStream")
+		{
+			REQUIRE(ranges.parse("bytes=0-9,-5", content.length()) == Result::ok);
+			MultipartRangeStream stream(source(), 0, ranges, content.length(), "text/plain");
+			int length = stream.available();
+			String s = readStream(stream);
+			REQUIRE(length == int(s.length()));
+
+			String expected;
+			auto addPart = [&](const char* contentRange, const String& data) {
+				expected += "\r\n--";
+				expected += stream.getBoundary();
+				expected += "\r\nContent-Type: text/plain\r\nContent-Range: ";
+				expected += contentRange;
+				expected += "\r\n\r\n";
+				expected += data;
+			};
+			addPart("bytes 0-9/100", content.substring(0, 10));
+			addPart("bytes 95-99/100", content.substring(95));
+			expected += "\r\n--";
+			expected += stream.getBoundary();
+			expected += "--\r\n";
+			REQUIRE_EQ(s, expected);
+		}
 	}
 };
 
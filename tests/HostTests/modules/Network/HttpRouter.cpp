@@ -0,0 +1,134 @@
+#include <HostTests.h>
+
+#include <Network/Http/HttpResourceTree.h>
+#include <Platform/Timers.h>
+
+class HttpRouterTest : public TestGroup
+{
+public:
+	HttpRouterTest() : TestGroup(_F("HTTP Router"))
+	{
+	}
+
+	void execute() override
+	{
+		TEST_CASE("Route matching")
+		{
+			HttpResourceTree tree;
+			auto resDefault = tree.setDefault(HttpResourceDelegate{});
+			auto resRoot = tree.set("/", HttpResourceDelegate{});
+			auto resStatus = tree.set("/api/status", HttpResourceDelegate{});
+			auto resStats = tree.set("/api/stats", HttpResourceDelegate{});
+			auto resDevice = tree.set("/api/device/{id}", HttpResourceDelegate{});
+			auto resDeviceState = tree.set("/api/device/{id}/state", HttpResourceDelegate{});
+			auto resDeviceList = tree.set("/api/device/list", HttpResourceDelegate{});
+			auto resPair = tree.set("/pair/{a}/{b}", HttpResourceDelegate{});
+			auto resStatic = tree.set("/static/*", HttpResourceDelegate{});
+
+			HttpParams params;
+			REQUIRE(tree.match("/") == resRoot);
+			REQUIRE(tree.match("/api/status") == resStatus);
+			REQUIRE(tree.match("/api/stats") == resStats);
+			REQUIRE(tree.match("/api/stat") == resDefault);
+			REQUIRE(tree.match("/api/device/list") == resDeviceList);
+			REQUIRE(tree.match("/api/device/12", &params) == resDevice);
+			REQUIRE_EQ(params["id"], "12");
+			params.clear();
+			REQUIRE(tree.match("/api/device/list/state", &params) == resDeviceState);
+			REQUIRE_EQ(params["id"], "list");
+			params.clear();
+			REQUIRE(tree.match("/pair/left/right", &params) == resPair);
+			REQUIRE_EQ(params["a"], "left");
+			REQUIRE_EQ(params["b"], "right");
+			REQUIRE(tree.match("/pair/left") == resDefault);
+			REQUIRE(tree.match("/static/") == resStatic);
+			REQUIRE(tree.match("/static/css/main.css") == resStatic);
+			REQUIRE(tree.match("/nothing") == resDefault);
+
+			// Router must be rebuilt after modification
+			auto resNothing = tree.set("/nothing", HttpResourceDelegate{});
+			REQUIRE(tree.match("/nothing") == resNothing);
+			tree.remove("/nothing");
+			REQUIRE(tree.match("/nothing") == resDefault);
+
+			// Replace an entry without changing the count
+			tree.removeAt(tree.indexOf("/api/stats"));
+			auto resNew = new HttpResource;
+			tree["/api/new"] = resNew;
+			REQUIRE(tree.match("/api/new") == resNew);
+			REQUIRE(tree.match("/api/stats") == resDefault);
+			REQUIRE(tree.match("/api/status") == resStatus);
+			REQUIRE(tree.match("/static/main.css") == resStatic);
+
+			// Changes made via the base class must also be detected
+			HttpResourceTree::ObjectMap& map = tree;
+			map.remove("/api/new");
+			REQUIRE(tree.match("/api/new") == resDefault);
+			map["/api/new"] = new HttpResource;
+			REQUIRE(tree.match("/api/new") == tree.find("/api/new"));
+
+			tree.remove(RESOURCE_PATH_DEFAULT);
+			REQUIRE(tree.match("/nothing") == nullptr);
+		}
+
+		benchmark(10);
+		benchmark(100);
+#ifdef ARCH_HOST
+		benchmark(1000);
+#endif
+	}
+
+	void benchmark(unsigned routeCount)
+	{
+		TEST_CASE("Benchmark")
+		{
+			HttpResourceTree tree;
+			Vector<String> paths;
+			for(unsigned i = 0; i < routeCount; ++i) {
+				String path;
+				path += "/api/group";
+				path += i / 10;
+				path += "/item";
+				path += i;
+				tree.set(path, HttpResourceDelegate{});
+				paths.add(path);
+			}
+
+			const unsigned iterations = 100000 / routeCount;
+			unsigned matched{0};
+
+			ElapseTimer timer;
+			for(unsigned n = 0; n < iterations; ++n) {
+				for(auto& path : paths) {
+					matched += (tree.find(path) != nullptr);
+				}
+			}
+			auto findTime = timer.elapsedTime();
+
+			timer.start();
+			for(unsigned n = 0; n < iterations; ++n) {
+				for(auto& path : paths) {
+					matched += (tree.match(path) != nullptr);
+				}
+			}
+			auto matchTime = timer.elapsedTime();
+
+			REQUIRE_EQ(matched, 2 * iterations * routeCount);
+
+			auto lookups = iterations * routeCount;
+			Serial.print(_F("  "));
+			Serial.print(routeCount);
+			Serial.print(_F(" routes, "));
+			Serial.print(lookups);
+			Serial.print(_F(" lookups: ObjectMap::find "));
+			Serial.print(findTime.toString());
+			Serial.print(_F(", HttpResourceTree::match "));
+			Serial.println(matchTime.toString());
+		}
+	}
+};
+
+void REGISTER_TEST(HttpRouter)
+{
+	registerGroup<HttpRouterTest>();
+}
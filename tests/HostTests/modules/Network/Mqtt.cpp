@@ -0,0 +1,209 @@
+#include <HostTests.h>
+
+#include <Network/Mqtt/MqttInflightWindow.h>
+#include <Network/MqttClient.h>
+#include <malloc_count.h>
+
+class MqttTest : public TestGroup
+{
+public:
+	MqttTest() : TestGroup(_F("MQTT"))
+	{
+	}
+
+	void execute() override
+	{
+		testInflightWindow();
+		testTopicTrie();
+	}
+
+	static mqtt_message_t* createPublish(mqtt_qos_t qos)
+	{
+		auto message = new mqtt_message_t;
+		mqtt_message_init(message);
+		message->common.type = MQTT_TYPE_PUBLISH;
+		message->common.qos = qos;
+		return message;
+	}
+
+	void testInflightWindow()
+	{
+		using State = MqttInflightWindow::State;
+
+		MqttInflightWindow window;
+		window.setLimit(4);
+
+		TEST_CASE("Inflight window allocation")
+		{
+			for(unsigned i = 1; i <= 4; ++i) {
+				auto entry = window.add(createPublish(MQTT_QOS_AT_LEAST_ONCE), i);
+				REQUIRE(entry != nullptr);
+				REQUIRE(entry->id == i);
+				REQUIRE(entry->message->publish.message_id == i);
+			}
+			REQUIRE(window.full());
+			auto message = createPublish(MQTT_QOS_AT_LEAST_ONCE);
+			REQUIRE(window.add(message, 0) == nullptr);
+
+			REQUIRE(window.find(99) == nullptr);
+			auto entry = window.find(2);
+			REQUIRE(entry != nullptr);
+			window.remove(*entry);
+			REQUIRE(window.find(2) == nullptr);
+			REQUIRE(!window.full());
+
+			entry = window.add(message, 5);
+			REQUIRE(entry != nullptr);
+			REQUIRE(entry->id == 5);
+		}
+
+		TEST_CASE("Inflight window QoS 2 and resend")
+		{
+			// PUBREC received: message released, PUBREL pending
+			auto entry = window.find(1);
+			REQUIRE(entry != nullptr);
+			window.release(*entry);
+			REQUIRE(entry->state == State::AwaitingComp);
+			REQUIRE(entry->message == nullptr);
+			REQUIRE(window.nextPending() == entry);
+			REQUIRE(window.nextPending() == nullptr);
+
+			// Failed to send PUBREL, so try again
+			window.setPending(*entry);
+			REQUIRE(window.nextPending() == entry);
+			REQUIRE(window.nextPending() == nullptr);
+
+			// Simulate message sent from a stream, which cannot be re-sent
+			entry = window.find(4);
+			mqtt_message_clear(entry->message, 0);
+			delete entry->message;
+			entry->message = nullptr;
+
+			// Reconnect: everything re-sent in original order
+			REQUIRE(window.resendAll() == 1U);
+			REQUIRE(window.count() == 3U);
+			const uint16_t expected[]{1, 3, 5};
+			for(auto id : expected) {
+				entry = window.nextPending();
+				REQUIRE(entry != nullptr);
+				REQUIRE(entry->id == id);
+			}
+			REQUIRE(window.nextPending() == nullptr);
+
+			window.clear();
+			REQUIRE(window.count() == 0U);
+		}
+
+		TEST_CASE("Inflight window identifier wrap")
+		{
+			// Keep one slow message outstanding whilst many others complete
+			auto slow = window.add(createPublish(MQTT_QOS_EXACTLY_ONCE), 0);
+			REQUIRE(slow != nullptr);
+			auto slowId = slow->id;
+			bool ok{true};
+			for(unsigned i = 0; i < 70000; ++i) {
+				auto entry = window.add(createPublish(MQTT_QOS_AT_LEAST_ONCE), 0);
+				if(entry == nullptr || entry->id == 0 || entry->id == slowId || window.find(entry->id) != entry) {
+					ok = false;
+					break;
+				}
+				window.remove(*entry);
+			}
+			REQUIRE(ok);
+			REQUIRE(window.find(slowId) == slow);
+		}
+	}
+
+	void testTopicTrie()
+	{
+		MqttTopicTrie trie;
+		String matched;
+
+		auto addFilter = [&](const String& filter) {
+			return trie.add(filter, [&matched, filter](MqttClient&, mqtt_message_t*) -> int {
+				matched += '[';
+				matched += filter;
+				matched += ']';
+				return 0;
+			});
+		};
+
+		MqttClient client;
+		mqtt_message_t message;
+		mqtt_message_init(&message);
+		message.common.type = MQTT_TYPE_PUBLISH;
+
+		auto match = [&](const char* topic) -> String {
+			message.publish.topic_name.data = reinterpret_cast<uint8_t*>(const_cast<char*>(topic));
+			message.publish.topic_name.length = strlen(topic);
+			matched = "";
+			int result;
+			trie.dispatch(client, &message, result);
+			return matched;
+		};
+
+		TEST_CASE("Topic filter validation")
+		{
+			REQUIRE(MqttTopicTrie::isValidFilter("a/b/c"));
+			REQUIRE(MqttTopicTrie::isValidFilter("+/b/#"));
+			REQUIRE(MqttTopicTrie::isValidFilter("#"));
+			REQUIRE(!MqttTopicTrie::isValidFilter(""));
+			REQUIRE(!MqttTopicTrie::isValidFilter("a/b#"));
+			REQUIRE(!MqttTopicTrie::isValidFilter("a/#/c"));
+			REQUIRE(!MqttTopicTrie::isValidFilter("a+/b"));
+			REQUIRE(!addFilter("a/#/c"));
+		}
+
+		TEST_CASE("Topic matching")
+		{
+			REQUIRE(addFilter("sensor/kitchen/temp"));
+			REQUIRE(addFilter("sensor/+/temp"));
+			REQUIRE(addFilter("sensor/#"));
+			REQUIRE(addFilter("+/+"));
+			REQUIRE(addFilter("#"));
+			REQUIRE(addFilter("$SYS/#"));
+
+			REQUIRE_EQ(match("sensor/kitchen/temp"), "[#][sensor/#][sensor/kitchen/temp][sensor/+/temp]");
+			REQUIRE_EQ(match("sensor/hall/temp"), "[#][sensor/#][sensor/+/temp]");
+			REQUIRE_EQ(match("sensor"), "[#][sensor/#]");
+			REQUIRE_EQ(match("sensor/hall"), "[#][sensor/#][+/+]");
+			REQUIRE_EQ(match("other/topic/here"), "[#]");
+			REQUIRE_EQ(match("$SYS/uptime"), "[$SYS/#]");
+
+			// Matching must not allocate
+			matched.reserve(256);
+			auto allocCount = MallocCount::getAllocCount();
+			unsigned count{0};
+			for(unsigned i = 0; i < 100; ++i) {
+				matched.setLength(0);
+				int result;
+				count += trie.dispatch(client, &message, result);
+			}
+			REQUIRE_EQ(count, 100U);
+			REQUIRE_EQ(MallocCount::getAllocCount(), allocCount);
+		}
+
+		TEST_CASE("Topic filter removal")
+		{
+			REQUIRE(trie.remove("sensor/+/temp"));
+			REQUIRE(!trie.remove("sensor/+/temp"));
+			REQUIRE(!trie.remove("sensor/kitchen"));
+			REQUIRE(trie.remove("#"));
+			REQUIRE_EQ(match("sensor/kitchen/temp"), "[sensor/#][sensor/kitchen/temp]");
+			REQUIRE(trie.remove("sensor/#"));
+			REQUIRE(trie.remove("sensor/kitchen/temp"));
+			REQUIRE(trie.remove("+/+"));
+			REQUIRE(trie.remove("$SYS/#"));
+			REQUIRE(trie.isEmpty());
+		}
+
+		// Topic data isn't owned by the message
+		message.publish.topic_name.data = nullptr;
+		mqtt_message_clear(&message, 0);
+	}
+};
+
+void REGISTER_TEST(Mqtt)
+{
+	registerGroup<MqttTest>();
+}
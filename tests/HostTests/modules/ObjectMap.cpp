@@ -1,6 +1,8 @@
 #include <HostTests.h>
 
 #include <Data/ObjectMap.h>
+#include <WHashMap.h>
+#include <Platform/Timers.h>
 
 static unsigned objectCount = 0;
 
@@ -19,6 +21,7 @@ public:
 };
 
 using TestMap = ObjectMap<String, TestClass>;
+using HashedTestMap = ObjectMap<String, TestClass, MapIndex::Hashed>;
 
 class ObjectMapTest : public TestGroup
 {
@@ -89,6 +92,119 @@ public:
 			REQUIRE(map.count() == 0);
 			REQUIRE(objectCount == 0);
 		}
+
+		testHashed();
+		benchmark();
+	}
+
+	void testHashed()
+	{
+		auto key = [](unsigned i) { return "Object " + String(i); };
+
+		TEST_CASE("Hashed ObjectMap")
+		{
+			HashedTestMap map;
+			for(unsigned i = 0; i < 100; ++i) {
+				map[key(i)] = new TestClass;
+			}
+			REQUIRE(map.count() == 100);
+			REQUIRE(objectCount == 100);
+
+			bool ok{true};
+			for(unsigned i = 0; i < 100; ++i) {
+				ok &= (map.indexOf(key(i)) == int(i));
+			}
+			REQUIRE(ok);
+			REQUIRE(!map.contains("Object 100"));
+
+			// Removal re-orders entries
+			delete map.extract(key(5));
+			REQUIRE(map.remove(key(6)));
+			REQUIRE(map.count() == 98);
+			REQUIRE(!map.contains(key(5)));
+			REQUIRE(map.indexOf(key(99)) == 97);
+			while(map.count() > 3) {
+				map.removeAt(0);
+			}
+			REQUIRE(map.indexOf(key(98)) == 1);
+
+			map.clear();
+			REQUIRE(objectCount == 0);
+		}
+
+		TEST_CASE("Hashed HashMap")
+		{
+			HashMap<String, unsigned, MapIndex::Hashed> map;
+			for(unsigned i = 0; i < 600; ++i) {
+				map[key(i)] = i;
+			}
+			REQUIRE(map.count() == 600);
+
+			for(unsigned i = 0; i < 600; i += 2) {
+				map.remove(key(i));
+			}
+			REQUIRE(map.count() == 300);
+
+			bool ok{true};
+			for(unsigned i = 0; i < 600; ++i) {
+				int index = map.indexOf(key(i));
+				ok &= (i & 1) ? (index >= 0 && map.valueAt(index) == i) : (index < 0);
+			}
+			REQUIRE(ok);
+
+			HashMap<int, int, MapIndex::Hashed> intMap;
+			for(int i = 0; i < 20; ++i) {
+				intMap[i * 1000] = i;
+			}
+			REQUIRE(intMap.indexOf(7000) == 7);
+			REQUIRE(intMap.indexOf(7001) < 0);
+		}
+	}
+
+	/*
+	 * Compare lookup time for linear and hashed indices
+	 */
+	void benchmark()
+	{
+		const unsigned sizes[]{8, 64, 512};
+		for(auto size : sizes) {
+			HashMap<String, unsigned> linearMap;
+			HashMap<String, unsigned, MapIndex::Hashed> hashedMap;
+			std::unique_ptr<String[]> keys(new String[size]);
+			for(unsigned i = 0; i < size; ++i) {
+				keys[i] = F("X-Header-") + String(i);
+				linearMap[keys[i]] = i;
+				hashedMap[keys[i]] = i;
+			}
+
+			// Returns average time per lookup in nanoseconds
+			constexpr unsigned lookups{8192};
+			auto measure = [&](auto& map, unsigned& found) -> unsigned {
+				found = 0;
+				ElapseTimer timer;
+				for(unsigned i = 0; i < lookups; ++i) {
+					found += (map.indexOf(keys[i % size]) >= 0);
+				}
+				return uint64_t(timer.elapsedTime().time) * 1000 / lookups;
+			};
+
+			TEST_CASE("Map lookup benchmark")
+			{
+				unsigned linearFound;
+				unsigned hashedFound;
+				auto linearTime = measure(linearMap, linearFound);
+				auto hashedTime = measure(hashedMap, hashedFound);
+				Serial.print(_F("  "));
+				Serial.print(size);
+				Serial.print(_F(" entries: linear "));
+				Serial.print(linearTime);
+				Serial.print(_F("ns, hashed "));
+				Serial.print(hashedTime);
+				Serial.println(_F("ns per lookup"));
+				REQUIRE(linearFound == lookups);
+				REQUIRE(hashedFound == lookups);
+			}
+		}
 	}
 };
 
@@ -1,6 +1,7 @@
 #include <HostTests.h>
 
 #include <driver/SerialBuffer.h>
+#include <Platform/Timers.h>
 
 class SerialTest : public TestGroup
 {
@@ -56,6 +57,110 @@ public:
 			REQUIRE(txbuf.available() == 0);
 			REQUIRE(compareBuffer == readBuffer);
 		}
+
+		TEST_CASE("SerialBuffer spans")
+		{
+			static constexpr size_t BUFSIZE = 16;
+			SerialBuffer buf;
+			buf.resize(BUFSIZE);
+
+			auto span = buf.writeSpan();
+			REQUIRE(span.length() == BUFSIZE - 1);
+			REQUIRE(span.second.length == 0);
+
+			// Move positions close to end so data wraps
+			REQUIRE(buf.write("0123456789", 10) == 10);
+			char tmp[BUFSIZE];
+			REQUIRE(buf.read(tmp, sizeof(tmp)) == 10);
+			REQUIRE(memcmp(tmp, "0123456789", 10) == 0);
+
+			span = buf.writeSpan();
+			REQUIRE(span.first.length == BUFSIZE - 10);
+			REQUIRE(span.second.length == 10 - 1);
+
+			const char* text = "abcdefghijklmnopqrstuvwxyz";
+			REQUIRE(buf.write(text, strlen(text)) == BUFSIZE - 1);
+			REQUIRE(buf.isFull());
+			REQUIRE(buf.write(text, 1) == 0);
+
+			auto rspan = buf.readSpan();
+			REQUIRE(rspan.first.length == BUFSIZE - 10);
+			REQUIRE(rspan.second.length == 10 - 1);
+			REQUIRE(memcmp(rspan.first.data, text, rspan.first.length) == 0);
+			REQUIRE(memcmp(rspan.second.data, text + rspan.first.length, rspan.second.length) == 0);
+
+			buf.skipRead(4);
+			REQUIRE(buf.peekChar() == 'e');
+			REQUIRE(buf.read(tmp, sizeof(tmp)) == BUFSIZE - 1 - 4);
+			REQUIRE(memcmp(tmp, text + 4, BUFSIZE - 1 - 4) == 0);
+			REQUIRE(buf.isEmpty());
+		}
+
+		benchmark();
+	}
+
+	/*
+	 * At 921600 baud a UART moves 92160 bytes/sec. The Host UART server services the port
+	 * every millisecond or so, so transfers around 92 bytes per call.
+	 * Compare the time taken to pass one second of data through a buffer byte-by-byte and in bulk.
+	 */
+	void benchmark()
+	{
+		static constexpr size_t BUFSIZE = 256;
+		static constexpr unsigned bytesPerSec = 921600 / 10;
+		static constexpr unsigned chunkSize = bytesPerSec / 1000;
+
+		SerialBuffer buf;
+		buf.resize(BUFSIZE);
+		char src[chunkSize];
+		char dst[64];
+		for(unsigned i = 0; i < chunkSize; ++i) {
+			src[i] = i;
+		}
+
+		auto printRate = [](const char* tag, const auto& elapsed) {
+			Serial.print(tag);
+			Serial.print(elapsed.toString());
+			Serial.print(_F(" per second of data at 921600 baud, "));
+			Serial.print(elapsed.time == 0 ? 0 : unsigned(uint64_t(bytesPerSec) * 1000000U / elapsed.time));
+			Serial.println(_F(" bytes/sec"));
+		};
+
+		size_t total{0};
+		bool ok{true};
+		ElapseTimer timer;
+		while(total < bytesPerSec) {
+			for(unsigned i = 0; i < chunkSize; ++i) {
+				buf.writeChar(src[i]);
+			}
+			int c;
+			while((c = buf.readChar()) >= 0) {
+				ok &= (c == uint8_t(src[total % chunkSize]));
+				++total;
+			}
+		}
+		auto charTime = timer.elapsedTime();
+
+		size_t bulkTotal{0};
+		timer.start();
+		while(bulkTotal < bytesPerSec) {
+			buf.write(src, chunkSize);
+			size_t n;
+			while((n = buf.read(dst, sizeof(dst))) != 0) {
+				ok &= (dst[0] == src[bulkTotal % chunkSize]);
+				bulkTotal += n;
+			}
+		}
+		auto bulkTime = timer.elapsedTime();
+
+		printRate(_F("Per-byte: "), charTime);
+		printRate(_F("Bulk:     "), bulkTime);
+
+		TEST_CASE("SerialBuffer throughput")
+		{
+			REQUIRE_EQ(total, bulkTotal);
+			REQUIRE(ok);
+		}
 	}
 };
 
@@ -1,6 +1,13 @@
 #include <HostTests.h>
 #include <esp_spi_flash.h>
 
+#if ENABLE_STORAGE_WEAR_STATS
+#include <Storage.h>
+#include <Storage/SpiFlash.h>
+#include <Storage/Debug.h>
+#include <Data/Stream/MemoryDataStream.h>
+#endif
+
 namespace
 {
 String modeToString(SPIFlashMode mode)
@@ -93,7 +100,81 @@ public:
 			Serial.println(sizeStr ?: unk);
 			REQUIRE(modeStr != nullptr && speedStr != nullptr && sizeStr != nullptr);
 		}
+
+#if ENABLE_STORAGE_WEAR_STATS
+		TEST_CASE("Wear statistics")
+		{
+			checkWearStats();
+		}
+#endif
+	}
+
+#if ENABLE_STORAGE_WEAR_STATS
+	/*
+	 * Use the last sector of the SPIFFS partition, restoring its content afterwards
+	 */
+	void checkWearStats()
+	{
+		auto flash = Storage::spiFlash;
+		auto part = Storage::findPartition(F("spiffs0"));
+		CHECK(part && part.getDevice() == flash);
+
+		auto sectorSize = flash->getBlockSize();
+		auto address = part.address() + part.size() - sectorSize;
+		auto sector = address / sectorSize;
+		std::unique_ptr<uint8_t[]> saved(new uint8_t[sectorSize]);
+		CHECK(flash->read(address, saved.get(), sectorSize));
+
+		auto stats = flash->getWearStats();
+		auto eraseCount = flash->getEraseCount(sector);
+
+		uint8_t data[256];
+		for(unsigned i = 0; i < sizeof(data); ++i) {
+			data[i] = i;
+		}
+		REQUIRE(flash->erase_range(address, sectorSize));
+		REQUIRE_EQ(flash->getEraseCount(sector), eraseCount + 1);
+		REQUIRE(flash->write(address, data, sizeof(data)));
+		REQUIRE(flash->write(address, data, sizeof(data)));
+
+		auto& newStats = flash->getWearStats();
+		REQUIRE_EQ(newStats.erases, stats.erases + 1);
+		REQUIRE_EQ(newStats.writes, stats.writes + 2);
+		REQUIRE_EQ(newStats.redundantWrites, stats.redundantWrites + 1);
+
+		flash->setSkipRedundantWrites(true);
+		REQUIRE(flash->write(address, data, sizeof(data)));
+		flash->setSkipRedundantWrites(false);
+		REQUIRE_EQ(newStats.redundantWrites, stats.redundantWrites + 2);
+
+		// Sector contains data so this erase is required, the next one isn't
+		auto redundantErases = newStats.redundantErases;
+		REQUIRE(flash->erase_range(address, sectorSize));
+		REQUIRE_EQ(newStats.redundantErases, redundantErases);
+		REQUIRE(flash->erase_range(address, sectorSize));
+		REQUIRE_EQ(newStats.redundantErases, redundantErases + 1);
+		REQUIRE_EQ(flash->getEraseCount(sector), eraseCount + 3);
+
+		flash->setSkipRedundantErases(true);
+		REQUIRE(flash->erase_range(address, sectorSize));
+		flash->setSkipRedundantErases(false);
+		REQUIRE_EQ(newStats.erases, stats.erases + 4);
+		REQUIRE_EQ(newStats.redundantErases, redundantErases + 2);
+		REQUIRE_EQ(flash->getEraseCount(sector), eraseCount + 3);
+
+		MemoryDataStream mem;
+		REQUIRE(flash->saveWearStats(mem));
+		REQUIRE(flash->loadWearStats(mem));
+		REQUIRE_EQ(flash->getEraseCount(sector), eraseCount + 3);
+		REQUIRE_EQ(newStats.redundantWrites, stats.redundantWrites + 2);
+		REQUIRE_EQ(newStats.redundantErases, redundantErases + 2);
+
+		Storage::Debug::printWearMap(Serial);
+
+		REQUIRE(flash->erase_range(address, sectorSize));
+		REQUIRE(flash->write(address, saved.get(), sectorSize));
 	}
+#endif
 };
 
 void REGISTER_TEST(SpiFlash)
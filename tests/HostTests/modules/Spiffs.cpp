@@ -3,6 +3,83 @@
 
 #ifdef ARCH_HOST
 #include <Storage/FileDevice.h>
+#include <Storage/CacheDevice.h>
+
+namespace
+{
+/*
+ * RAM-backed flash device which counts operations
+ */
+class CountingDevice : public Storage::CustomDevice
+{
+public:
+	CountingDevice(size_t size) : size(size), data(new uint8_t[size])
+	{
+		memset(data.get(), 0xFF, size);
+	}
+
+	String getName() const override
+	{
+		return F("counter");
+	}
+
+	size_t getBlockSize() const override
+	{
+		return 4096;
+	}
+
+	size_t getSize() const override
+	{
+		return size;
+	}
+
+	Type getType() const override
+	{
+		return Type::flash;
+	}
+
+	bool read(uint32_t address, void* dst, size_t len) override
+	{
+		memcpy(dst, &data[address], len);
+		++readCount;
+		bytesRead += len;
+		return true;
+	}
+
+	bool write(uint32_t address, const void* src, size_t len) override
+	{
+		auto buf = static_cast<const uint8_t*>(src);
+		for(unsigned i = 0; i < len; ++i) {
+			data[address + i] &= buf[i];
+		}
+		++writeCount;
+		return true;
+	}
+
+	bool erase_range(uint32_t address, size_t len) override
+	{
+		memset(&data[address], 0xFF, len);
+		++eraseCount;
+		return true;
+	}
+
+	void resetCounters()
+	{
+		readCount = writeCount = eraseCount = 0;
+		bytesRead = 0;
+	}
+
+	unsigned readCount{0};
+	unsigned writeCount{0};
+	unsigned eraseCount{0};
+	size_t bytesRead{0};
+
+private:
+	size_t size;
+	std::unique_ptr<uint8_t[]> data;
+};
+
+} // namespace
 #endif
 
 class SpiffsTest : public TestGroup
@@ -19,6 +96,16 @@ public:
 		{
 			checkSpiffsGen();
 		}
+
+		TEST_CASE("FileStream read-ahead")
+		{
+			checkReadAhead();
+		}
+
+		TEST_CASE("Block cache")
+		{
+			checkCache();
+		}
 #endif
 
 		TEST_CASE("Cycle flash")
@@ -103,6 +190,155 @@ public:
 		delete Storage::findDevice("old");
 	}
 
+	/*
+	 * Serve a file in the same way as TcpConnection, where only part of each block is
+	 * consumed because of limited socket buffer space.
+	 * Report the number of bytes read from the device for each byte served.
+	 */
+	void checkReadAhead()
+	{
+		CountingDevice dev(0x10000);
+		auto part = dev.createPartition(F("counter"), Storage::Partition::SubType::Data::spiffs, 0, dev.getSize());
+		std::unique_ptr<IFS::FileSystem> fs(IFS::createSpiffsFilesystem(part));
+		CHECK(fs);
+		int err = fs->mount();
+		CHECK(err >= 0);
+
+		DEFINE_FSTR_LOCAL(testFile, "readahead");
+		constexpr size_t fileSize{16384};
+		String content;
+		for(unsigned i = 0; i < fileSize; ++i) {
+			content += char(i * 13);
+		}
+		CHECK(fs->setContent(testFile, content) == int(fileSize));
+
+		auto serve = [&](uint16_t readAheadSize) {
+			IFS::FileStream stream(fs.get());
+			stream.setReadAhead(readAheadSize);
+			CHECK(stream.open(testFile));
+			String output;
+			char buffer[1024];
+			unsigned blockCount{0};
+			dev.bytesRead = 0;
+			while(!stream.isFinished()) {
+				auto count = stream.readMemoryBlock(buffer, sizeof(buffer));
+				if(count == 0) {
+					break;
+				}
+				// Socket accepts between 700 and 900 bytes
+				count = std::min(count, uint16_t(700 + (blockCount++ % 3) * 100));
+				output.concat(buffer, count);
+				stream.seek(count);
+			}
+			REQUIRE(output == content);
+			Serial.print(_F("Read-ahead "));
+			Serial.print(readAheadSize);
+			Serial.print(_F(": filesystem bytes per byte served "));
+			Serial.print(float(stream.getBytesRead()) / fileSize, 2);
+			Serial.print(_F(", device "));
+			Serial.println(float(dev.bytesRead) / fileSize, 2);
+			return stream.getBytesRead();
+		};
+
+		auto unbuffered = serve(0);
+		auto buffered = serve(FILESTREAM_READ_AHEAD_SIZE);
+		REQUIRE(buffered < unbuffered);
+	}
+
+	/*
+	 * Run the same workload on a filesystem with and without a block cache.
+	 * Cached content, once flushed, must be readable directly from the device.
+	 */
+	void checkCache()
+	{
+		DEFINE_FSTR_LOCAL(partName, "cached");
+		constexpr unsigned fileCount{8};
+		auto getFileName = [](unsigned i) { return F("file") + String(i); };
+		auto getContent = [](unsigned i) {
+			String s;
+			for(unsigned j = 0; j < 1000 + i * 500; ++j) {
+				s += char('A' + (i + j) % 26);
+			}
+			return s;
+		};
+
+		auto run = [&](Storage::Partition part) {
+			std::unique_ptr<IFS::FileSystem> fs(IFS::createSpiffsFilesystem(part));
+			CHECK(fs);
+			int err = fs->mount();
+			CHECK(err >= 0);
+			for(unsigned i = 0; i < fileCount; ++i) {
+				auto content = getContent(i);
+				CHECK(fs->setContent(getFileName(i), content) == int(content.length()));
+			}
+			for(unsigned pass = 0; pass < 3; ++pass) {
+				for(unsigned i = 0; i < fileCount; ++i) {
+					REQUIRE(fs->getContent(getFileName(i)) == getContent(i));
+				}
+			}
+		};
+
+		auto print = [](const String& tag, CountingDevice& dev) {
+			Serial.print(tag);
+			Serial.print(_F(": reads "));
+			Serial.print(dev.readCount);
+			Serial.print(_F(" ("));
+			Serial.print(dev.bytesRead);
+			Serial.print(_F(" bytes), writes "));
+			Serial.print(dev.writeCount);
+			Serial.print(_F(", erases "));
+			Serial.println(dev.eraseCount);
+		};
+
+		CountingDevice uncachedDev(0x10000);
+		run(uncachedDev.createPartition(partName, Storage::Partition::SubType::Data::spiffs, 0, uncachedDev.getSize()));
+		print(F("Uncached"), uncachedDev);
+
+		CountingDevice dev(0x10000);
+		auto part = dev.createPartition(partName, Storage::Partition::SubType::Data::spiffs, 0, dev.getSize());
+		{
+			Storage::CacheDevice cache(dev);
+			run(cache.createPartition(part));
+			REQUIRE(cache.flush());
+			print(F("Cached"), dev);
+
+			auto& stats = cache.getStats();
+			Serial.print(_F("Cache hits "));
+			Serial.print(stats.hits);
+			Serial.print(_F(", misses "));
+			Serial.print(stats.misses);
+			Serial.print(_F(", read-ahead "));
+			Serial.print(stats.readAheads);
+			Serial.print(_F(", write-backs "));
+			Serial.print(stats.writeBacks);
+			Serial.print(_F(", erases "));
+			Serial.println(stats.erases);
+
+			REQUIRE(dev.readCount < uncachedDev.readCount);
+			REQUIRE(dev.writeCount < uncachedDev.writeCount);
+		}
+
+		// Verify content without the cache
+		std::unique_ptr<IFS::FileSystem> fs(IFS::createSpiffsFilesystem(part));
+		CHECK(fs);
+		int err = fs->mount();
+		CHECK(err >= 0);
+		for(unsigned i = 0; i < fileCount; ++i) {
+			REQUIRE(fs->getContent(getFileName(i)) == getContent(i));
+		}
+
+		// Read-ahead starts only after two consecutive misses
+		{
+			Storage::CacheDevice cache(dev);
+			auto& stats = cache.getStats();
+			uint8_t c;
+			REQUIRE(cache.read(0, &c, 1));
+			REQUIRE(stats.readAheads == 0);
+			REQUIRE(cache.read(dev.getBlockSize(), &c, 1));
+			REQUIRE(stats.readAheads == 1);
+		}
+	}
+
 	IFS::FileSystem* mountSpiffsFromFile(const String& tag, const String& filename)
 	{
 		auto& hfs = IFS::Host::getFileSystem();
@@ -4,8 +4,11 @@
 #include <Data/Stream/LimitedMemoryStream.h>
 #include <Data/Stream/XorOutputStream.h>
 #include <Data/Stream/SharedMemoryStream.h>
+#include <Data/Stream/StreamChain.h>
+#include <Data/Stream/FlashMemoryStream.h>
 #include <Data/WebHelpers/base64.h>
 #include <malloc_count.h>
+#include <Platform/Timers.h>
 
 #ifndef DISABLE_NETWORK
 #include <Data/Stream/ChunkedStream.h>
@@ -25,6 +28,75 @@ public:
 	{
 	}
 
+	static unsigned xorBytes(uint8_t* buf, size_t len, const uint8_t* mask, unsigned maskPos)
+	{
+		for(size_t i = 0; i < len; ++i) {
+			buf[i] ^= mask[maskPos++ % 4];
+		}
+		return maskPos % 4;
+	}
+
+	void testMasking()
+	{
+		const uint8_t mask[4]{0x12, 0x34, 0x56, 0x78};
+		uint8_t buf1[100];
+		uint8_t buf2[100];
+		for(unsigned i = 0; i < sizeof(buf1); ++i) {
+			buf1[i] = buf2[i] = os_random();
+		}
+
+		// Unaligned start and end, split into two calls
+		for(unsigned offset = 0; offset < 8; ++offset) {
+			for(unsigned split = 0; split < 20; ++split) {
+				for(unsigned pos = 0; pos < 4; ++pos) {
+					size_t len = sizeof(buf1) - 8;
+					auto refPos = xorBytes(&buf1[offset], len, mask, pos);
+					auto newPos = memxor_mask(&buf2[offset], split, mask, pos);
+					newPos = memxor_mask(&buf2[offset + split], len - split, mask, newPos);
+					REQUIRE_EQ(newPos, refPos);
+					REQUIRE(memcmp(buf1, buf2, sizeof(buf1)) == 0);
+				}
+			}
+		}
+
+		const size_t frameSizes[]{
+			64,
+			1024,
+#ifdef ARCH_HOST
+			65536,
+#endif
+		};
+		const size_t maxSize = frameSizes[ARRAY_SIZE(frameSizes) - 1];
+		std::unique_ptr<uint8_t[]> data(new uint8_t[maxSize]);
+
+		auto printRate = [](const char* tag, size_t total, uint32_t elapsed) {
+			Serial.print(tag);
+			Serial.print(elapsed == 0 ? 0 : total / elapsed);
+			Serial.print(_F(" MB/s"));
+		};
+
+		for(auto size : frameSizes) {
+			const size_t total = 1024 * 1024;
+			ElapseTimer timer;
+			for(size_t n = 0; n < total; n += size) {
+				xorBytes(data.get(), size, mask, 0);
+			}
+			auto byteTime = timer.elapsedTime();
+
+			timer.start();
+			for(size_t n = 0; n < total; n += size) {
+				memxor_mask(data.get(), size, mask, 0);
+			}
+			auto wordTime = timer.elapsedTime();
+
+			Serial.print(_F("  Frame size "));
+			Serial.print(size);
+			printRate(_F(": bytewise "), total, byteTime.time);
+			printRate(_F(", memxor_mask "), total, wordTime.time);
+			Serial.println();
+		}
+	}
+
 	void execute() override
 	{
 		const FlashString& FS_abstract = Resource::abstract_txt;
@@ -105,6 +177,61 @@ public:
 			REQUIRE(FS_OUTPUT == s);
 		}
 
+		TEST_CASE("ChunkedStream spans")
+		{
+			DEFINE_FSTR_LOCAL(FS_INPUT, "Some test data");
+			DEFINE_FSTR_LOCAL(FS_CHUNK, "e\r\nSome test data\r\n");
+			DEFINE_FSTR_LOCAL(FS_OUTPUT, "e\r\nSome test data\r\n0\r\n\r\n");
+			ChunkedStream chunked(new MemoryDataStream(String(FS_INPUT)));
+			StreamSpan spans[4];
+			auto count = chunked.peekSpans(spans, ARRAY_SIZE(spans));
+			REQUIRE_EQ(count, 3U);
+			String s;
+			for(unsigned i = 0; i < count; ++i) {
+				s.concat(spans[i].data, spans[i].length);
+			}
+			REQUIRE(FS_CHUNK == s);
+
+			MemoryDataStream output;
+			output.copyFrom(&chunked);
+			REQUIRE(output.moveString(s));
+			REQUIRE(FS_OUTPUT == s);
+		}
+
+		TEST_CASE("ChunkedStream peek")
+		{
+			DEFINE_FSTR_LOCAL(FS_INPUT, "Some test data");
+			DEFINE_FSTR_LOCAL(FS_CHUNK, "e\r\nSome test data\r\n");
+			DEFINE_FSTR_LOCAL(FS_OUTPUT, "e\r\nSome test data\r\n5\r\nextra\r\n0\r\n\r\n");
+			auto source = new MemoryDataStream(String(FS_INPUT));
+			ChunkedStream chunked(source);
+
+			auto peek = [&]() {
+				String s;
+				const char* data;
+				size_t len;
+				while((len = chunked.peekMemoryBlock(s.length(), data)) != 0) {
+					s.concat(data, len);
+				}
+				return s;
+			};
+
+			// Chunk content is fixed by the first peek, even if more source data arrives
+			auto s1 = peek();
+			REQUIRE(FS_CHUNK == s1);
+			source->print("extra");
+			REQUIRE(peek() == s1);
+			char buffer[64];
+			auto len = chunked.readMemoryBlock(buffer, sizeof(buffer));
+			REQUIRE(String(buffer, len) == s1);
+
+			MemoryDataStream output;
+			output.copyFrom(&chunked);
+			String s;
+			REQUIRE(output.moveString(s));
+			REQUIRE(FS_OUTPUT == s);
+		}
+
 		TEST_CASE("MultipartStream / MultiStream")
 		{
 			unsigned itemIndex{0};
@@ -134,6 +261,35 @@ public:
 		}
 #endif
 
+		TEST_CASE("peekSpans / getSpans")
+		{
+			StreamChain chain;
+			chain.attachStream(new FlashMemoryStream(FS_abstract));
+			chain.attachStream(new MemoryDataStream(String(template1)));
+			StreamSpan spans[4];
+			char buffer[16];
+			String s;
+			while(!chain.isFinished()) {
+				auto count = chain.getSpans(spans, ARRAY_SIZE(spans), buffer, sizeof(buffer));
+				for(unsigned i = 0; i < count; ++i) {
+					s.concat(spans[i].data, spans[i].length);
+					chain.seek(spans[i].length);
+				}
+			}
+			String expected(FS_abstract);
+			expected += template1;
+			REQUIRE(s == expected);
+
+			// No direct access, so content gets copied
+			uint8_t maskKey[4]{};
+			XorOutputStream xorStream(new FlashMemoryStream(template1), maskKey, sizeof(maskKey));
+			REQUIRE_EQ(xorStream.peekSpans(spans, ARRAY_SIZE(spans)), 0U);
+			auto count = xorStream.getSpans(spans, ARRAY_SIZE(spans), buffer, sizeof(buffer));
+			REQUIRE_EQ(count, 1U);
+			REQUIRE(spans[0].data == buffer);
+			REQUIRE(String(spans[0].data, spans[0].length) == String(template1).substring(0, sizeof(buffer)));
+		}
+
 		TEST_CASE("XorOutputStream")
 		{
 			auto mem = new MemoryDataStream();
@@ -169,6 +325,11 @@ public:
 			debug_hex(DBG, "Text", unmaskedString.c_str(), unmaskedString.length());
 		}
 
+		TEST_CASE("memxor_mask")
+		{
+			testMasking();
+		}
+
 		{
 			// STL may perform one-time memory allocation for mutexes, etc.
 			std::shared_ptr<const char> data(new char[18]);
@@ -39,6 +39,31 @@ public:
 			system_soft_wdt_feed();
 		}
 
+#ifdef ARCH_HOST
+		TEST_CASE("Task queue stats")
+		{
+			SystemClass::TaskQueueStats before;
+			REQUIRE(System.getTaskQueueStats(before));
+
+			// Fill the queue
+			queued = executed = 0;
+			while(System.queueCallback(taskCallback, uintptr_t(this))) {
+				++queued;
+			}
+
+			SystemClass::TaskQueueStats stats;
+			REQUIRE(System.getTaskQueueStats(stats));
+			debug_i("Queued %u tasks, high water %u, dropped %u", queued, stats.highWater, stats.dropped);
+			REQUIRE(queued != 0);
+			REQUIRE(stats.count >= queued);
+			REQUIRE(stats.highWater >= queued);
+			REQUIRE_EQ(stats.dropped, before.dropped + 1);
+		}
+
+		// Complete once queue has drained
+		pending();
+#endif
+
 #ifndef ARCH_HOST
 		TEST_CASE("System restart")
 		{
@@ -70,6 +95,18 @@ public:
 		}
 #endif
 	}
+
+private:
+	static void taskCallback(uint32_t param)
+	{
+		auto self = reinterpret_cast<SystemTest*>(param);
+		if(++self->executed == self->queued) {
+			self->complete();
+		}
+	}
+
+	unsigned queued{0};
+	unsigned executed{0};
 };
 
 void REGISTER_TEST(System)
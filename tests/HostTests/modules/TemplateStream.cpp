@@ -3,7 +3,9 @@
 #include <Data/Stream/MemoryDataStream.h>
 #include <Data/Stream/LimitedMemoryStream.h>
 #include <Data/Stream/SectionTemplate.h>
+#include <Data/Stream/CompiledTemplateStream.h>
 #include <Data/CsvReader.h>
+#include <Platform/Timers.h>
 
 #ifdef ARCH_HOST
 #include <IFS/Host/FileSystem.h>
@@ -23,6 +25,11 @@ DEFINE_FSTR_LOCAL(template3_1, "<html><head><title>Document Title</title><style>
 DEFINE_FSTR_LOCAL(template4, "{\"value\":12,\"var1\":\"{var1}\"}")
 DEFINE_FSTR_LOCAL(template4_1, "{\"value\":12,\"var1\":\"quoted variable\"}")
 
+DEFINE_FSTR_LOCAL(template5, "{!ifdef:a}a={a}{!else}no a{!endif}, {!ifeq:b:\"x\"}b is x{!endif}, "
+							"{!ifneq:n:5}n!=5{!else}n==5{!endif}{!ifndef:a}{!ifdef:b}, nested{!endif}{!endif}")
+DEFINE_FSTR_LOCAL(template5_1, "a=1, b is x, n==5")
+DEFINE_FSTR_LOCAL(template5_2, "no a, , n!=5, nested")
+
 DEFINE_FSTR_LOCAL(
 	test1_csv, "\"field1\",field2,field3,\"field four\"\n"
 			   "Something \"awry\",\"datavalue 2\",\"where,are,\"\"the,bananas\",sausages abound,\"never surrender\"")
@@ -104,6 +111,8 @@ public:
 			check(tmpl, template4, template4_1);
 		}
 
+		testCompiled();
+
 		TEST_CASE("ut_template1")
 		{
 			SectionTemplate tmpl(new FlashMemoryStream(Resource::ut_template1_in_rst));
@@ -210,10 +219,186 @@ public:
 			CHECK(csv_headings == headings);
 			CHECK(csv_row1 == row1);
 		}
+
+		benchmark();
+	}
+
+	void testCompiled()
+	{
+		auto compile = [](TemplateProgram& program, const FlashString& tmpl) {
+			FSTR::Stream source(tmpl);
+			return program.compile(source);
+		};
+
+		TemplateProgram program;
+
+		TEST_CASE("Compiled template1")
+		{
+			REQUIRE(compile(program, template1));
+			CompiledTemplateStream tmpl(program, new FSTR::Stream(template1));
+			REQUIRE(tmpl.setVar("var3", "[value #3]"));
+			REQUIRE(!tmpl.setVar("var4", "not used"));
+			tmpl.onGetValue([](const char* name) -> String {
+				if(FS("var1") == name) {
+					return F("value #1");
+				}
+				if(FS("var2") == name) {
+					return F("value #2");
+				}
+				return nullptr;
+			});
+
+			check(tmpl, template1, template1_2);
+		}
+
+		TEST_CASE("Compiled template2")
+		{
+			REQUIRE(compile(program, template2));
+			CompiledTemplateStream tmpl(program, new FSTR::Stream(template2));
+			tmpl.onGetValue([&tmpl](const char* name) -> String {
+				if(FS("disable") == name) {
+					tmpl.enableOutput(false);
+					return "";
+				}
+				if(FS("enable") == name) {
+					tmpl.enableOutput(true);
+					return "";
+				}
+				return nullptr;
+			});
+
+			check(tmpl, template2, template2_1);
+		}
+
+		TEST_CASE("Compiled template3, template4")
+		{
+			REQUIRE(compile(program, template3));
+			CompiledTemplateStream tmpl3(program, new FSTR::Stream(template3));
+			tmpl3.setVar("title", "Document Title");
+			check(tmpl3, template3, template3_1);
+
+			REQUIRE(compile(program, template4));
+			CompiledTemplateStream tmpl4(program, new FSTR::Stream(template4));
+			tmpl4.setVar("var1", "quoted variable");
+			check(tmpl4, template4, template4_1);
+		}
+
+		TEST_CASE("Compiled conditionals")
+		{
+			REQUIRE(compile(program, template5));
+			REQUIRE_EQ(program.variableCount(), 3U);
+
+			CompiledTemplateStream tmpl(program, new FSTR::Stream(template5));
+			tmpl.setVar("a", "1");
+			tmpl.setVar("b", "x");
+			tmpl.setVar("n", "5");
+			check(tmpl, template5, template5_1);
+
+			// Program is shared, so may be rendered again with different values
+			CompiledTemplateStream tmpl2(program, new FSTR::Stream(template5));
+			tmpl2.setVar("b", "y");
+			tmpl2.setVar("n", "6");
+			check(tmpl2, template5, template5_2);
+		}
+	}
+
+	/*
+	 * Compare throughput of TemplateStream with CompiledTemplateStream
+	 */
+	void benchmark()
+	{
+		// Typical HTML table with a few substitutions per row
+		String content;
+		content += _F("<html><head><title>{title}</title><style>td { padding: 0 10px; }</style></head>"
+					  "<body><table>\r\n");
+		for(unsigned i = 0; i < 50; ++i) {
+			content += _F("<tr><td class=\"name\">Item ");
+			content += i;
+			content += _F("</td><td>{value}</td><td>{units}</td><td class=\"status\">{status}</td></tr>\r\n");
+		}
+		content += _F("</table><p>{footer}</p></body></html>");
+
+		auto source = [&content]() {
+			return new LimitedMemoryStream(content.begin(), content.length(), content.length(), false);
+		};
+
+		auto setVars = [](auto& tmpl) {
+			tmpl.setVar("title", "Template benchmark");
+			tmpl.setVar("value", "12.5");
+			tmpl.setVar("units", "&deg;C");
+			tmpl.setVar("status", "OK");
+			tmpl.setVar("footer", "Generated by Sming");
+		};
+
+		// Read in the same way as TcpConnection
+		auto render = [](IDataSourceStream& stream, String& output) {
+			char buffer[1024];
+			output.setLength(0);
+			while(!stream.isFinished()) {
+				auto count = stream.readMemoryBlock(buffer, sizeof(buffer));
+				output.concat(buffer, count);
+				stream.seek(count);
+			}
+		};
+
+		auto printRate = [](const char* tag, size_t total, const auto& elapsed) {
+			Serial.print(tag);
+			Serial.print(elapsed.toString());
+			Serial.print(_F(", "));
+			Serial.print(elapsed.time == 0 ? 0 : unsigned(uint64_t(total) * 1000000U / elapsed.time));
+			Serial.println(_F(" bytes/sec"));
+		};
+
+		constexpr unsigned iterations{20};
+		String output1;
+		String output2;
+		output1.reserve(content.length() * 2);
+		output2.reserve(content.length() * 2);
+
+		ElapseTimer timer;
+		for(unsigned i = 0; i < iterations; ++i) {
+			TemplateStream tmpl(source());
+			setVars(tmpl);
+			render(tmpl, output1);
+		}
+		auto templateTime = timer.elapsedTime();
+
+		timer.start();
+		TemplateProgram program;
+		auto src = source();
+		program.compile(*src);
+		delete src;
+		auto compileTime = timer.elapsedTime();
+
+		timer.start();
+		for(unsigned i = 0; i < iterations; ++i) {
+			CompiledTemplateStream tmpl(program, source());
+			setVars(tmpl);
+			render(tmpl, output2);
+		}
+		auto compiledTime = timer.elapsedTime();
+
+		Serial.print(_F("Template of "));
+		Serial.print(content.length());
+		Serial.print(_F(" bytes compiled into "));
+		Serial.print(program.count());
+		Serial.print(_F(" instructions in "));
+		Serial.println(compileTime.toString());
+		auto total = output1.length() * iterations;
+		printRate(_F("  TemplateStream: "), total, templateTime);
+		printRate(_F("  CompiledTemplateStream: "), total, compiledTime);
+
+		TEST_CASE("Compiled template output")
+		{
+			REQUIRE(program.isValid());
+			REQUIRE_EQ(program.variableCount(), 5U);
+			REQUIRE(output1.length() > content.length());
+			REQUIRE(output1 == output2);
+		}
 	}
 
 private:
-	void check(TemplateStream& stream, const FlashString& tmpl, const FlashString& ref)
+	void check(IDataSourceStream& stream, const FlashString& tmpl, const FlashString& ref)
 	{
 		constexpr size_t maxLen{256};
 		String s = stream.readString(maxLen);
@@ -227,7 +412,7 @@ private:
 		return;
 	}
 
-	void check(TemplateStream& tmpl, const FlashString& ref)
+	void check(IDataSourceStream& tmpl, const FlashString& ref)
 	{
 		constexpr size_t bufSize{256};
 		char buf1[bufSize];
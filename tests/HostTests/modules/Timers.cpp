@@ -416,6 +416,114 @@ public:
 	}
 };
 
+#ifdef ARCH_HOST
+/*
+ * Arm, disarm and expire large numbers of timers to check queue performance
+ */
+class TimerWheelTest : public TestGroup
+{
+public:
+	static constexpr unsigned timerCount = 10000;
+
+	TimerWheelTest() : TestGroup(_F("Timer wheel"))
+	{
+	}
+
+	void execute() override
+	{
+		instance = this;
+		timers.reset(new os_timer_t[timerCount]);
+		for(unsigned i = 0; i < timerCount; ++i) {
+			os_timer_setfn(&timers[i], expired, &timers[i]);
+		}
+
+		TEST_CASE("Arm and disarm")
+		{
+			ElapseTimer timer;
+			for(unsigned i = 0; i < timerCount; ++i) {
+				os_timer_arm(&timers[i], 10000 + i % 1000, false);
+			}
+			auto armTime = timer.elapsedTime();
+
+			// All timers active, so each of these disarms then re-arms
+			timer.start();
+			for(unsigned i = 0; i < timerCount; ++i) {
+				os_timer_arm(&timers[i], 20000 + (i * 7) % 1000, false);
+			}
+			auto rearmTime = timer.elapsedTime();
+
+			timer.start();
+			for(unsigned i = 0; i < timerCount; ++i) {
+				os_timer_disarm(&timers[i]);
+			}
+			auto disarmTime = timer.elapsedTime();
+
+			for(unsigned i = 0; i < timerCount; ++i) {
+				REQUIRE(os_timer_expire(&timers[i]) == 0);
+			}
+
+			Serial.print(_F("  "));
+			Serial.print(timerCount);
+			Serial.print(_F(" timers: arm "));
+			Serial.print(armTime.toString());
+			Serial.print(_F(", re-arm "));
+			Serial.print(rearmTime.toString());
+			Serial.print(_F(", disarm "));
+			Serial.println(disarmTime.toString());
+		}
+
+		TEST_CASE("Expiry")
+		{
+			// Spread expiry times over 100ms, with a few long ones to exercise cascading
+			expireCount = 0;
+			earlyCount = 0;
+			for(unsigned i = 0; i < timerCount; ++i) {
+				auto us = (i % 10 == 0) ? 200000 + i * 10 : (i * 37) % 100000;
+				os_timer_arm_us(&timers[i], us, false);
+			}
+			expireTimer.start();
+			pending();
+		}
+	}
+
+	static void expired(void* arg)
+	{
+		auto ptimer = static_cast<os_timer_t*>(arg);
+		if(int(hw_timer2_read() - ptimer->timer_expire) < 0) {
+			++instance->earlyCount;
+		}
+		if(++instance->expireCount == timerCount) {
+			instance->expiryComplete();
+		}
+	}
+
+	void expiryComplete()
+	{
+		auto elapsed = expireTimer.elapsedTime();
+		Serial.print(_F("  "));
+		Serial.print(timerCount);
+		Serial.print(_F(" timers expired in "));
+		Serial.println(elapsed.toString());
+
+		REQUIRE(earlyCount == 0);
+		for(unsigned i = 0; i < timerCount; ++i) {
+			REQUIRE(os_timer_expire(&timers[i]) == 0);
+		}
+		timers.reset();
+		complete();
+	}
+
+private:
+	static TimerWheelTest* instance;
+	std::unique_ptr<os_timer_t[]> timers;
+	ElapseTimer expireTimer;
+	unsigned expireCount{0};
+	unsigned earlyCount{0};
+};
+
+TimerWheelTest* TimerWheelTest::instance;
+#endif
+
 void REGISTER_TEST(Timers)
 {
 	registerGroup<CallbackTimerApiTest<Timer1TestApi>>();
@@ -427,4 +535,7 @@ void REGISTER_TEST(Timers)
 	registerGroup<CallbackTimerSpeedTest<Timer>>();
 
 	registerGroup<CallbackTimerTest>();
+#ifdef ARCH_HOST
+	registerGroup<TimerWheelTest>();
+#endif
 }